@@ -0,0 +1,319 @@
+// Abort-to-handler latency under full sensor load, with and without the abort
+// lane (Linux only).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/benchmarks/DiabloAbortLatencyBenchmark.cpp src/*.cpp -o diablo_abort_bench -lpthread
+//   ./diablo_abort_bench [--shards N] [--boards N] [--senders N] [--aborts N] [--interval-us N]
+// Add -DDIABLO_COMMS_ENABLE_IO_URING to also measure UringTransport.
+//
+// Sender threads play --boards boards blasting full Sensor Data packets over
+// loopback, enough to keep the receive sockets full. Meanwhile one more
+// board sends --aborts ABORT packets, one every --interval-us, each carrying
+// its index in the header timestamp. The time from sendto() to the handler
+// (PacketHandler::on_abort for "bulk", the AbortCallback for "abort_lane") is
+// recorded per abort. Prints one JSON object per configuration:
+//   {"receiver":..., "path":..., "aborts":..., "lost":..., "p50_us":...,
+//    "p90_us":..., "p99_us":..., "max_us":..., "load_packets_per_s":...}
+// lost counts aborts that never reached the handler (dropped by full socket
+// buffers).
+
+#include "DAQv2-Comms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace Diablo;
+
+namespace {
+
+const size_t kSendBatch = 32;
+const uint32_t kAbortBoardIp = 0x7F000201u; // 127.0.2.1, apart from the load boards
+
+struct Options {
+  size_t shards;
+  size_t boards;
+  size_t senders;
+  size_t aborts;
+  unsigned interval_us;
+};
+
+uint64_t monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Send and arrival time of every abort, indexed by header timestamp
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(size_t aborts) : sent_(aborts, 0), received_(aborts, 0) {}
+
+  void mark_sent(uint32_t index) { sent_[index] = monotonic_ns(); }
+
+  void mark_received(uint32_t index) {
+    if (index < received_.size() && received_[index] == 0) received_[index] = monotonic_ns();
+  }
+
+  static void on_abort_event(const AbortEvent &event, void *context) {
+    if (event.header.packet_type == PacketType::ABORT) {
+      static_cast<LatencyRecorder *>(context)->mark_received(event.header.timestamp);
+    }
+  }
+
+  // Only once every sender and receiver thread has been joined
+  void print(const char *receiver, const char *path, double load_packets_per_s) const {
+    std::vector<double> latencies_us;
+    for (size_t i = 0; i < sent_.size(); ++i) {
+      if (received_[i] >= sent_[i] && received_[i] != 0) latencies_us.push_back((received_[i] - sent_[i]) / 1000.0);
+    }
+    std::sort(latencies_us.begin(), latencies_us.end());
+    const size_t n = latencies_us.size();
+    const double p50 = n ? latencies_us[n * 50 / 100] : 0.0;
+    const double p90 = n ? latencies_us[n * 90 / 100] : 0.0;
+    const double p99 = n ? latencies_us[n * 99 / 100] : 0.0;
+    const double max = n ? latencies_us[n - 1] : 0.0;
+    printf("{\"receiver\":\"%s\",\"path\":\"%s\",\"aborts\":%zu,\"lost\":%zu,\"p50_us\":%.1f,\"p90_us\":%.1f,"
+           "\"p99_us\":%.1f,\"max_us\":%.1f,\"load_packets_per_s\":%.1f}\n",
+           receiver, path, sent_.size(), sent_.size() - n, p50, p90, p99, max, load_packets_per_s);
+    fflush(stdout);
+  }
+
+ private:
+  std::vector<uint64_t> sent_;
+  std::vector<uint64_t> received_;
+};
+
+class LoadHandler : public IngestHandler {
+ public:
+  explicit LoadHandler(LatencyRecorder *recorder) : recorder_(recorder), sensor_packets_(0) {}
+
+  void on_sensor_data(const SensorDataView &) override { ++sensor_packets_; }
+  void on_abort(const PacketHeader &header) override { recorder_->mark_received(header.timestamp); }
+
+  uint64_t sensor_packets() const { return sensor_packets_; }
+
+ private:
+  LatencyRecorder *recorder_;
+  uint64_t sensor_packets_;
+};
+
+int bound_socket(uint32_t address_host_order) {
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(address_host_order);
+  if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    perror("bind");
+    exit(1);
+  }
+  return fd;
+}
+
+struct sockaddr_in loopback(uint16_t port) {
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(port);
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return dest;
+}
+
+std::vector<uint8_t> make_sensor_packet() {
+  std::vector<SensorDataChunkCollection> chunks;
+  for (uint8_t c = 0; c < MAX_CHUNKS_PER_PACKET; ++c) {
+    chunks.push_back(SensorDataChunkCollection(c, MAX_SENSORS_PER_BOARD));
+    for (uint8_t s = 0; s < MAX_SENSORS_PER_BOARD; ++s) chunks.back().add_datapoint(s, c * 100u + s);
+  }
+  std::vector<uint8_t> packet(2048);
+  packet.resize(create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, packet.data(), packet.size()));
+  return packet;
+}
+
+// Sends from boards [first, first + count) until stop is set
+void load_main(size_t first, size_t count, uint16_t port, const std::vector<uint8_t> *packet,
+               const std::atomic<bool> *stop) {
+  std::vector<int> sockets;
+  for (size_t b = 0; b < count; ++b) sockets.push_back(bound_socket(0x7F000100u + (first + b) % 254 + 1));
+
+  struct sockaddr_in dest = loopback(port);
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t *>(packet->data());
+  iov.iov_len = packet->size();
+  struct mmsghdr msgs[kSendBatch];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < kSendBatch; ++i) {
+    msgs[i].msg_hdr.msg_name = &dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    msgs[i].msg_hdr.msg_iov = &iov;
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (size_t b = 0; !stop->load(std::memory_order_relaxed); b = (b + 1) % sockets.size()) {
+    sendmmsg(sockets[b], msgs, kSendBatch, 0);
+  }
+  for (size_t b = 0; b < sockets.size(); ++b) close(sockets[b]);
+}
+
+void send_aborts(uint16_t port, const Options &options, LatencyRecorder *recorder) {
+  const int fd = bound_socket(kAbortBoardIp);
+  const struct sockaddr_in dest = loopback(port);
+  uint8_t packet[sizeof(PacketHeader)];
+  for (uint32_t i = 0; i < options.aborts; ++i) {
+    std::this_thread::sleep_for(std::chrono::microseconds(options.interval_us));
+    const size_t size = create_abort_lane_packet(PacketType::ABORT, i, packet, sizeof(packet));
+    recorder->mark_sent(i);
+    sendto(fd, packet, size, 0, reinterpret_cast<const struct sockaddr *>(&dest), sizeof(dest));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Let the last ones land
+  close(fd);
+}
+
+// Runs the load and the aborts against a receiver already listening on port
+void run_load(uint16_t port, const Options &options, LatencyRecorder *recorder) {
+  const std::vector<uint8_t> packet = make_sensor_packet();
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> senders;
+  for (size_t s = 0; s < options.senders; ++s) {
+    const size_t first = s * options.boards / options.senders;
+    const size_t count = (s + 1) * options.boards / options.senders - first;
+    senders.push_back(std::thread(load_main, first, count, port, &packet, &stop));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200)); // Fill the socket buffers first
+  send_aborts(port, options, recorder);
+  stop.store(true);
+  for (size_t s = 0; s < senders.size(); ++s) senders[s].join();
+}
+
+void run_ingest(bool abort_lane, const Options &options) {
+  LatencyRecorder recorder(options.aborts);
+  std::vector<LoadHandler> handlers(options.shards, LoadHandler(&recorder));
+  std::vector<IngestHandler *> shards;
+  for (size_t i = 0; i < options.shards; ++i) shards.push_back(&handlers[i]);
+
+  IngestServer server;
+  IngestOptions ingest_options;
+  ingest_options.bind_address = "127.0.0.1";
+  ingest_options.track_sequences = false; // Every load packet carries the same bytes
+  if (abort_lane) {
+    ingest_options.abort_callback = LatencyRecorder::on_abort_event;
+    ingest_options.abort_context = &recorder;
+  }
+  if (!server.start(ingest_options, shards.data(), shards.size())) {
+    perror("IngestServer::start");
+    exit(1);
+  }
+  if (abort_lane && !server.has_abort_lane()) fprintf(stderr, "no BPF abort lane; shards deliver aborts first\n");
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  run_load(server.port(), options, &recorder);
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  server.stop();
+
+  uint64_t sensor_packets = 0;
+  for (size_t i = 0; i < handlers.size(); ++i) sensor_packets += handlers[i].sensor_packets();
+  recorder.print("ingest", abort_lane ? "abort_lane" : "bulk", sensor_packets / elapsed);
+}
+
+#if defined(DIABLO_COMMS_ENABLE_IO_URING)
+struct UringReceiver {
+  LatencyRecorder *recorder;
+  bool abort_lane;
+  std::atomic<int> port;
+  std::atomic<bool> stop;
+  uint64_t sensor_packets;
+};
+
+// The ring is single-issuer, so the transport is opened on this thread
+void uring_main(UringReceiver *receiver) {
+  UringTransport transport;
+  UringOptions options;
+  options.bind_address = "127.0.0.1";
+  options.track_sequences = false;
+  if (receiver->abort_lane) {
+    options.abort_callback = LatencyRecorder::on_abort_event;
+    options.abort_context = receiver->recorder;
+  }
+  if (!transport.open(options)) {
+    perror("UringTransport::open");
+    exit(1);
+  }
+  receiver->port.store(transport.port());
+
+  LoadHandler handler(receiver->recorder);
+  while (!receiver->stop.load(std::memory_order_relaxed)) transport.poll(handler, 10);
+  receiver->sensor_packets = handler.sensor_packets();
+}
+
+void run_uring(bool abort_lane, const Options &options) {
+  LatencyRecorder recorder(options.aborts);
+  UringReceiver receiver;
+  receiver.recorder = &recorder;
+  receiver.abort_lane = abort_lane;
+  receiver.port.store(0);
+  receiver.stop.store(false);
+  receiver.sensor_packets = 0;
+  std::thread thread(uring_main, &receiver);
+  while (receiver.port.load() == 0) std::this_thread::yield();
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  run_load(static_cast<uint16_t>(receiver.port.load()), options, &recorder);
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  receiver.stop.store(true);
+  thread.join();
+
+  recorder.print("io_uring", abort_lane ? "abort_lane" : "bulk", receiver.sensor_packets / elapsed);
+}
+#endif
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.shards = 1;
+  options.boards = 32;
+  options.senders = 2;
+  options.aborts = 2000;
+  options.interval_us = 1000;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--shards") && i + 1 < argc) {
+      options.shards = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--boards") && i + 1 < argc) {
+      options.boards = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--senders") && i + 1 < argc) {
+      options.senders = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--aborts") && i + 1 < argc) {
+      options.aborts = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--interval-us") && i + 1 < argc) {
+      options.interval_us = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+    } else {
+      fprintf(stderr, "usage: %s [--shards N] [--boards N] [--senders N] [--aborts N] [--interval-us N]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (options.shards == 0 || options.shards > DIABLO_INGEST_MAX_SHARDS || options.boards == 0 ||
+      options.senders == 0 || options.senders > options.boards || options.aborts == 0) {
+    fprintf(stderr, "invalid arguments\n");
+    return 2;
+  }
+
+  run_ingest(false, options);
+  run_ingest(true, options);
+#if defined(DIABLO_COMMS_ENABLE_IO_URING)
+  run_uring(false, options);
+  run_uring(true, options);
+#endif
+  return 0;
+}
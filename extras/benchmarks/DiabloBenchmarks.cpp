@@ -0,0 +1,645 @@
+// Host-side throughput/latency benchmarks for every create_*/parse_* function.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/benchmarks/DiabloBenchmarks.cpp src/*.cpp -o diablo_bench -lpthread
+//   ./diablo_bench [--filter SUBSTRING] [--min-time SECONDS] > bench_output.txt
+//
+// Each benchmark prints one JSON object per line:
+//   {"name":..., "packet_bytes":..., "iterations":..., "packets_per_s":...,
+//    "bytes_per_s":..., "p50_ns":..., "p90_ns":..., "p99_ns":..., "max_ns":...}
+// Latencies are per operation, measured over batches of kBatchSize calls so
+// that clock overhead does not dominate the small packets.
+
+#include "DAQv2-Comms.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+using namespace Diablo;
+
+namespace {
+
+const size_t kBatchSize = 64;
+const size_t kBufferSize = 8192; // Large enough for a maximal ACTUATOR_CONFIG
+
+template <typename T>
+inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Benchmark {
+  std::string name;
+  size_t packet_bytes;
+  std::function<void()> op;
+};
+
+struct Options {
+  const char *filter;
+  double min_time_s;
+};
+
+double percentile(std::vector<double> &sorted, double p) {
+  if (sorted.empty()) return 0.0;
+  const size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+void run_benchmark(const Benchmark &bench, const Options &options) {
+  typedef std::chrono::steady_clock Clock;
+
+  // Warm up caches and branch predictors
+  for (size_t i = 0; i < kBatchSize * 16; ++i) bench.op();
+
+  std::vector<double> per_op_ns;
+  per_op_ns.reserve(1 << 16);
+  const Clock::time_point start = Clock::now();
+  Clock::time_point now = start;
+  const double min_time_ns = options.min_time_s * 1e9;
+  while (std::chrono::duration<double, std::nano>(now - start).count() < min_time_ns) {
+    const Clock::time_point batch_start = Clock::now();
+    for (size_t i = 0; i < kBatchSize; ++i) bench.op();
+    now = Clock::now();
+    per_op_ns.push_back(std::chrono::duration<double, std::nano>(now - batch_start).count() / kBatchSize);
+  }
+
+  const double total_ns = std::chrono::duration<double, std::nano>(now - start).count();
+  const double iterations = static_cast<double>(per_op_ns.size() * kBatchSize);
+  const double packets_per_s = iterations / (total_ns / 1e9);
+  std::sort(per_op_ns.begin(), per_op_ns.end());
+
+  printf("{\"name\":\"%s\",\"packet_bytes\":%zu,\"iterations\":%.0f,"
+         "\"packets_per_s\":%.1f,\"bytes_per_s\":%.1f,"
+         "\"p50_ns\":%.2f,\"p90_ns\":%.2f,\"p99_ns\":%.2f,\"max_ns\":%.2f}\n",
+         bench.name.c_str(), bench.packet_bytes, iterations,
+         packets_per_s, packets_per_s * static_cast<double>(bench.packet_bytes),
+         percentile(per_op_ns, 0.50), percentile(per_op_ns, 0.90),
+         percentile(per_op_ns, 0.99), per_op_ns.back());
+  fflush(stdout);
+}
+
+//------------------------------------------------------------------------------
+// Representative inputs
+//------------------------------------------------------------------------------
+
+struct Fixtures {
+  BoardHeartbeatPacket board_heartbeat;
+  ServerHeartbeatPacket server_heartbeat;
+  EnvironmentalDataPacket environmental;
+  StacklightCommandPacket stacklight;
+  std::vector<uint8_t> sensor_ids;
+  std::vector<ActuatorCommand> actuator_commands_1;
+  std::vector<ActuatorCommand> actuator_commands_max;
+  std::vector<PWMActuatorCommand> pwm_commands_1;
+  std::vector<PWMActuatorCommand> pwm_commands_max;
+  std::vector<SelfTestResult> self_test_results;
+  std::vector<AbortActuatorLocation> abort_actuators_max;
+  std::vector<AbortPTLocation> abort_pts_max;
+
+  Fixtures() {
+    memset(&board_heartbeat, 0xA5, sizeof(board_heartbeat));
+    board_heartbeat.board_id = 7;
+    board_heartbeat.engine_state = EngineState::SAFE;
+    board_heartbeat.board_state = BoardState::ACTIVE;
+    server_heartbeat.engine_state = EngineState::FIRING;
+    server_heartbeat.load_hint = 0;
+    environmental.temperature_c = 21.5f;
+    environmental.pressure_pa = 101325;
+    environmental.humidity_rh = 40.0f;
+    stacklight.red = 1;
+    stacklight.yellow = 0;
+    stacklight.green = 1;
+    stacklight.buzzer = 0;
+
+    for (uint8_t i = 0; i < MAX_SENSORS_PER_BOARD; ++i) sensor_ids.push_back(i);
+    for (size_t i = 0; i < 255; ++i) {
+      ActuatorCommand cmd = {static_cast<uint8_t>(i), static_cast<uint8_t>(i & 1)};
+      actuator_commands_max.push_back(cmd);
+      PWMActuatorCommand pwm = {static_cast<uint8_t>(i), 1000, 0.5f, 50.0f};
+      pwm_commands_max.push_back(pwm);
+      AbortActuatorLocation act = {0x0A000000u + static_cast<uint32_t>(i), static_cast<uint8_t>(i), 1, 0};
+      abort_actuators_max.push_back(act);
+      AbortPTLocation pt = {0x0A000000u + static_cast<uint32_t>(i), static_cast<uint8_t>(i % MAX_SENSORS_PER_BOARD),
+                            1000000u + static_cast<uint32_t>(i)};
+      abort_pts_max.push_back(pt);
+    }
+    actuator_commands_1.assign(actuator_commands_max.begin(), actuator_commands_max.begin() + 1);
+    pwm_commands_1.assign(pwm_commands_max.begin(), pwm_commands_max.begin() + 1);
+    for (uint8_t i = 0; i < MAX_SENSORS_PER_BOARD; ++i) {
+      SelfTestResult r = {i, 1};
+      self_test_results.push_back(r);
+    }
+  }
+};
+
+// Slowly drifting ADC values, like a quiet channel between samples.
+std::vector<SensorDataChunkCollection> make_chunks(size_t num_chunks, uint8_t num_sensors) {
+  std::vector<SensorDataChunkCollection> chunks;
+  uint32_t value = 8000000;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    chunks.push_back(SensorDataChunkCollection(static_cast<uint32_t>(1000 + c), num_sensors));
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      value += static_cast<uint32_t>((c * 7 + s * 3) % 9) - 4u;
+      chunks.back().add_datapoint(s, value + s * 1000u);
+    }
+  }
+  return chunks;
+}
+
+struct Packet {
+  std::vector<uint8_t> bytes;
+};
+
+Packet make_packet(const std::function<size_t(uint8_t *, size_t)> &create) {
+  Packet p;
+  p.bytes.resize(kBufferSize);
+  p.bytes.resize(create(p.bytes.data(), p.bytes.size()));
+  if (p.bytes.empty()) {
+    fprintf(stderr, "fixture packet creation failed\n");
+    exit(1);
+  }
+  return p;
+}
+
+//------------------------------------------------------------------------------
+// Registration
+//------------------------------------------------------------------------------
+
+void add_parse_only(std::vector<Benchmark> &benches, const std::string &name, const Packet &packet,
+                    const std::function<bool(const uint8_t *, size_t)> &parse) {
+  Benchmark p;
+  p.name = name;
+  p.packet_bytes = packet.bytes.size();
+  std::shared_ptr<std::vector<uint8_t> > in(new std::vector<uint8_t>(packet.bytes));
+  p.op = [parse, in]() {
+    const bool ok = parse(in->data(), in->size());
+    do_not_optimize(ok);
+  };
+  benches.push_back(p);
+}
+
+// Adds a create benchmark and the matching parse benchmark for the packet it
+// produces. parse receives the serialized packet bytes.
+void add_pair(std::vector<Benchmark> &benches, const std::string &name,
+              const std::function<size_t(uint8_t *, size_t)> &create,
+              const std::function<bool(const uint8_t *, size_t)> &parse) {
+  const Packet packet = make_packet(create);
+  std::shared_ptr<std::vector<uint8_t> > out(new std::vector<uint8_t>(kBufferSize));
+
+  Benchmark c;
+  c.name = "create_" + name;
+  c.packet_bytes = packet.bytes.size();
+  c.op = [create, out]() { do_not_optimize(create(out->data(), out->size())); };
+  benches.push_back(c);
+
+  add_parse_only(benches, "parse_" + name, packet, parse);
+}
+
+std::vector<Benchmark> register_benchmarks(const Fixtures &f) {
+  std::vector<Benchmark> benches;
+  const Fixtures *fx = &f;
+
+  add_pair(benches, "board_heartbeat_packet",
+           [fx](uint8_t *buf, size_t size) { return create_board_heartbeat_packet(fx->board_heartbeat, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             PacketHeader h;
+             BoardHeartbeatPacket d;
+             return parse_board_heartbeat_packet(buf, size, h, d);
+           });
+
+  add_pair(benches, "server_heartbeat_packet",
+           [fx](uint8_t *buf, size_t size) { return create_server_heartbeat_packet(fx->server_heartbeat, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             PacketHeader h;
+             ServerHeartbeatPacket d;
+             return parse_server_heartbeat_packet(buf, size, h, d);
+           });
+
+  const size_t sensor_shapes[][2] = {{1, 1}, {MAX_CHUNKS_PER_PACKET / 2, MAX_SENSORS_PER_BOARD / 2},
+                                     {MAX_CHUNKS_PER_PACKET, MAX_SENSORS_PER_BOARD}};
+  for (size_t i = 0; i < sizeof(sensor_shapes) / sizeof(sensor_shapes[0]); ++i) {
+    const size_t num_chunks = sensor_shapes[i][0];
+    const uint8_t num_sensors = static_cast<uint8_t>(sensor_shapes[i][1]);
+    std::shared_ptr<std::vector<SensorDataChunkCollection> > chunks(
+        new std::vector<SensorDataChunkCollection>(make_chunks(num_chunks, num_sensors)));
+    char shape[32];
+    snprintf(shape, sizeof(shape), "_%zux%u", num_chunks, static_cast<unsigned>(num_sensors));
+
+    add_pair(benches, std::string("sensor_data_packet") + shape,
+             [chunks, num_sensors](uint8_t *buf, size_t size) {
+               return create_sensor_data_packet(*chunks, num_sensors, 1, buf, size);
+             },
+             [](const uint8_t *buf, size_t size) {
+               static std::vector<SensorDataChunkCollection> out;
+               PacketHeader h;
+               return parse_sensor_data_packet(buf, size, h, out);
+             });
+
+    const Packet raw = make_packet([chunks, num_sensors](uint8_t *buf, size_t size) {
+      return create_sensor_data_packet(*chunks, num_sensors, 1, buf, size);
+    });
+    add_parse_only(benches, std::string("parse_sensor_data_view") + shape, raw,
+                   [](const uint8_t *buf, size_t size) {
+                     SensorDataView view;
+                     if (!parse_sensor_data_view(buf, size, view)) return false;
+                     uint32_t sum = 0;
+                     for (uint8_t c = 0; c < view.num_chunks(); ++c) {
+                       const SensorDataChunkView chunk = view.chunk(c);
+                       for (uint8_t s = 0; s < view.num_sensors(); ++s) sum += chunk[s].data;
+                     }
+                     do_not_optimize(sum);
+                     return true;
+                   });
+    add_parse_only(benches, std::string("decode_sensor_data_columns") + shape, raw,
+                   [](const uint8_t *buf, size_t size) {
+                     static uint32_t ts[MAX_CHUNKS_PER_PACKET];
+                     static uint32_t values[MAX_SENSORS_PER_BOARD * MAX_CHUNKS_PER_PACKET];
+                     SensorDataView view;
+                     SensorDataColumns columns;
+                     columns.attach(ts, values, MAX_CHUNKS_PER_PACKET);
+                     return parse_sensor_data_view(buf, size, view) && decode_sensor_data_columns(view, columns);
+                   });
+
+    add_pair(benches, std::string("compressed_sensor_data_packet") + shape,
+             [chunks, num_sensors](uint8_t *buf, size_t size) {
+               return create_compressed_sensor_data_packet(*chunks, num_sensors, 1, buf, size);
+             },
+             [](const uint8_t *buf, size_t size) {
+               static std::vector<SensorDataChunkCollection> out;
+               PacketHeader h;
+               return parse_compressed_sensor_data_packet(buf, size, h, out);
+             });
+  }
+
+  add_pair(benches, "abort_done_packet",
+           [](uint8_t *buf, size_t size) { return create_abort_done_packet(1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             PacketHeader h;
+             return parse_abort_done_packet(buf, size, h);
+           });
+
+  add_pair(benches, "sensor_config_packet",
+           [fx](uint8_t *buf, size_t size) {
+             return create_sensor_config_packet(fx->sensor_ids, 3, true, 0x0A000001u, 1, 1, buf, size);
+           },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<uint8_t> ids;
+             PacketHeader h;
+             uint8_t ref, serial;
+             bool abort;
+             uint32_t ip;
+             return parse_sensor_config_packet(buf, size, h, ids, ref, abort, ip, serial);
+           });
+
+  add_pair(benches, "actuator_command_packet_1",
+           [fx](uint8_t *buf, size_t size) { return create_actuator_command_packet(fx->actuator_commands_1, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<ActuatorCommand> out;
+             PacketHeader h;
+             return parse_actuator_command_packet(buf, size, h, out);
+           });
+  add_pair(benches, "actuator_command_packet_255",
+           [fx](uint8_t *buf, size_t size) { return create_actuator_command_packet(fx->actuator_commands_max, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<ActuatorCommand> out;
+             PacketHeader h;
+             return parse_actuator_command_packet(buf, size, h, out);
+           });
+
+  add_pair(benches, "pwm_actuator_packet_1",
+           [fx](uint8_t *buf, size_t size) { return create_pwm_actuator_packet(fx->pwm_commands_1, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<PWMActuatorCommand> out;
+             PacketHeader h;
+             return parse_pwm_actuator_packet(buf, size, h, out);
+           });
+  add_pair(benches, "pwm_actuator_packet_255",
+           [fx](uint8_t *buf, size_t size) { return create_pwm_actuator_packet(fx->pwm_commands_max, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<PWMActuatorCommand> out;
+             PacketHeader h;
+             return parse_pwm_actuator_packet(buf, size, h, out);
+           });
+
+  add_pair(benches, "self_test_packet",
+           [fx](uint8_t *buf, size_t size) { return create_self_test_packet(1, fx->self_test_results, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<SelfTestResult> out;
+             PacketHeader h;
+             uint8_t adc_good;
+             return parse_self_test_packet(buf, size, h, adc_good, out);
+           });
+
+  add_pair(benches, "environmental_data_packet",
+           [fx](uint8_t *buf, size_t size) {
+             return create_environmental_data_packet(fx->environmental.temperature_c, fx->environmental.pressure_pa,
+                                                     fx->environmental.humidity_rh, 1, buf, size);
+           },
+           [](const uint8_t *buf, size_t size) {
+             PacketHeader h;
+             EnvironmentalDataPacket d;
+             return parse_environmental_data_packet(buf, size, h, d);
+           });
+
+  add_pair(benches, "stacklight_command_packet",
+           [fx](uint8_t *buf, size_t size) { return create_stacklight_command_packet(fx->stacklight, 1, buf, size); },
+           [](const uint8_t *buf, size_t size) {
+             PacketHeader h;
+             StacklightCommandPacket d;
+             return parse_stacklight_command_packet(buf, size, h, d);
+           });
+
+  add_pair(benches, "actuator_config_packet_max",
+           [fx](uint8_t *buf, size_t size) {
+             return create_actuator_config_packet(1, fx->abort_actuators_max, fx->abort_pts_max, 1, 1, buf, size);
+           },
+           [](const uint8_t *buf, size_t size) {
+             static std::vector<AbortActuatorLocation> actuators;
+             static std::vector<AbortPTLocation> pts;
+             PacketHeader h;
+             uint8_t is_controller, serial;
+             return parse_actuator_config_packet(buf, size, h, is_controller, actuators, pts, serial);
+           });
+
+  {
+    // Every datapoint of a full sensor packet checked against 255 abort PTs
+    const std::vector<SensorDataChunkCollection> chunks = make_chunks(MAX_CHUNKS_PER_PACKET, MAX_SENSORS_PER_BOARD);
+    const Packet packet = make_packet([&chunks](uint8_t *buf, size_t size) {
+      return create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, buf, size);
+    });
+    const uint32_t board_ip = fx->abort_pts_max.back().ip_address;
+    add_parse_only(benches, "abort_threshold_linear_scan", packet, [fx, board_ip](const uint8_t *buf, size_t size) {
+      SensorDataView view;
+      if (!view.reset(PacketHeader(), buf + sizeof(PacketHeader), size - sizeof(PacketHeader))) return false;
+      size_t exceeded = 0;
+      for (size_t c = 0; c < view.num_chunks(); ++c) {
+        for (size_t i = 0; i < view.num_sensors(); ++i) {
+          const SensorDatapoint dp = view.chunk(c)[i];
+          for (size_t p = 0; p < fx->abort_pts_max.size(); ++p) {
+            const AbortPTLocation &pt = fx->abort_pts_max[p];
+            if (pt.ip_address == board_ip && pt.sensor_id == dp.sensor_id) {
+              exceeded += dp.data > pt.pressure_threshold_adc;
+              break;
+            }
+          }
+        }
+      }
+      do_not_optimize(exceeded);
+      return true;
+    });
+    std::shared_ptr<AbortThresholdTable> table(new AbortThresholdTable());
+    table->build(fx->abort_actuators_max, fx->abort_pts_max);
+    add_parse_only(benches, "abort_threshold_table", packet, [table, board_ip](const uint8_t *buf, size_t size) {
+      SensorDataView view;
+      if (!view.reset(PacketHeader(), buf + sizeof(PacketHeader), size - sizeof(PacketHeader))) return false;
+      size_t exceeded = 0;
+      for (size_t c = 0; c < view.num_chunks(); ++c) {
+        for (size_t i = 0; i < view.num_sensors(); ++i) {
+          const SensorDatapoint dp = view.chunk(c)[i];
+          exceeded += table->exceeds_threshold(board_ip, dp.sensor_id, dp.data);
+        }
+      }
+      do_not_optimize(exceeded);
+      return true;
+    });
+
+    // The same check as one pass over the packet with a per-slot threshold vector
+    std::shared_ptr<AbortThresholdVector> vector(new AbortThresholdVector());
+    {
+      SensorDataView view;
+      view.reset(PacketHeader(), packet.bytes.data() + sizeof(PacketHeader), packet.bytes.size() - sizeof(PacketHeader));
+      vector->build(*table, board_ip, view.chunk(0));
+    }
+    for (int scalar = 0; scalar < 2; ++scalar) {
+      add_parse_only(benches, scalar ? "abort_threshold_vector_scalar" : "abort_threshold_vector", packet,
+                     [vector, scalar](const uint8_t *buf, size_t size) {
+                       uint32_t exceeded;
+                       const bool ok = check_abort_thresholds(buf, size, *vector, exceeded, scalar != 0);
+                       do_not_optimize(exceeded);
+                       return ok;
+                     });
+    }
+
+    // The bare kernel over the same packet, without the parse and layout check
+    for (int scalar = 0; scalar < 2; ++scalar) {
+      add_parse_only(benches, scalar ? "abort_threshold_kernel_scalar" : "abort_threshold_kernel", packet,
+                     [vector, scalar](const uint8_t *buf, size_t) {
+                       const size_t stride = SensorDataView::chunk_size(MAX_SENSORS_PER_BOARD);
+                       do_not_optimize(exceeded_threshold_slots(
+                           buf + sizeof(PacketHeader) + sizeof(SensorDataPacket) + sizeof(SensorDataChunk) +
+                               offsetof(SensorDatapoint, data),
+                           stride, MAX_CHUNKS_PER_PACKET, MAX_SENSORS_PER_BOARD, vector->thresholds, scalar != 0));
+                       return true;
+                     });
+    }
+
+    // Wider boards: 32 slots x 64 chunks of raw chunk bytes
+    const size_t wide_stride = SensorDataView::chunk_size(DIABLO_THRESHOLD_MAX_SLOTS);
+    std::shared_ptr<std::vector<uint8_t> > wide(new std::vector<uint8_t>(64 * wide_stride));
+    for (size_t i = 0; i < wide->size(); ++i) (*wide)[i] = static_cast<uint8_t>(i * 7);
+    std::shared_ptr<std::vector<uint32_t> > wide_thresholds(
+        new std::vector<uint32_t>(DIABLO_THRESHOLD_MAX_SLOTS, 0xF0000000u));
+    for (int scalar = 0; scalar < 2; ++scalar) {
+      add_parse_only(benches, scalar ? "abort_threshold_vector_32x64_scalar" : "abort_threshold_vector_32x64",
+                     packet, [wide, wide_stride, wide_thresholds, scalar](const uint8_t *, size_t) {
+                       do_not_optimize(exceeded_threshold_slots(
+                           wide->data() + sizeof(SensorDataChunk) + offsetof(SensorDatapoint, data), wide_stride, 64,
+                           DIABLO_THRESHOLD_MAX_SLOTS, wide_thresholds->data(), scalar != 0));
+                       return true;
+                     });
+    }
+  }
+
+  {
+    // Dispatch of a full sensor packet through the PacketType table
+    const std::vector<SensorDataChunkCollection> chunks = make_chunks(MAX_CHUNKS_PER_PACKET, MAX_SENSORS_PER_BOARD);
+    const Packet packet = make_packet([&chunks](uint8_t *buf, size_t size) {
+      return create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, buf, size);
+    });
+    add_parse_only(benches, "dispatch_packet_sensor_data", packet, [](const uint8_t *buf, size_t size) {
+      static PacketHandler handler;
+      return dispatch_packet(buf, size, handler) == DispatchResult::OK;
+    });
+
+    // Same packet with a CRC-32C trailer, to show the verification cost
+    const Packet checked = make_packet([&chunks](uint8_t *buf, size_t size) {
+      const size_t n = create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, buf, size);
+      return append_crc_trailer(buf, n, size);
+    });
+    add_parse_only(benches, "dispatch_packet_sensor_data_crc", checked, [](const uint8_t *buf, size_t size) {
+      static PacketHandler handler;
+      return dispatch_packet(buf, size, handler) == DispatchResult::OK;
+    });
+    // Decode into SPSC ring slots, then drain them as a consumer would
+    add_parse_only(benches, "decode_sensor_data_into_ring", packet, [](const uint8_t *buf, size_t size) {
+      static SpscRing<FixedSensorDataChunkCollection, 64> ring;
+      SensorDataView view;
+      if (!parse_sensor_data_view(buf, size, view) || !decode_sensor_data_into_ring(view, ring)) return false;
+      const size_t n = ring.read_available();
+      do_not_optimize(ring.read_slot(n - 1).timestamp);
+      ring.release(n);
+      return true;
+    });
+
+    // 100 full chunks split across MAX_PACKET_SIZE packets
+    std::shared_ptr<std::vector<SensorDataChunkCollection> > many(
+        new std::vector<SensorDataChunkCollection>(make_chunks(100, MAX_SENSORS_PER_BOARD)));
+    add_parse_only(benches, "pack_sensor_data_packets_100x10", packet, [many](const uint8_t *, size_t) {
+      size_t bytes = 0;
+      const size_t packets = pack_sensor_data_packets(
+          *many, MAX_SENSORS_PER_BOARD, 1, MAX_PACKET_SIZE,
+          [](const uint8_t *, size_t size, void *context) { *static_cast<size_t *>(context) += size; }, &bytes);
+      do_not_optimize(bytes);
+      return packets != 0;
+    });
+
+    // One packet's worth of samples through the MPSC queue into chunks
+    add_parse_only(benches, "mpsc_queue_push_drain", packet, [](const uint8_t *, size_t) {
+      static MpscQueue<SensorSample, 128> queue;
+      static FixedSensorDataChunkList chunks;
+      for (uint32_t c = 0; c < MAX_CHUNKS_PER_PACKET; ++c) {
+        for (uint8_t s = 0; s < MAX_SENSORS_PER_BOARD; ++s) {
+          SensorSample sample;
+          sample.timestamp = c;
+          sample.datapoint.sensor_id = s;
+          sample.datapoint.data = c * s;
+          queue.try_push(sample);
+        }
+      }
+      chunks.clear();
+      return drain_sensor_samples(queue, chunks, MAX_SENSORS_PER_BOARD) == MAX_CHUNKS_PER_PACKET * MAX_SENSORS_PER_BOARD;
+    });
+
+    // Duplicate of an already-seen sequenced packet: dropped before decode
+    const Packet sequenced = make_packet([&chunks](uint8_t *buf, size_t size) {
+      const size_t n = create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, buf, size);
+      return append_sequence_trailer(buf, n, size, 0);
+    });
+    add_parse_only(benches, "dispatch_packet_sensor_data_duplicate", sequenced, [](const uint8_t *buf, size_t size) {
+      static PacketHandler handler;
+      static BoardSequenceTracker tracker;
+      return dispatch_packet(buf, size, handler, tracker) != DispatchResult::MALFORMED;
+    });
+    add_parse_only(benches, "sequence_window_check", sequenced, [](const uint8_t *, size_t) {
+      static SequenceWindow window;
+      static uint16_t sequence = 0;
+      return window.check(sequence++) == SequenceResult::IN_ORDER;
+    });
+    add_parse_only(benches, "crc32c_portable", packet, [](const uint8_t *buf, size_t size) {
+      do_not_optimize(crc32c_portable(buf, size));
+      return true;
+    });
+    add_parse_only(benches, "crc32c", packet, [](const uint8_t *buf, size_t size) {
+      do_not_optimize(crc32c(buf, size));
+      return true;
+    });
+  }
+
+#if defined(__linux__)
+  {
+    // Capture files: append full sensor packets, then read them back through
+    // the zero-copy reader into dispatch_packet()
+    const std::vector<SensorDataChunkCollection> chunks = make_chunks(MAX_CHUNKS_PER_PACKET, MAX_SENSORS_PER_BOARD);
+    const Packet packet = make_packet([&chunks](uint8_t *buf, size_t size) {
+      return create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, buf, size);
+    });
+    static const char kCapturePath[] = "/tmp/diablo_bench_capture.cap";
+
+    add_parse_only(benches, "capture_writer_append", packet, [](const uint8_t *buf, size_t size) {
+      static CaptureWriter writer;
+      if (!writer.is_open() || writer.data_end() > (256u << 20)) {
+        // Start over rather than fill the disk; the open fd keeps the file alive
+        writer.open(kCapturePath);
+        unlink(kCapturePath);
+      }
+      return writer.append(buf, size, 0x0A000001u, 0);
+    });
+
+    std::shared_ptr<CaptureReader> reader(new CaptureReader());
+    {
+      CaptureWriter writer;
+      writer.open(kCapturePath);
+      for (uint32_t i = 0; i < 100000; ++i) writer.append(packet.bytes.data(), packet.bytes.size(), 0x0A000001u, i);
+      writer.close();
+      reader->open(kCapturePath);
+      unlink(kCapturePath); // The reader's mapping keeps the data alive
+    }
+    add_parse_only(benches, "capture_reader_next_dispatch", packet, [reader](const uint8_t *, size_t) {
+      static PacketHandler handler;
+      CaptureRecord record;
+      if (!reader->next(record)) {
+        reader->rewind();
+        if (!reader->next(record)) return false;
+      }
+      return dispatch_packet(record.data, record.size, handler) == DispatchResult::OK;
+    });
+
+    // Offline decode of a whole 10-board capture per op (2000 packets, 200k
+    // rows in 128 KiB segments), single-threaded and on every core
+    std::shared_ptr<CaptureReader> boards(new CaptureReader());
+    {
+      CaptureWriter writer;
+      writer.open(kCapturePath);
+      for (uint32_t i = 0; i < 2000; ++i) {
+        writer.append(packet.bytes.data(), packet.bytes.size(), 0x0A000001u + i % 10, i);
+      }
+      writer.close();
+      boards->open(kCapturePath);
+      unlink(kCapturePath);
+    }
+    for (unsigned threads = 1; threads <= 2; ++threads) {
+      ParallelDecodeOptions decode_options;
+      decode_options.num_threads = threads == 1 ? 1 : 0;
+      decode_options.segment_bytes = 128u << 10;
+      add_parse_only(benches, threads == 1 ? "decode_capture_parallel_1thread" : "decode_capture_parallel",
+                     packet, [boards, decode_options](const uint8_t *, size_t) {
+                       struct Sink {
+                         static void rows(const SensorRow *, size_t count, void *context) {
+                           *static_cast<size_t *>(context) += count;
+                         }
+                       };
+                       size_t rows = 0;
+                       return decode_capture_parallel(*boards, decode_options, Sink::rows, &rows) && rows > 0;
+                     });
+    }
+  }
+#endif
+
+  return benches;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.filter = nullptr;
+  options.min_time_s = 0.2;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+      options.min_time_s = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--filter SUBSTRING] [--min-time SECONDS]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  const Fixtures fixtures;
+  const std::vector<Benchmark> benches = register_benchmarks(fixtures);
+  for (size_t i = 0; i < benches.size(); ++i) {
+    if (options.filter && benches[i].name.find(options.filter) == std::string::npos) continue;
+    run_benchmark(benches[i], options);
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+// Loopback throughput of IngestServer as shards (cores) are added (Linux only).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/benchmarks/DiabloIngestBenchmark.cpp src/*.cpp -o diablo_ingest_bench -lpthread
+//   ./diablo_ingest_bench [--max-shards N] [--boards N] [--senders N] [--seconds S]
+//
+// Sender threads play --boards boards, each from its own loopback address
+// (127.0.1.x), sending full Sensor Data packets with sendmmsg() as fast as
+// they can. For every shard count from 1 to --max-shards it prints one JSON
+// object per line:
+//   {"shards":..., "boards":..., "senders":..., "sharded_by_ip":...,
+//    "sent_per_s":..., "packets_per_s":..., "bytes_per_s":..., "dropped":...}
+// packets_per_s counts datagrams the shards received and dispatched; the
+// difference to sent_per_s was dropped by full socket buffers.
+
+#include "DAQv2-Comms.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Diablo;
+
+namespace {
+
+const size_t kSendBatch = 32;
+
+struct Options {
+  size_t max_shards;
+  size_t boards;
+  size_t senders;
+  double seconds;
+};
+
+class CountingHandler : public IngestHandler {
+ public:
+  CountingHandler() : datapoints_(0) {}
+
+  void on_sensor_data(const SensorDataView &view) override {
+    for (size_t i = 0; i < view.num_chunks(); ++i) datapoints_ += view.chunk(i).size();
+  }
+
+  uint64_t datapoints() const { return datapoints_; }
+
+ private:
+  uint64_t datapoints_;
+};
+
+std::vector<uint8_t> make_sensor_packet() {
+  std::vector<SensorDataChunkCollection> chunks;
+  for (uint8_t c = 0; c < MAX_CHUNKS_PER_PACKET; ++c) {
+    chunks.push_back(SensorDataChunkCollection(c, MAX_SENSORS_PER_BOARD));
+    for (uint8_t s = 0; s < MAX_SENSORS_PER_BOARD; ++s) chunks.back().add_datapoint(s, c * 100u + s);
+  }
+  std::vector<uint8_t> packet(2048);
+  packet.resize(create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, packet.data(), packet.size()));
+  return packet;
+}
+
+// Sends from boards [first, first + count) until stop is set
+void sender_main(size_t first, size_t count, uint16_t port, const std::vector<uint8_t> *packet,
+                 const std::atomic<bool> *stop, std::atomic<uint64_t> *sent) {
+  std::vector<int> sockets;
+  for (size_t b = 0; b < count; ++b) {
+    const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in source;
+    memset(&source, 0, sizeof(source));
+    source.sin_family = AF_INET;
+    source.sin_addr.s_addr = htonl(0x7F000100u + static_cast<uint32_t>(first + b) % 254 + 1);
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&source), sizeof(source)) != 0) {
+      perror("sender bind");
+      exit(1);
+    }
+    sockets.push_back(fd);
+  }
+
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(port);
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t *>(packet->data());
+  iov.iov_len = packet->size();
+  struct mmsghdr msgs[kSendBatch];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < kSendBatch; ++i) {
+    msgs[i].msg_hdr.msg_name = &dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    msgs[i].msg_hdr.msg_iov = &iov;
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  for (size_t b = 0; !stop->load(std::memory_order_relaxed); b = (b + 1) % sockets.size()) {
+    const int rc = sendmmsg(sockets[b], msgs, kSendBatch, 0);
+    if (rc > 0) sent->fetch_add(static_cast<uint64_t>(rc), std::memory_order_relaxed);
+  }
+  for (size_t b = 0; b < sockets.size(); ++b) close(sockets[b]);
+}
+
+void run(size_t num_shards, const Options &options, const std::vector<uint8_t> &packet) {
+  std::vector<CountingHandler> handlers(num_shards);
+  std::vector<IngestHandler *> shards;
+  for (size_t i = 0; i < num_shards; ++i) shards.push_back(&handlers[i]);
+
+  IngestServer server;
+  IngestOptions ingest_options;
+  ingest_options.bind_address = "127.0.0.1";
+  ingest_options.track_sequences = false; // Every packet carries the same bytes
+  if (!server.start(ingest_options, shards.data(), num_shards)) {
+    perror("IngestServer::start");
+    exit(1);
+  }
+
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> sent(0);
+  std::vector<std::thread> senders;
+  for (size_t s = 0; s < options.senders; ++s) {
+    const size_t first = s * options.boards / options.senders;
+    const size_t count = (s + 1) * options.boards / options.senders - first;
+    senders.push_back(std::thread(sender_main, first, count, server.port(), &packet, &stop, &sent));
+  }
+
+  // Let the senders ramp up, then measure
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  const IngestShardStats before = server.total_stats();
+  const uint64_t sent_before = sent.load();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  const IngestShardStats after = server.total_stats();
+  const uint64_t sent_during = sent.load() - sent_before;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const bool sharded_by_ip = server.sharded_by_ip();
+
+  stop.store(true);
+  for (size_t s = 0; s < senders.size(); ++s) senders[s].join();
+  server.stop();
+
+  const uint64_t received = after.datagrams - before.datagrams;
+  printf("{\"shards\":%zu,\"boards\":%zu,\"senders\":%zu,\"sharded_by_ip\":%s,\"sent_per_s\":%.1f,"
+         "\"packets_per_s\":%.1f,\"bytes_per_s\":%.1f,\"dropped\":%llu}\n",
+         num_shards, options.boards, options.senders, sharded_by_ip ? "true" : "false",
+         static_cast<double>(sent_during) / elapsed, static_cast<double>(received) / elapsed,
+         static_cast<double>(after.bytes - before.bytes) / elapsed,
+         static_cast<unsigned long long>(sent_during > received ? sent_during - received : 0));
+  fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.max_shards = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  options.boards = 32;
+  options.senders = 2;
+  options.seconds = 1.0;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--max-shards") && i + 1 < argc) {
+      options.max_shards = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--boards") && i + 1 < argc) {
+      options.boards = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--senders") && i + 1 < argc) {
+      options.senders = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      options.seconds = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--max-shards N] [--boards N] [--senders N] [--seconds S]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (options.max_shards == 0 || options.max_shards > DIABLO_INGEST_MAX_SHARDS || options.boards == 0 ||
+      options.senders == 0 || options.senders > options.boards || options.seconds <= 0) {
+    fprintf(stderr, "invalid arguments\n");
+    return 2;
+  }
+
+  const std::vector<uint8_t> packet = make_sensor_packet();
+  for (size_t shards = 1; shards <= options.max_shards; ++shards) run(shards, options, packet);
+  return 0;
+}
@@ -0,0 +1,177 @@
+// Heartbeat loss detection: LivenessTracker against a periodic rescan of
+// every board.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/benchmarks/DiabloLivenessBenchmark.cpp src/*.cpp -o diablo_liveness_bench -lpthread
+//   ./diablo_liveness_bench [--seconds N] [--heartbeat-ms N] [--scan-ms N]
+//
+// Simulated time, one main-loop iteration per millisecond. Each board sends a
+// heartbeat every --heartbeat-ms (staggered), and a tenth of the boards go
+// silent at random times and come back a few seconds later. "wheel" feeds
+// LivenessTracker; "rescan" keeps a last-heard array and checks every board
+// every --scan-ms. Prints one JSON object per method and board count:
+//   {"method":..., "boards":..., "ns_per_loop":..., "losses":...,
+//    "mean_late_ms":..., "max_late_ms":...}
+// ns_per_loop is the CPU time of one loop iteration (heartbeats + check);
+// late is how long after the loss deadline the loss was noticed.
+
+#include "DAQv2-Comms.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Diablo;
+
+namespace {
+
+const uint32_t kLossTimeoutMs = 500;
+const uint32_t kAbortTimeoutMs = 3000;
+
+struct Options {
+  uint32_t seconds;
+  uint32_t heartbeat_ms;
+  uint32_t scan_ms;
+};
+
+struct Result {
+  double ns_per_loop;
+  size_t losses;
+  double total_late_ms;
+  uint32_t max_late_ms;
+
+  Result() : ns_per_loop(0), losses(0), total_late_ms(0), max_late_ms(0) {}
+
+  void record(uint32_t late_ms) {
+    ++losses;
+    total_late_ms += late_ms;
+    if (late_ms > max_late_ms) max_late_ms = late_ms;
+  }
+};
+
+// Which boards send on each millisecond of the heartbeat period, and when
+// each board is silent: [silent_from, silent_until), or never
+struct Schedule {
+  std::vector<std::vector<uint8_t> > by_phase;
+  std::vector<uint32_t> silent_from;
+  std::vector<uint32_t> silent_until;
+
+  Schedule(size_t boards, const Options &options)
+      : by_phase(options.heartbeat_ms), silent_from(boards, 0), silent_until(boards, 0) {
+    srand(12345);
+    const uint32_t duration = options.seconds * 1000;
+    for (size_t b = 0; b < boards; ++b) {
+      by_phase[static_cast<uint32_t>(rand()) % options.heartbeat_ms].push_back(static_cast<uint8_t>(b));
+      if (b % 10 == 0) {
+        silent_from[b] = 1000 + static_cast<uint32_t>(rand()) % (duration / 2);
+        silent_until[b] = silent_from[b] + 5000;
+      }
+    }
+  }
+
+  const std::vector<uint8_t> &due(uint32_t now_ms) const { return by_phase[now_ms % by_phase.size()]; }
+
+  bool silent(uint8_t board, uint32_t now_ms) const {
+    return now_ms >= silent_from[board] && now_ms < silent_until[board];
+  }
+};
+
+// The wheel reports the deadline itself as time_ms, so lateness is taken
+// from the loop time at which the callback ran
+uint32_t g_loop_ms = 0;
+
+void on_wheel_change(const LivenessEvent &event, void *context) {
+  if (event.state == BoardState::CONNECTION_LOSS_DETECTED) {
+    static_cast<Result *>(context)->record(g_loop_ms - (event.last_heard_ms + kLossTimeoutMs));
+  }
+}
+
+Result run_wheel(const Options &options, const Schedule &schedule) {
+  Result result;
+  LivenessOptions liveness;
+  liveness.loss_timeout_ms = kLossTimeoutMs;
+  liveness.abort_timeout_ms = kAbortTimeoutMs;
+  liveness.callback = on_wheel_change;
+  liveness.context = &result;
+  LivenessTracker tracker(liveness);
+
+  const uint32_t duration = options.seconds * 1000;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t now = 1; now <= duration; ++now) {
+    g_loop_ms = now;
+    const std::vector<uint8_t> &due = schedule.due(now);
+    for (size_t i = 0; i < due.size(); ++i) {
+      if (!schedule.silent(due[i], now)) tracker.heartbeat(due[i], now);
+    }
+    tracker.poll(now);
+  }
+  const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  result.ns_per_loop = elapsed / duration;
+  return result;
+}
+
+Result run_rescan(size_t boards, const Options &options, const Schedule &schedule) {
+  Result result;
+  std::vector<uint32_t> last_heard(boards, 0);
+  std::vector<BoardState> state(boards, BoardState::SETUP);
+
+  const uint32_t duration = options.seconds * 1000;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (uint32_t now = 1; now <= duration; ++now) {
+    const std::vector<uint8_t> &due = schedule.due(now);
+    for (size_t i = 0; i < due.size(); ++i) {
+      if (schedule.silent(due[i], now)) continue;
+      last_heard[due[i]] = now;
+      state[due[i]] = BoardState::ACTIVE;
+    }
+    if (now % options.scan_ms != 0) continue;
+    for (size_t b = 0; b < boards; ++b) {
+      const uint32_t silent = now - last_heard[b];
+      if (state[b] == BoardState::ACTIVE && silent >= kLossTimeoutMs) {
+        state[b] = BoardState::CONNECTION_LOSS_DETECTED;
+        result.record(silent - kLossTimeoutMs);
+      } else if (state[b] == BoardState::CONNECTION_LOSS_DETECTED && silent >= kAbortTimeoutMs) {
+        state[b] = BoardState::NO_CONNECTION_ABORT;
+      }
+    }
+  }
+  const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  result.ns_per_loop = elapsed / duration;
+  return result;
+}
+
+void print(const char *method, size_t boards, const Result &result) {
+  printf("{\"method\":\"%s\",\"boards\":%zu,\"ns_per_loop\":%.1f,\"losses\":%zu,\"mean_late_ms\":%.2f,"
+         "\"max_late_ms\":%u}\n",
+         method, boards, result.ns_per_loop, result.losses,
+         result.losses ? result.total_late_ms / result.losses : 0.0, result.max_late_ms);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.seconds = 60;
+  options.heartbeat_ms = 100;
+  options.scan_ms = 1;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--seconds")) options.seconds = static_cast<uint32_t>(atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--heartbeat-ms")) options.heartbeat_ms = static_cast<uint32_t>(atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--scan-ms")) options.scan_ms = static_cast<uint32_t>(atoi(argv[i + 1]));
+  }
+  if (options.seconds < 10 || options.heartbeat_ms == 0 || options.scan_ms == 0) {
+    fprintf(stderr, "usage: %s [--seconds N>=10] [--heartbeat-ms N] [--scan-ms N]\n", argv[0]);
+    return 1;
+  }
+
+  const size_t board_counts[] = {8, 32, 64, 128, 256};
+  for (size_t i = 0; i < sizeof(board_counts) / sizeof(board_counts[0]); ++i) {
+    const size_t boards = board_counts[i];
+    const Schedule schedule(boards, options);
+    print("wheel", boards, run_wheel(options, schedule));
+    print("rescan", boards, run_rescan(boards, options, schedule));
+  }
+  return 0;
+}
@@ -0,0 +1,333 @@
+// Loopback comparison of the io_uring transport against a plain recvmmsg()
+// loop (receive) and sendto() (send). Linux only.
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -DDIABLO_COMMS_ENABLE_IO_URING -Isrc extras/benchmarks/DiabloUringBenchmark.cpp src/*.cpp -o diablo_uring_bench -lpthread
+//   ./diablo_uring_bench [--boards N] [--senders N] [--seconds S]
+//
+// Receive: sender threads blast full Sensor Data packets from --boards
+// loopback addresses while one receiver thread dispatches them. Send: one
+// thread sends Actuator Command packets to a local sink. Prints one JSON
+// object per line:
+//   {"name":..., "packets_per_s":..., "cpu_ns_per_packet":...}
+// cpu_ns_per_packet is the receiving (or sending) thread's CPU time, which
+// is where syscall overhead shows up.
+
+#include "DAQv2-Comms.h"
+
+#if !defined(DIABLO_COMMS_ENABLE_IO_URING)
+#error "Build with -DDIABLO_COMMS_ENABLE_IO_URING"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace Diablo;
+
+namespace {
+
+const size_t kBatchSize = 64;
+const size_t kMaxDatagram = 2 * MAX_PACKET_SIZE;
+
+struct Options {
+  size_t boards;
+  size_t senders;
+  double seconds;
+};
+
+class CountingHandler : public IngestHandler {
+ public:
+  CountingHandler() : datapoints_(0) {}
+
+  void on_sensor_data(const SensorDataView &view) override {
+    for (size_t i = 0; i < view.num_chunks(); ++i) datapoints_ += view.chunk(i).size();
+  }
+
+  uint64_t datapoints() const { return datapoints_; }
+
+ private:
+  uint64_t datapoints_;
+};
+
+uint64_t thread_cpu_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+std::vector<uint8_t> make_sensor_packet() {
+  std::vector<SensorDataChunkCollection> chunks;
+  for (uint8_t c = 0; c < MAX_CHUNKS_PER_PACKET; ++c) {
+    chunks.push_back(SensorDataChunkCollection(c, MAX_SENSORS_PER_BOARD));
+    for (uint8_t s = 0; s < MAX_SENSORS_PER_BOARD; ++s) chunks.back().add_datapoint(s, c * 100u + s);
+  }
+  std::vector<uint8_t> packet(kMaxDatagram);
+  packet.resize(create_sensor_data_packet(chunks, MAX_SENSORS_PER_BOARD, 1, packet.data(), packet.size()));
+  return packet;
+}
+
+int bound_socket(uint32_t address_host_order, uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(address_host_order);
+  addr.sin_port = htons(port);
+  if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    perror("bind");
+    exit(1);
+  }
+  return fd;
+}
+
+uint16_t local_port(int fd) {
+  struct sockaddr_in addr;
+  socklen_t length = sizeof(addr);
+  getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &length);
+  return ntohs(addr.sin_port);
+}
+
+// Sends from boards [first, first + count) until stop is set
+void sender_main(size_t first, size_t count, uint16_t port, const std::vector<uint8_t> *packet,
+                 const std::atomic<bool> *stop) {
+  std::vector<int> sockets;
+  for (size_t b = 0; b < count; ++b) sockets.push_back(bound_socket(0x7F000100u + (first + b) % 254 + 1, 0));
+
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(port);
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  struct iovec iov;
+  iov.iov_base = const_cast<uint8_t *>(packet->data());
+  iov.iov_len = packet->size();
+  struct mmsghdr msgs[32];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < 32; ++i) {
+    msgs[i].msg_hdr.msg_name = &dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    msgs[i].msg_hdr.msg_iov = &iov;
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (size_t b = 0; !stop->load(std::memory_order_relaxed); b = (b + 1) % sockets.size()) {
+    sendmmsg(sockets[b], msgs, 32, 0);
+  }
+  for (size_t b = 0; b < sockets.size(); ++b) close(sockets[b]);
+}
+
+void print_result(const char *name, uint64_t packets, double seconds, uint64_t cpu_ns) {
+  printf("{\"name\":\"%s\",\"packets_per_s\":%.1f,\"cpu_ns_per_packet\":%.1f}\n", name,
+         static_cast<double>(packets) / seconds, packets ? static_cast<double>(cpu_ns) / packets : 0.0);
+  fflush(stdout);
+}
+
+// The same loop IngestServer shards run, on one socket
+void receive_recvmmsg(int fd, CountingHandler &handler, const std::atomic<bool> *stop, uint64_t *packets,
+                      uint64_t *cpu_ns) {
+  std::vector<uint8_t> buffers(kBatchSize * kMaxDatagram);
+  struct mmsghdr msgs[kBatchSize];
+  struct iovec iovs[kBatchSize];
+  struct sockaddr_in sources[kBatchSize];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    iovs[i].iov_base = &buffers[i * kMaxDatagram];
+    iovs[i].iov_len = kMaxDatagram;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &sources[i];
+  }
+  struct timeval timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_usec = 10000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  const uint64_t cpu_start = thread_cpu_ns();
+  uint64_t received = 0;
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (size_t i = 0; i < kBatchSize; ++i) msgs[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+    const int n = recvmmsg(fd, msgs, kBatchSize, MSG_WAITFORONE, nullptr);
+    for (int i = 0; i < n; ++i) {
+      handler.on_datagram(sources[i].sin_addr.s_addr, msgs[i].msg_len);
+      dispatch_packet(&buffers[static_cast<size_t>(i) * kMaxDatagram], msgs[i].msg_len, handler);
+    }
+    if (n > 0) {
+      handler.on_batch_end();
+      received += static_cast<uint64_t>(n);
+    }
+  }
+  *cpu_ns = thread_cpu_ns() - cpu_start;
+  *packets = received;
+}
+
+// The ring is single-issuer, so the transport is opened on this thread
+void receive_uring(std::atomic<int> *port, CountingHandler &handler, const std::atomic<bool> *stop,
+                   uint64_t *packets, uint64_t *cpu_ns) {
+  UringTransport transport;
+  UringOptions options;
+  options.bind_address = "127.0.0.1";
+  options.track_sequences = false; // Every packet carries the same bytes
+  if (!transport.open(options)) {
+    perror("UringTransport::open");
+    exit(1);
+  }
+  port->store(transport.port());
+
+  const uint64_t cpu_start = thread_cpu_ns();
+  uint64_t received = 0;
+  while (!stop->load(std::memory_order_relaxed)) received += transport.poll(handler, 10);
+  *cpu_ns = thread_cpu_ns() - cpu_start;
+  *packets = received;
+}
+
+void run_receive(bool uring, const Options &options, const std::vector<uint8_t> &packet) {
+  std::atomic<bool> stop_receiver(false);
+  std::atomic<bool> stop_senders(false);
+  CountingHandler handler;
+  uint64_t packets = 0;
+  uint64_t cpu_ns = 0;
+  int fd = -1;
+  std::atomic<int> port(0);
+  std::thread receiver;
+  if (uring) {
+    receiver = std::thread(receive_uring, &port, std::ref(handler), &stop_receiver, &packets, &cpu_ns);
+    while (port.load() == 0) std::this_thread::yield();
+  } else {
+    fd = bound_socket(INADDR_LOOPBACK, 0);
+    const int buffer_bytes = 4 << 20;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+    port.store(local_port(fd));
+    receiver = std::thread(receive_recvmmsg, fd, std::ref(handler), &stop_receiver, &packets, &cpu_ns);
+  }
+
+  std::vector<std::thread> senders;
+  for (size_t s = 0; s < options.senders; ++s) {
+    const size_t first = s * options.boards / options.senders;
+    const size_t count = (s + 1) * options.boards / options.senders - first;
+    senders.push_back(
+        std::thread(sender_main, first, count, static_cast<uint16_t>(port.load()), &packet, &stop_senders));
+  }
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+  stop_receiver.store(true);
+  receiver.join();
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stop_senders.store(true);
+  for (size_t s = 0; s < senders.size(); ++s) senders[s].join();
+  if (fd >= 0) close(fd);
+
+  print_result(uring ? "receive_io_uring" : "receive_recvmmsg", packets, elapsed, cpu_ns);
+}
+
+void run_send(bool uring, const Options &options) {
+  const int sink = bound_socket(INADDR_LOOPBACK, 0);
+  const int buffer_bytes = 16 << 20;
+  setsockopt(sink, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+  const uint16_t sink_port = local_port(sink);
+  const uint32_t sink_ip = htonl(INADDR_LOOPBACK);
+
+  std::vector<ActuatorCommand> commands(MAX_ACTUATORS_PER_BOARD);
+  for (size_t i = 0; i < commands.size(); ++i) {
+    commands[i].actuator_id = static_cast<uint8_t>(i);
+    commands[i].actuator_state = static_cast<uint8_t>(i & 1);
+  }
+
+  // Drain the sink on another thread so its buffer never fills
+  std::atomic<bool> stop(false);
+  std::thread drain([sink, &stop]() {
+    uint8_t buffer[kMaxDatagram];
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 10000;
+    setsockopt(sink, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while (!stop.load(std::memory_order_relaxed)) recv(sink, buffer, sizeof(buffer), 0);
+  });
+
+  UringTransport transport;
+  CountingHandler handler;
+  int fd = -1;
+  if (uring) {
+    UringOptions uring_options;
+    uring_options.bind_address = "127.0.0.1"; // Opened on this (the sending) thread
+    if (!transport.open(uring_options)) {
+      perror("UringTransport::open");
+      exit(1);
+    }
+  } else {
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+  }
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(sink_port);
+  dest.sin_addr.s_addr = sink_ip;
+  uint8_t packet[kMaxDatagram];
+
+  const uint64_t cpu_start = thread_cpu_ns();
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  uint64_t sent = 0;
+  uint32_t timestamp = 0;
+  while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < options.seconds) {
+    // Bursts of 64 commands, as a sequence step touching every board would queue
+    for (size_t i = 0; i < kBatchSize; ++i, ++timestamp) {
+      if (uring) {
+        if (transport.queue_actuator_command(commands, timestamp, sink_ip, sink_port)) ++sent;
+      } else {
+        const size_t size = create_actuator_command_packet(commands, timestamp, packet, sizeof(packet));
+        if (sendto(fd, packet, size, 0, reinterpret_cast<struct sockaddr *>(&dest), sizeof(dest)) > 0) ++sent;
+      }
+    }
+    if (uring) transport.poll(handler, 0); // Submits the burst and reaps earlier completions
+  }
+  const uint64_t cpu_ns = thread_cpu_ns() - cpu_start;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  stop.store(true);
+  drain.join();
+  if (fd >= 0) close(fd);
+  close(sink);
+  print_result(uring ? "send_io_uring" : "send_sendto", sent, elapsed, cpu_ns);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  options.boards = 32;
+  options.senders = 2;
+  options.seconds = 1.0;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--boards") && i + 1 < argc) {
+      options.boards = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--senders") && i + 1 < argc) {
+      options.senders = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+      options.seconds = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--boards N] [--senders N] [--seconds S]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (options.boards == 0 || options.senders == 0 || options.senders > options.boards || options.seconds <= 0) {
+    fprintf(stderr, "invalid arguments\n");
+    return 2;
+  }
+
+  const std::vector<uint8_t> packet = make_sensor_packet();
+  run_receive(false, options, packet);
+  run_receive(true, options, packet);
+  run_send(false, options);
+  run_send(true, options);
+  return 0;
+}
@@ -0,0 +1,215 @@
+// Tests for decode_capture_parallel() (Linux only).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/tests/DiabloCaptureDecodeTest.cpp src/*.cpp -o diablo_capture_decode_test -lpthread
+//   ./diablo_capture_decode_test [--packets N]
+//
+// Writes temporary capture files under /tmp. Prints one line per test and
+// exits non-zero if any check failed.
+
+#include "DAQv2-Comms.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace Diablo;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+const uint8_t kSensors = 10;
+const uint32_t kChunks = 10;
+const uint32_t kBoardA = 0x0A000001u;
+const uint32_t kBoardB = 0x0A000002u;
+
+size_t g_packets = 20000; // Per board
+
+void run(const char *name, void (*test)()) {
+  const int before = g_failures;
+  test();
+  printf("%s %s\n", g_failures == before ? "PASS" : "FAIL", name);
+  fflush(stdout);
+}
+
+// Encodes (timestamp, sensor) so every row can be checked
+uint32_t row_value(uint32_t timestamp, uint8_t sensor_id) { return timestamp * 16u + sensor_id; }
+
+// Packet k of a board: chunks at first_ms + k * kChunks, one per millisecond
+std::vector<uint8_t> make_packet(uint32_t first_ms) {
+  std::vector<SensorDataChunkCollection> chunks;
+  for (uint32_t c = 0; c < kChunks; ++c) {
+    SensorDataChunkCollection chunk(first_ms + c, kSensors);
+    for (uint8_t s = 0; s < kSensors; ++s) {
+      SensorDatapoint datapoint;
+      datapoint.sensor_id = s;
+      datapoint.data = row_value(first_ms + c, s);
+      chunk.datapoints.push_back(datapoint);
+    }
+    chunks.push_back(chunk);
+  }
+  std::vector<uint8_t> packet(1024); // 548 bytes: the benchmarks' 10x10 packet
+  packet.resize(create_sensor_data_packet(chunks, kSensors, first_ms, packet.data(), packet.size()));
+  return packet;
+}
+
+struct BoardClock {
+  uint32_t source_ip;
+  uint32_t boot_ms; // Board time of its first sample
+};
+
+/**
+ * Writes a capture of two boards sending alternately, packet by packet.
+ * swap_every > 0 swaps each board's packets k and k + 1 for every
+ * swap_every-th k (a packet overtaken by the next one).
+ */
+std::string write_capture(const BoardClock *boards, size_t num_boards, size_t swap_every) {
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/diablo_decode_test_%d.cap", static_cast<int>(getpid()));
+  CaptureWriter writer;
+  CHECK(writer.open(path));
+
+  uint64_t receive_ns = 0;
+  for (size_t k = 0; k < g_packets; ++k) {
+    for (size_t b = 0; b < num_boards; ++b) {
+      size_t index = k;
+      if (swap_every && k + 1 < g_packets && k % swap_every == 0) index = k + 1;
+      if (swap_every && k > 0 && (k - 1) % swap_every == 0) index = k - 1;
+      const std::vector<uint8_t> packet = make_packet(boards[b].boot_ms + static_cast<uint32_t>(index) * kChunks);
+      CHECK(writer.append(packet.data(), packet.size(), boards[b].source_ip, receive_ns += 100000));
+    }
+  }
+  CHECK(writer.close());
+  return path;
+}
+
+struct Collected {
+  std::map<uint32_t, uint32_t> last_timestamp; // Per board
+  std::map<uint32_t, uint64_t> rows;           // Per board
+  uint64_t out_of_order;
+  uint64_t bad_values;
+  uint64_t mixed_batches;
+
+  Collected() : out_of_order(0), bad_values(0), mixed_batches(0) {}
+};
+
+void collect(const SensorRow *rows, size_t count, void *context) {
+  Collected &out = *static_cast<Collected *>(context);
+  for (size_t i = 0; i < count; ++i) {
+    const SensorRow &row = rows[i];
+    if (row.source_ip != rows[0].source_ip) ++out.mixed_batches;
+    if (row.value != row_value(row.timestamp, row.sensor_id)) ++out.bad_values;
+    std::map<uint32_t, uint32_t>::iterator last = out.last_timestamp.find(row.source_ip);
+    if (last != out.last_timestamp.end() && row.timestamp < last->second) ++out.out_of_order;
+    out.last_timestamp[row.source_ip] = row.timestamp;
+    ++out.rows[row.source_ip];
+  }
+}
+
+struct DecodeRun {
+  Collected collected;
+  ParallelDecodeStats stats;
+  double ms;
+};
+
+DecodeRun decode(const std::string &path, unsigned threads) {
+  CaptureReader reader;
+  CHECK(reader.open(path.c_str()));
+  unlink(path.c_str()); // The mapping keeps the data alive
+
+  ParallelDecodeOptions options;
+  options.num_threads = threads;
+  options.segment_bytes = 64u << 10;
+  options.window_segments = 1;
+
+  DecodeRun run;
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  CHECK(decode_capture_parallel(reader, options, collect, &run.collected, &run.stats));
+  run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return run;
+}
+
+void check_complete(const DecodeRun &run, const BoardClock *boards, size_t num_boards) {
+  const uint64_t per_board = static_cast<uint64_t>(g_packets) * kChunks * kSensors;
+  CHECK(run.stats.rows == per_board * num_boards);
+  CHECK(run.stats.rejected == 0);
+  for (size_t b = 0; b < num_boards; ++b) {
+    std::map<uint32_t, uint64_t>::const_iterator it = run.collected.rows.find(boards[b].source_ip);
+    CHECK(it != run.collected.rows.end() && it->second == per_board);
+  }
+  CHECK(run.collected.out_of_order == 0);
+  CHECK(run.collected.bad_values == 0);
+  CHECK(run.collected.mixed_batches == 0);
+}
+
+// Rows of one 64 KiB segment: about 118 packets of 100 rows
+const size_t kRowsPerSegment = (64u << 10) / capture_record_size(548) * kChunks * kSensors;
+
+//==============================================================================
+// Tests
+//==============================================================================
+
+void test_offset_clocks() {
+  // Board B booted 100,000 s before board A. Only rows that actually overlap
+  // the next window of the same board may be carried.
+  const BoardClock boards[] = {{kBoardA, 1000}, {kBoardB, 100000000}};
+  const DecodeRun run = decode(write_capture(boards, 2, 0), 2);
+  check_complete(run, boards, 2);
+  CHECK(run.stats.max_carry_rows < kRowsPerSegment);
+  if (run.stats.max_carry_rows >= kRowsPerSegment) {
+    fprintf(stderr, "  carried %zu rows (one segment is about %zu)\n", run.stats.max_carry_rows, kRowsPerSegment);
+  }
+}
+
+void test_offset_clocks_cost() {
+  // Same capture with and without the clock offset: the offset must not
+  // change the cost of the decode
+  const BoardClock same[] = {{kBoardA, 1000}, {kBoardB, 1000}};
+  const BoardClock offset[] = {{kBoardA, 1000}, {kBoardB, 100000000}};
+  const DecodeRun base = decode(write_capture(same, 2, 0), 1);
+  const DecodeRun skewed = decode(write_capture(offset, 2, 0), 1);
+  check_complete(base, same, 2);
+  check_complete(skewed, offset, 2);
+  CHECK(skewed.ms < 3 * base.ms + 50);
+  printf("  no offset %.1f ms, 100000 s offset %.1f ms\n", base.ms, skewed.ms);
+}
+
+void test_reordered_packets_across_windows() {
+  // Every 50th packet of each board is overtaken by the next one, some of
+  // them across a segment (and so window) boundary
+  const BoardClock boards[] = {{kBoardA, 5000}, {kBoardB, 70000}};
+  const DecodeRun run = decode(write_capture(boards, 2, 50), 2);
+  check_complete(run, boards, 2);
+  CHECK(run.stats.max_carry_rows < kRowsPerSegment);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--packets")) g_packets = static_cast<size_t>(atoi(argv[i + 1]));
+  }
+  if (g_packets < 2) {
+    fprintf(stderr, "usage: %s [--packets N>=2]\n", argv[0]);
+    return 1;
+  }
+
+  run("offset_clocks", test_offset_clocks);
+  run("offset_clocks_cost", test_offset_clocks_cost);
+  run("reordered_packets_across_windows", test_reordered_packets_across_windows);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+// Unit and stress tests for MpscQueue and drain_sensor_samples() (host only).
+//
+// Build and run from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/tests/DiabloMpscQueueTest.cpp src/*.cpp -o diablo_mpsc_test -lpthread
+//   ./diablo_mpsc_test [--producers N] [--items N]
+// Add -fsanitize=thread to check the queue's memory ordering.
+//
+// Prints one line per test and exits non-zero if any check failed.
+
+#include "DAQv2-Comms.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace Diablo;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                   \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++g_failures;                                                   \
+    }                                                                 \
+  } while (0)
+
+SensorSample make_sample(uint32_t timestamp, uint8_t sensor_id, uint32_t data) {
+  SensorSample sample;
+  sample.timestamp = timestamp;
+  sample.datapoint.sensor_id = sensor_id;
+  sample.datapoint.data = data;
+  return sample;
+}
+
+// Encodes (tick, sensor) so a datapoint can be checked against its chunk
+uint32_t sample_value(uint32_t tick, uint8_t sensor_id) { return tick * 256u + sensor_id; }
+
+void run(const char *name, void (*test)()) {
+  const int before = g_failures;
+  test();
+  printf("%s %s\n", g_failures == before ? "PASS" : "FAIL", name);
+  fflush(stdout);
+}
+
+//==============================================================================
+// MpscQueue, single thread
+//==============================================================================
+
+void test_fifo_and_bounds() {
+  MpscQueue<int, 4> queue;
+  int value = 0;
+  CHECK(queue.empty());
+  CHECK(!queue.try_pop(value));
+  CHECK(!queue.try_peek(value));
+
+  for (int i = 0; i < 4; ++i) CHECK(queue.try_push(i));
+  CHECK(!queue.try_push(99)); // Full
+
+  CHECK(queue.try_peek(value) && value == 0);
+  CHECK(queue.try_peek(value) && value == 0); // Peek does not consume
+  for (int i = 0; i < 4; ++i) CHECK(queue.try_pop(value) && value == i);
+  CHECK(queue.empty());
+
+  // Many laps around the ring
+  for (int i = 0; i < 1000; ++i) {
+    CHECK(queue.try_push(i));
+    CHECK(queue.try_pop(value) && value == i);
+  }
+}
+
+//==============================================================================
+// drain_sensor_samples(), single thread
+//==============================================================================
+
+void test_drain_interleaved_ticks() {
+  // Two ADC tasks, sensors {0,1} and {2,3}, where task A runs a tick ahead
+  MpscQueue<SensorSample, 64> queue;
+  const uint32_t ticks[] = {10, 11};
+  for (size_t t = 0; t < 2; ++t) {
+    queue.try_push(make_sample(ticks[t], 0, sample_value(ticks[t], 0)));
+    queue.try_push(make_sample(ticks[t], 1, sample_value(ticks[t], 1)));
+  }
+  for (size_t t = 0; t < 2; ++t) {
+    queue.try_push(make_sample(ticks[t], 2, sample_value(ticks[t], 2)));
+    queue.try_push(make_sample(ticks[t], 3, sample_value(ticks[t], 3)));
+  }
+
+  FixedSensorDataChunkList chunks;
+  size_t dropped = 0;
+  CHECK(drain_sensor_samples(queue, chunks, 4, &dropped) == 8);
+  CHECK(dropped == 0);
+  CHECK(chunks.size() == 2);
+  CHECK(complete_sensor_chunks(chunks) == 2);
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    CHECK(chunks[c].timestamp == ticks[c]);
+    for (size_t i = 0; i < chunks[c].size(); ++i) {
+      CHECK(chunks[c].datapoints[i].data == sample_value(ticks[c], chunks[c].datapoints[i].sensor_id));
+    }
+  }
+}
+
+void test_drain_duplicate_sensor() {
+  // Same sensor twice with the same timestamp: the second starts a new chunk
+  MpscQueue<SensorSample, 16> queue;
+  queue.try_push(make_sample(5, 0, 1));
+  queue.try_push(make_sample(5, 0, 2));
+  queue.try_push(make_sample(5, 1, 3));
+
+  FixedSensorDataChunkList chunks;
+  CHECK(drain_sensor_samples(queue, chunks, 2) == 3);
+  CHECK(chunks.size() == 2);
+  CHECK(chunks[0].size() == 2 && chunks[0].datapoints[0].data == 1 && chunks[0].datapoints[1].data == 3);
+  CHECK(chunks[1].size() == 1 && chunks[1].datapoints[0].data == 2);
+  CHECK(complete_sensor_chunks(chunks) == 1);
+}
+
+void test_drain_drops_chunks_that_cannot_complete() {
+  // Sensor 1's sample for tick 1 was lost; tick 2 completes
+  MpscQueue<SensorSample, 16> queue;
+  queue.try_push(make_sample(1, 0, 0));
+  queue.try_push(make_sample(2, 0, 0));
+  queue.try_push(make_sample(2, 1, 0));
+
+  FixedSensorDataChunkList chunks;
+  size_t dropped = 0;
+  CHECK(drain_sensor_samples(queue, chunks, 2, &dropped) == 3);
+  CHECK(dropped == 1);
+  CHECK(chunks.size() == 1 && chunks[0].timestamp == 2 && chunks[0].full());
+}
+
+void test_drain_full_list_keeps_sample_queued() {
+  MpscQueue<SensorSample, 64> queue;
+  for (uint32_t t = 0; t <= MAX_CHUNKS_PER_PACKET; ++t) queue.try_push(make_sample(t, 7, t));
+
+  FixedSensorDataChunkList chunks;
+  CHECK(drain_sensor_samples(queue, chunks, 1) == MAX_CHUNKS_PER_PACKET);
+  CHECK(chunks.full() && complete_sensor_chunks(chunks) == MAX_CHUNKS_PER_PACKET);
+  CHECK(!queue.empty()); // The eleventh tick waits for room
+
+  pop_sensor_chunks(chunks, 4);
+  CHECK(chunks.size() == MAX_CHUNKS_PER_PACKET - 4 && chunks[0].timestamp == 4);
+  CHECK(drain_sensor_samples(queue, chunks, 1) == 1);
+  CHECK(queue.empty() && chunks[chunks.size() - 1].timestamp == MAX_CHUNKS_PER_PACKET);
+}
+
+void test_drain_full_list_of_incomplete_chunks() {
+  // A sensor that never reports: the oldest chunk makes room
+  MpscQueue<SensorSample, 64> queue;
+  for (uint32_t t = 0; t <= MAX_CHUNKS_PER_PACKET; ++t) queue.try_push(make_sample(t, 0, t));
+
+  FixedSensorDataChunkList chunks;
+  size_t dropped = 0;
+  CHECK(drain_sensor_samples(queue, chunks, 2, &dropped) == MAX_CHUNKS_PER_PACKET + 1);
+  CHECK(dropped == 1);
+  CHECK(chunks.full() && chunks[0].timestamp == 1);
+}
+
+//==============================================================================
+// Stress: std::thread producers
+//==============================================================================
+
+size_t g_producers = 4;
+size_t g_items = 200000;
+
+void test_stress_queue_order() {
+  // Every producer's items arrive exactly once and in the order pushed
+  static MpscQueue<uint32_t, 1024> queue;
+  std::atomic<bool> go(false);
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < g_producers; ++p) {
+    producers.push_back(std::thread([p, &go]() {
+      while (!go.load(std::memory_order_acquire)) {
+      }
+      for (uint32_t i = 0; i < g_items; ++i) {
+        const uint32_t item = static_cast<uint32_t>(p << 24) | i;
+        while (!queue.try_push(item)) std::this_thread::yield();
+      }
+    }));
+  }
+
+  std::vector<uint32_t> next(g_producers, 0);
+  size_t received = 0;
+  go.store(true, std::memory_order_release);
+  while (received < g_producers * g_items) {
+    uint32_t item;
+    if (!queue.try_pop(item)) continue;
+    const size_t p = item >> 24;
+    CHECK(p < g_producers);
+    if (p >= g_producers) break;
+    CHECK((item & 0xFFFFFFu) == next[p]);
+    next[p] = (item & 0xFFFFFFu) + 1;
+    ++received;
+  }
+  for (size_t p = 0; p < producers.size(); ++p) producers[p].join();
+  CHECK(queue.empty());
+}
+
+void test_stress_drain_sensor_samples() {
+  // Each producer owns two sensors and pushes them once per tick, so ticks
+  // from different producers interleave. Every chunk sent must hold one tick
+  // of every sensor, and every tick must be sent once, in order. Like ADC
+  // tasks on one timer, no producer runs more than kMaxSkew ticks ahead of
+  // the slowest.
+  static MpscQueue<SensorSample, 256> queue;
+  const uint32_t kMaxSkew = MAX_CHUNKS_PER_PACKET / 2;
+  const uint8_t sensors_per_producer = 2;
+  const size_t producers_count = g_producers * sensors_per_producer > MAX_SENSORS_PER_BOARD
+                                     ? MAX_SENSORS_PER_BOARD / sensors_per_producer
+                                     : g_producers;
+  const uint8_t num_sensors = static_cast<uint8_t>(producers_count * sensors_per_producer);
+  const uint32_t ticks = static_cast<uint32_t>(g_items / 10);
+
+  std::vector<std::atomic<uint32_t> > progress(producers_count);
+  for (size_t p = 0; p < producers_count; ++p) progress[p].store(0);
+  std::atomic<size_t> finished(0);
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < producers_count; ++p) {
+    producers.push_back(std::thread([p, ticks, sensors_per_producer, kMaxSkew, &progress, &finished]() {
+      for (uint32_t t = 0; t < ticks; ++t) {
+        for (size_t other = 0; other < progress.size(); ++other) {
+          while (t > progress[other].load(std::memory_order_acquire) + kMaxSkew) std::this_thread::yield();
+        }
+        for (uint8_t s = 0; s < sensors_per_producer; ++s) {
+          const uint8_t sensor_id = static_cast<uint8_t>(p * sensors_per_producer + s);
+          const SensorSample sample = make_sample(t, sensor_id, sample_value(t, sensor_id));
+          while (!queue.try_push(sample)) std::this_thread::yield();
+        }
+        progress[p].store(t + 1, std::memory_order_release);
+      }
+      finished.fetch_add(1);
+    }));
+  }
+
+  FixedSensorDataChunkList chunks;
+  size_t dropped = 0;
+  uint32_t next_tick = 0;
+  uint8_t buffer[2048]; // Room for a full list at 32 sensors, past MAX_PACKET_SIZE
+  while (next_tick < ticks) {
+    const bool done = finished.load() == producers_count;
+    drain_sensor_samples(queue, chunks, num_sensors, &dropped);
+    const size_t ready = complete_sensor_chunks(chunks);
+    if (!ready) {
+      CHECK(!done || !queue.empty()); // Nothing left that could complete a tick
+      if (done && queue.empty()) break;
+      continue;
+    }
+
+    // What the network task would send must build and parse back
+    const size_t size = create_sensor_data_packet(chunks.chunks, ready, num_sensors, 0, buffer, sizeof(buffer));
+    SensorDataView view;
+    CHECK(size != 0 && parse_sensor_data_view(buffer, size, view) && view.num_chunks() == ready);
+    for (size_t c = 0; c < ready; ++c) {
+      const FixedSensorDataChunkCollection &chunk = chunks[c];
+      CHECK(chunk.timestamp == next_tick);
+      uint32_t seen = 0;
+      for (size_t i = 0; i < chunk.size(); ++i) {
+        const SensorDatapoint &dp = chunk.datapoints[i];
+        CHECK(dp.data == sample_value(chunk.timestamp, dp.sensor_id));
+        seen |= 1u << dp.sensor_id;
+      }
+      CHECK(seen == (1u << num_sensors) - 1);
+      ++next_tick;
+    }
+    pop_sensor_chunks(chunks, ready);
+  }
+  for (size_t p = 0; p < producers.size(); ++p) producers[p].join();
+  CHECK(next_tick == ticks);
+  CHECK(dropped == 0);
+  CHECK(queue.empty() && chunks.empty());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--producers")) g_producers = static_cast<size_t>(atoi(argv[i + 1]));
+    else if (!strcmp(argv[i], "--items")) g_items = static_cast<size_t>(atoi(argv[i + 1]));
+  }
+  if (g_producers == 0 || g_producers > 255 || g_items == 0 || g_items > 0xFFFFFF) {
+    fprintf(stderr, "usage: %s [--producers 1-255] [--items 1-16777215]\n", argv[0]);
+    return 1;
+  }
+
+  run("fifo_and_bounds", test_fifo_and_bounds);
+  run("drain_interleaved_ticks", test_drain_interleaved_ticks);
+  run("drain_duplicate_sensor", test_drain_duplicate_sensor);
+  run("drain_drops_chunks_that_cannot_complete", test_drain_drops_chunks_that_cannot_complete);
+  run("drain_full_list_keeps_sample_queued", test_drain_full_list_keeps_sample_queued);
+  run("drain_full_list_of_incomplete_chunks", test_drain_full_list_of_incomplete_chunks);
+  run("stress_queue_order", test_stress_queue_order);
+  run("stress_drain_sensor_samples", test_stress_drain_sensor_samples);
+  return g_failures ? 1 : 0;
+}
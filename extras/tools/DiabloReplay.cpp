@@ -0,0 +1,99 @@
+// Replays a capture file over UDP, e.g. to load-test the ground software on
+// the same machine.
+//
+// Build from the repository root:
+//   g++ -O2 -std=c++11 -Isrc extras/tools/DiabloReplay.cpp src/*.cpp -o diablo_replay -lpthread
+//
+// Usage:
+//   ./diablo_replay CAPTURE ADDRESS:PORT [--speed N | --max-rate]
+//                   [--rewrite-timestamps BASE_MS] [--board IPV4] [--count N]
+//                   [--allow-remote]
+//
+// --speed divides the recorded inter-packet gaps (default 1, real time);
+// --max-rate sends as fast as the socket allows. Prints one JSON object with
+// the achieved rates when done.
+
+#include "DAQv2-Comms.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+
+using namespace Diablo;
+
+namespace {
+
+int usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s CAPTURE ADDRESS:PORT [--speed N | --max-rate] [--rewrite-timestamps BASE_MS]\n"
+          "       [--board IPV4] [--count N] [--allow-remote]\n",
+          argv0);
+  return 2;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) return usage(argv[0]);
+  const char *capture_path = argv[1];
+
+  char address[64];
+  const char *colon = strrchr(argv[2], ':');
+  if (!colon || static_cast<size_t>(colon - argv[2]) >= sizeof(address)) return usage(argv[0]);
+  memcpy(address, argv[2], static_cast<size_t>(colon - argv[2]));
+  address[colon - argv[2]] = '\0';
+  const long port = strtol(colon + 1, nullptr, 10);
+  if (port <= 0 || port > 65535) return usage(argv[0]);
+
+  CaptureReplayOptions options;
+  bool allow_remote = false;
+  for (int i = 3; i < argc; ++i) {
+    if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+      options.speed = atof(argv[++i]);
+      if (options.speed <= 0) return usage(argv[0]);
+    } else if (!strcmp(argv[i], "--max-rate")) {
+      options.speed = 0;
+    } else if (!strcmp(argv[i], "--rewrite-timestamps") && i + 1 < argc) {
+      options.rewrite_timestamps = true;
+      options.timestamp_base_ms = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+    } else if (!strcmp(argv[i], "--board") && i + 1 < argc) {
+      struct in_addr board;
+      if (inet_pton(AF_INET, argv[++i], &board) != 1) return usage(argv[0]);
+      options.source_ip = board.s_addr;
+    } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+      options.max_packets = strtoull(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--allow-remote")) {
+      allow_remote = true;
+    } else {
+      return usage(argv[0]);
+    }
+  }
+
+  CaptureReader reader;
+  if (!reader.open(capture_path)) {
+    fprintf(stderr, "cannot open capture file %s\n", capture_path);
+    return 1;
+  }
+
+  CaptureReplayer replayer;
+  if (!replayer.open(address, static_cast<uint16_t>(port), allow_remote)) {
+    fprintf(stderr, "cannot send to %s:%ld%s\n", address, port,
+            allow_remote ? "" : " (only loopback addresses without --allow-remote)");
+    return 1;
+  }
+
+  CaptureReplayStats stats;
+  if (!replayer.replay(reader, options, &stats)) {
+    fprintf(stderr, "replay failed\n");
+    return 1;
+  }
+
+  printf("{\"packets\":%llu,\"bytes\":%llu,\"send_errors\":%llu,\"elapsed_s\":%.3f,"
+         "\"packets_per_s\":%.1f,\"bytes_per_s\":%.1f}\n",
+         static_cast<unsigned long long>(stats.packets), static_cast<unsigned long long>(stats.bytes),
+         static_cast<unsigned long long>(stats.send_errors), stats.elapsed_ns / 1e9, stats.packets_per_s(),
+         stats.bytes_per_s());
+  return stats.send_errors ? 1 : 0;
+}
@@ -1,21 +1,31 @@
 #pragma once
 
-// Version information
-#define DIABLO_COMMS_VERSION 0 // Protocol version (uint8_t)
-
-// Maximum values
-#define MAX_SENSORS_PER_BOARD 10
-#define MAX_ACTUATORS_PER_BOARD 10
-#define MAX_CHUNKS_PER_PACKET 10
-#define MAX_PACKET_SIZE 512
-
-// Maximum counts for actuator config packet (used for buffer sizing and validation)
-#define MAX_ABORT_ACTUATORS 255
-#define MAX_ABORT_PTS 255
+// Version information and maximum values
+#include "DiabloConfig.h"
 
 // Include all other headers
 #include "DiabloEnums.h"
 #include "DiabloPackets.h"
+#include "DiabloPacketViews.h"
+#include "DiabloCrc32c.h"
+#include "DiabloSequence.h"
+#include "DiabloPacketSchema.h"
 #include "DiabloPacketUtils.h"
-
+#include "DiabloPacketBuilder.h"
+#include "DiabloBatching.h"
+#include "DiabloPacketDispatch.h"
+#include "DiabloPacketBatch.h"
+#include "DiabloAbortLane.h"
+#include "DiabloAbortTable.h"
+#include "DiabloAbortCheck.h"
+#include "DiabloLiveness.h"
+#include "DiabloColumnarDecode.h"
+#include "DiabloSpscRing.h"
+#include "DiabloMpscQueue.h"
+#include "DiabloCapture.h"
+#include "DiabloCaptureIndex.h"
+#include "DiabloCaptureDecode.h"
+#include "DiabloCaptureReplay.h"
+#include "DiabloIngest.h"
+#include "DiabloUring.h"
 
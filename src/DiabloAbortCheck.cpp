@@ -0,0 +1,332 @@
+#include "DiabloAbortCheck.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t, offsetof
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DIABLO_ABORT_CHECK_HAVE_AVX2 1
+#if defined(__SSE2__)
+#define DIABLO_ABORT_CHECK_HAVE_SSE2 1
+#endif
+#endif
+
+namespace Diablo {
+
+namespace {
+
+inline uint32_t load_u32(const uint8_t *ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(uint32_t));
+  return value;
+}
+
+inline uint64_t load_u64(const uint8_t *ptr) {
+  uint64_t value;
+  memcpy(&value, ptr, sizeof(uint64_t));
+  return value;
+}
+
+uint32_t slot_mask(uint8_t num_sensors) {
+  return num_sensors >= 32 ? 0xFFFFFFFFu : (1u << num_sensors) - 1;
+}
+
+uint32_t exceeded_scalar(const uint8_t *first_value, size_t chunk_stride, size_t num_chunks, uint8_t num_sensors,
+                         const uint32_t *thresholds) {
+  uint32_t exceeded = 0;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const uint8_t *values = first_value + c * chunk_stride;
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      exceeded |= static_cast<uint32_t>(load_u32(values + s * sizeof(SensorDatapoint)) > thresholds[s]) << s;
+    }
+  }
+  return exceeded;
+}
+
+#if defined(DIABLO_ABORT_CHECK_HAVE_SSE2)
+
+// Four slots per compare. SSE2 has no unsigned compare, so values and
+// thresholds are both shifted by 2^31 and compared signed.
+uint32_t exceeded_sse2(const uint8_t *first_value, size_t chunk_stride, size_t num_chunks, uint8_t num_sensors,
+                       const uint32_t *thresholds) {
+  const size_t kGroups = DIABLO_THRESHOLD_MAX_SLOTS / 4;
+  const size_t groups = num_sensors / 4;
+  const size_t step = 4 * sizeof(SensorDatapoint);
+  const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+  __m128i limit[kGroups];
+  __m128i over[kGroups];
+  for (size_t g = 0; g < groups; ++g) {
+    limit[g] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(thresholds + 4 * g)), bias);
+    over[g] = _mm_setzero_si128();
+  }
+
+  uint32_t exceeded = 0;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const uint8_t *values = first_value + c * chunk_stride;
+    for (size_t g = 0; g < groups; ++g) {
+      const uint8_t *p = values + g * step;
+      const __m128i v = _mm_setr_epi32(static_cast<int>(load_u32(p)), static_cast<int>(load_u32(p + 5)),
+                                       static_cast<int>(load_u32(p + 10)), static_cast<int>(load_u32(p + 15)));
+      over[g] = _mm_or_si128(over[g], _mm_cmpgt_epi32(_mm_xor_si128(v, bias), limit[g]));
+    }
+    // Slots past the last full group of four
+    for (uint8_t s = static_cast<uint8_t>(4 * groups); s < num_sensors; ++s) {
+      exceeded |= static_cast<uint32_t>(load_u32(values + s * sizeof(SensorDatapoint)) > thresholds[s]) << s;
+    }
+  }
+  for (size_t g = 0; g < groups; ++g) {
+    exceeded |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(over[g]))) << (4 * g);
+  }
+  return exceeded;
+}
+
+#endif // DIABLO_ABORT_CHECK_HAVE_SSE2
+
+#if defined(DIABLO_ABORT_CHECK_HAVE_AVX2)
+
+// Eight slots per gather. Lanes past num_sensors are masked off, so the gather
+// never reads beyond the last datapoint. v > t is tested as max(v, t) != t;
+// the loop keeps the "not exceeded" lanes and the result is its complement.
+__attribute__((target("avx2")))
+uint32_t exceeded_avx2(const uint8_t *first_value, size_t chunk_stride, size_t num_chunks, uint8_t num_sensors,
+                       const uint32_t *thresholds) {
+  const size_t kGroups = DIABLO_THRESHOLD_MAX_SLOTS / 8;
+  const size_t groups = (num_sensors + 7u) / 8;
+  __m256i offsets[kGroups];
+  __m256i active[kGroups];
+  __m256i limit[kGroups];
+  __m256i within[kGroups];
+  for (size_t g = 0; g < groups; ++g) {
+    int lane_offsets[8];
+    int lane_active[8];
+    uint32_t lane_limits[8];
+    for (size_t lane = 0; lane < 8; ++lane) {
+      const size_t s = 8 * g + lane;
+      lane_offsets[lane] = static_cast<int>(s * sizeof(SensorDatapoint));
+      lane_active[lane] = s < num_sensors ? -1 : 0;
+      lane_limits[lane] = s < num_sensors ? thresholds[s] : DIABLO_THRESHOLD_NONE;
+    }
+    offsets[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane_offsets));
+    active[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane_active));
+    limit[g] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane_limits));
+    within[g] = _mm256_set1_epi32(-1);
+  }
+
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const int *base = reinterpret_cast<const int *>(first_value + c * chunk_stride);
+    for (size_t g = 0; g < groups; ++g) {
+      const __m256i v = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), base, offsets[g], active[g], 1);
+      within[g] = _mm256_and_si256(within[g], _mm256_cmpeq_epi32(_mm256_max_epu32(v, limit[g]), limit[g]));
+    }
+  }
+
+  uint32_t exceeded = 0;
+  for (size_t g = 0; g < groups; ++g) {
+    const uint32_t lanes = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(within[g])));
+    exceeded |= (~lanes & 0xFFu) << (8 * g);
+  }
+  return exceeded;
+}
+
+bool cpu_has_avx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+#endif // DIABLO_ABORT_CHECK_HAVE_AVX2
+
+static_assert(DIABLO_THRESHOLD_LAYOUT_WORDS * sizeof(uint64_t) >=
+                  sizeof(SensorDataChunk) + DIABLO_THRESHOLD_MAX_SLOTS * sizeof(SensorDatapoint),
+              "Layout words must cover a full chunk");
+
+// Offset of layout word w in a chunk: the last word ends at the chunk's end
+// (overlapping the one before it), so no load leaves the chunk
+inline size_t layout_word_offset(size_t w, size_t words, size_t chunk_size) {
+  return w + 1 == words ? chunk_size - sizeof(uint64_t) : w * sizeof(uint64_t);
+}
+
+void build_layout_pattern(AbortThresholdVector &vector) {
+  const size_t chunk_size = SensorDataView::chunk_size(vector.num_sensors);
+  uint8_t pattern[DIABLO_THRESHOLD_LAYOUT_WORDS * sizeof(uint64_t)] = {};
+  uint8_t mask[DIABLO_THRESHOLD_LAYOUT_WORDS * sizeof(uint64_t)] = {};
+  for (uint8_t s = 0; s < vector.num_sensors; ++s) {
+    const size_t at = sizeof(SensorDataChunk) + s * sizeof(SensorDatapoint) + offsetof(SensorDatapoint, sensor_id);
+    pattern[at] = vector.sensor_ids[s];
+    mask[at] = 0xFF;
+  }
+  // A chunk with no datapoints has no ids to compare
+  vector.layout_words =
+      vector.num_sensors ? static_cast<uint8_t>((chunk_size + sizeof(uint64_t) - 1) / sizeof(uint64_t)) : 0;
+  for (size_t w = 0; w < vector.layout_words; ++w) {
+    const size_t offset = layout_word_offset(w, vector.layout_words, chunk_size);
+    memcpy(&vector.layout_pattern[w], pattern + offset, sizeof(uint64_t));
+    memcpy(&vector.layout_mask[w], mask + offset, sizeof(uint64_t));
+  }
+}
+
+// Bits in which the sensor_id bytes of num_chunks chunks (stride bytes each,
+// sized for the vector) differ from the vector's layout: 0 if all match
+inline uint64_t layout_difference(const uint8_t *chunks, size_t stride, size_t num_chunks,
+                                  const AbortThresholdVector &vector) {
+  if (vector.layout_words == 0) return 0;
+  const size_t last = vector.layout_words - 1u;
+  uint64_t difference = 0;
+  size_t w = 0;
+#if defined(DIABLO_ABORT_CHECK_HAVE_SSE2)
+  // Pairs of words as one 16-byte compare
+  __m128i wide = _mm_setzero_si128();
+  for (; w + 2 <= last; w += 2) {
+    const __m128i pattern = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vector.layout_pattern + w));
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vector.layout_mask + w));
+    for (size_t c = 0; c < num_chunks; ++c) {
+      const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chunks + c * stride + w * sizeof(uint64_t)));
+      wide = _mm_or_si128(wide, _mm_and_si128(_mm_xor_si128(ids, pattern), mask));
+    }
+  }
+  uint64_t halves[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(halves), wide);
+  difference = halves[0] | halves[1];
+#endif
+  for (; w < last; ++w) {
+    for (size_t c = 0; c < num_chunks; ++c) {
+      difference |= (load_u64(chunks + c * stride + w * sizeof(uint64_t)) ^ vector.layout_pattern[w]) &
+                    vector.layout_mask[w];
+    }
+  }
+  for (size_t c = 0; c < num_chunks; ++c) {
+    difference |= (load_u64(chunks + c * stride + stride - sizeof(uint64_t)) ^ vector.layout_pattern[last]) &
+                  vector.layout_mask[last];
+  }
+  return difference;
+}
+
+// For a chunk whose sensor order differs from the vector's: finds each
+// datapoint's slot by sensor_id. Returns false if the chunk holds a sensor
+// the vector does not list, since its value could not be checked.
+bool exceeded_slots_by_id(const SensorDataChunkView &chunk, const AbortThresholdVector &vector,
+                          uint32_t &exceeded_out) {
+  for (size_t i = 0; i < chunk.size(); ++i) {
+    const SensorDatapoint datapoint = chunk[i];
+    uint8_t s = 0;
+    while (s < vector.num_sensors && vector.sensor_ids[s] != datapoint.sensor_id) ++s;
+    if (s == vector.num_sensors) return false;
+    if (datapoint.data > vector.thresholds[s]) exceeded_out |= 1u << s;
+  }
+  return true;
+}
+
+} // namespace
+
+uint32_t exceeded_threshold_slots(const uint8_t *first_value, size_t chunk_stride, size_t num_chunks,
+                                  uint8_t num_sensors, const uint32_t *thresholds, bool force_scalar) {
+  if (!first_value || !thresholds || num_sensors == 0 || num_sensors > DIABLO_THRESHOLD_MAX_SLOTS) return 0;
+  const uint32_t mask = slot_mask(num_sensors);
+  if (!force_scalar) {
+#if defined(DIABLO_ABORT_CHECK_HAVE_AVX2)
+    if (cpu_has_avx2()) return exceeded_avx2(first_value, chunk_stride, num_chunks, num_sensors, thresholds) & mask;
+#endif
+#if defined(DIABLO_ABORT_CHECK_HAVE_SSE2)
+    return exceeded_sse2(first_value, chunk_stride, num_chunks, num_sensors, thresholds) & mask;
+#endif
+  }
+  return exceeded_scalar(first_value, chunk_stride, num_chunks, num_sensors, thresholds) & mask;
+}
+
+bool AbortThresholdVector::build(const AbortThresholdTable &table, uint32_t ip_address,
+                                 const SensorDataChunkView &layout) {
+  if (layout.size() > DIABLO_THRESHOLD_MAX_SLOTS) return false;
+  num_sensors = static_cast<uint8_t>(layout.size());
+  monitored = 0;
+  for (uint8_t s = 0; s < num_sensors; ++s) {
+    sensor_ids[s] = layout[s].sensor_id;
+    const AbortPTLocation *pt = table.find_pt(ip_address, sensor_ids[s]);
+    thresholds[s] = pt ? pt->pressure_threshold_adc : DIABLO_THRESHOLD_NONE;
+    if (pt) monitored |= 1u << s;
+  }
+  build_layout_pattern(*this);
+  return true;
+}
+
+bool AbortThresholdVector::assign(const uint8_t *ids, const uint32_t *slot_thresholds, size_t count) {
+  if (count > DIABLO_THRESHOLD_MAX_SLOTS || (count && (!ids || !slot_thresholds))) return false;
+  num_sensors = static_cast<uint8_t>(count);
+  monitored = 0;
+  for (size_t s = 0; s < count; ++s) {
+    sensor_ids[s] = ids[s];
+    thresholds[s] = slot_thresholds[s];
+    if (thresholds[s] != DIABLO_THRESHOLD_NONE) monitored |= 1u << s;
+  }
+  build_layout_pattern(*this);
+  return true;
+}
+
+bool AbortThresholdVector::matches(const SensorDataChunkView &chunk) const {
+  if (chunk.size() != num_sensors) return false;
+  const uint8_t *chunk_begin = chunk.datapoints().data() - sizeof(SensorDataChunk);
+  return layout_difference(chunk_begin, SensorDataView::chunk_size(num_sensors), 1, *this) == 0;
+}
+
+bool check_abort_thresholds(const SensorDataView &view, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar) {
+  exceeded_out = 0;
+  if (view.num_sensors() != vector.num_sensors) return false;
+  if (view.num_chunks() == 0) return true;
+
+  const size_t stride = SensorDataView::chunk_size(view.num_sensors());
+  const uint8_t *chunks = view.chunks_begin();
+  const uint8_t *first_value = chunks + sizeof(SensorDataChunk) + offsetof(SensorDatapoint, data);
+
+  // Normally every chunk has the vector's layout: one branch-free pass over
+  // the ids, then one kernel call for the whole packet
+  if (layout_difference(chunks, stride, view.num_chunks(), vector) == 0) {
+    exceeded_out = exceeded_threshold_slots(first_value, stride, view.num_chunks(), vector.num_sensors,
+                                            vector.thresholds, force_scalar);
+    return true;
+  }
+  if (layout_difference(chunks, stride, 1, vector) != 0) return false;
+
+  // Otherwise the kernel runs over each stretch of chunks in the vector's
+  // layout; a chunk in another sensor order is checked datapoint by datapoint
+  uint32_t exceeded = 0;
+  size_t c = 0;
+  while (c < view.num_chunks()) {
+    size_t end = c;
+    while (end < view.num_chunks() && layout_difference(chunks + end * stride, stride, 1, vector) == 0) ++end;
+    if (end > c) {
+      exceeded |= exceeded_threshold_slots(first_value + c * stride, stride, end - c, vector.num_sensors,
+                                           vector.thresholds, force_scalar);
+    }
+    if (end < view.num_chunks()) {
+      if (!exceeded_slots_by_id(view.chunk(end), vector, exceeded)) return false;
+      ++end;
+    }
+    c = end;
+  }
+  exceeded_out = exceeded;
+  return true;
+}
+
+bool check_abort_thresholds(const SensorDataChunkView &chunk, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar) {
+  exceeded_out = 0;
+  if (!vector.matches(chunk)) return false;
+  if (vector.num_sensors == 0) return true;
+  exceeded_out = exceeded_threshold_slots(chunk.datapoints().data() + offsetof(SensorDatapoint, data), 0, 1,
+                                          vector.num_sensors, vector.thresholds, force_scalar);
+  return true;
+}
+
+bool check_abort_thresholds(const uint8_t *buffer, size_t buffer_size, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar) {
+  exceeded_out = 0;
+  const size_t header_size = sizeof(PacketHeader);
+  if (!buffer || buffer_size < header_size) return false;
+  if (buffer[offsetof(PacketHeader, packet_type)] != static_cast<uint8_t>(PacketType::SENSOR_DATA)) return false;
+
+  // The check never reads the header fields, so only the body is parsed
+  SensorDataView view;
+  if (!view.reset(PacketHeader(), buffer + header_size, buffer_size - header_size)) return false;
+  return check_abort_thresholds(view, vector, exceeded_out, force_scalar);
+}
+
+} // namespace Diablo
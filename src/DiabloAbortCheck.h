@@ -0,0 +1,107 @@
+#pragma once
+
+#include "DiabloAbortTable.h"  // For AbortThresholdTable
+#include "DiabloPacketViews.h" // For SensorDataView, SensorDataChunkView
+#include <stddef.h>            // For size_t
+#include <stdint.h>            // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// VECTORIZED ABORT THRESHOLD CHECK
+//
+// Checks every datapoint of a Sensor Data packet (or of one chunk) against a
+// per-slot threshold vector in a single pass and returns a bitmask of the
+// sensor slots that went over. Thresholds are looked up once per board and
+// sensor layout (AbortThresholdVector::build()), not once per sample.
+//
+// x86 hosts use AVX2 (masked gathers over the 5-byte datapoint stride, eight
+// slots per instruction) when the CPU has it and SSE2 otherwise; other
+// targets, including the ESP32-S3, use a branch-free scalar loop.
+//==============================================================================
+
+#define DIABLO_THRESHOLD_MAX_SLOTS 32     // One bit per slot in the result
+#define DIABLO_THRESHOLD_NONE 0xFFFFFFFFu // Threshold of a slot that is not an abort PT
+#define DIABLO_THRESHOLD_LAYOUT_WORDS 21  // 64-bit words in a chunk of DIABLO_THRESHOLD_MAX_SLOTS datapoints
+
+/**
+ * @brief Abort thresholds by sensor slot (datapoint position within a chunk)
+ * for one board's sensor layout.
+ */
+struct AbortThresholdVector {
+  uint8_t num_sensors;                             // Slots per chunk
+  uint8_t sensor_ids[DIABLO_THRESHOLD_MAX_SLOTS];  // sensor_id expected in each slot
+  uint32_t thresholds[DIABLO_THRESHOLD_MAX_SLOTS]; // DIABLO_THRESHOLD_NONE if not an abort PT
+  uint32_t monitored;                              // Bit s set: slot s has a threshold
+
+  // The sensor_id bytes of a chunk in this layout as masked 64-bit words of
+  // its wire bytes, so a chunk's layout is checked in a few word compares.
+  // Set by build() and assign().
+  uint64_t layout_pattern[DIABLO_THRESHOLD_LAYOUT_WORDS];
+  uint64_t layout_mask[DIABLO_THRESHOLD_LAYOUT_WORDS];
+  uint8_t layout_words;
+
+  AbortThresholdVector() : num_sensors(0), monitored(0), layout_words(0) {}
+
+  /**
+   * @brief Look up the threshold of every slot of layout (normally the first
+   * chunk of a board's first packet) in table.
+   * @return false if the chunk has more than DIABLO_THRESHOLD_MAX_SLOTS
+   * datapoints.
+   */
+  bool build(const AbortThresholdTable &table, uint32_t ip_address, const SensorDataChunkView &layout);
+
+  /**
+   * @brief Set the layout and thresholds directly.
+   * @param thresholds num_sensors entries (DIABLO_THRESHOLD_NONE to skip a slot).
+   */
+  bool assign(const uint8_t *ids, const uint32_t *slot_thresholds, size_t count);
+
+  /**
+   * @brief Whether chunk has this vector's slot layout (same sensor_id in
+   * every slot).
+   */
+  bool matches(const SensorDataChunkView &chunk) const;
+};
+
+/**
+ * @brief Checks every datapoint of a packet against its slot's threshold.
+ *
+ * Slots are matched by position: the packet's first chunk must have the
+ * vector's layout (checked). Chunks in that layout go through the SIMD
+ * kernel; a later chunk in a different sensor order is matched to slots by
+ * sensor_id instead, so it is still checked, only more slowly.
+ *
+ * @param exceeded_out Bit s is set if any chunk's value in slot s is above
+ * thresholds[s]; 0 on error.
+ * @param force_scalar Use the scalar threshold kernel (for benchmarks).
+ * @return false if the packet does not have the vector's layout, or a later
+ * chunk holds a sensor_id the vector does not list (that value is unchecked).
+ */
+bool check_abort_thresholds(const SensorDataView &view, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar = false);
+
+/**
+ * @brief Same for a single decoded chunk.
+ */
+bool check_abort_thresholds(const SensorDataChunkView &chunk, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar = false);
+
+/**
+ * @brief Same for a raw SENSOR_DATA packet (header included, trailers
+ * already verified and stripped).
+ */
+bool check_abort_thresholds(const uint8_t *buffer, size_t buffer_size, const AbortThresholdVector &vector,
+                            uint32_t &exceeded_out, bool force_scalar = false);
+
+/**
+ * @brief The bare kernel, exposed for benchmarks: no layout check.
+ * @param first_value Address of the data field of slot 0 in chunk 0.
+ * @param chunk_stride Bytes from one chunk to the next.
+ * @param num_sensors At most DIABLO_THRESHOLD_MAX_SLOTS.
+ * @param force_scalar Skip the SIMD paths.
+ */
+uint32_t exceeded_threshold_slots(const uint8_t *first_value, size_t chunk_stride, size_t num_chunks,
+                                  uint8_t num_sensors, const uint32_t *thresholds, bool force_scalar = false);
+
+} // namespace Diablo
@@ -0,0 +1,37 @@
+#include "DiabloAbortLane.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t, offsetof
+
+namespace Diablo {
+
+DispatchResult dispatch_abort_packet(const uint8_t *buffer, size_t buffer_size, uint32_t source_ip,
+                                     AbortCallback callback, void *context, BoardSequenceTracker *tracker,
+                                     bool require_crc) {
+  if (!buffer || buffer_size < sizeof(PacketHeader)) return DispatchResult::TOO_SHORT;
+  if (!is_abort_lane_type(buffer[offsetof(PacketHeader, packet_type)])) return DispatchResult::UNKNOWN_TYPE;
+
+  if (!strip_crc_trailer(buffer, buffer_size, require_crc)) return DispatchResult::BAD_CRC;
+  const size_t sequenced_size = buffer_size;
+  if (!strip_sequence_trailer(buffer, buffer_size)) return DispatchResult::MALFORMED;
+  if (tracker) tracker->check(buffer, sequenced_size); // Statistics only: a repeated abort still aborts
+
+  AbortEvent event;
+  read_packet_header(buffer, event.header);
+  event.source_ip = source_ip;
+  if (callback) callback(event, context);
+  return DispatchResult::OK;
+}
+
+size_t create_abort_lane_packet(PacketType type, uint32_t timestamp_ms, uint8_t *buffer, size_t buffer_size) {
+  if (!is_abort_lane_type(static_cast<uint8_t>(type)) || !buffer || buffer_size < sizeof(PacketHeader)) return 0;
+
+  PacketHeader header;
+  header.packet_type = type;
+  header.version = DIABLO_COMMS_VERSION;
+  header.timestamp = timestamp_ms;
+  memcpy(buffer, &header, sizeof(header));
+  return sizeof(header);
+}
+
+} // namespace Diablo
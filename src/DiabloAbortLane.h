@@ -0,0 +1,93 @@
+#pragma once
+
+#include "DiabloEnums.h"          // For PacketType
+#include "DiabloPacketDispatch.h" // For DispatchResult
+#include "DiabloPackets.h"        // For PacketHeader
+#include "DiabloSequence.h"       // For BoardSequenceTracker
+#include <stddef.h>               // For size_t
+#include <stdint.h>               // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// ABORT FAST LANE
+//
+// ABORT, NO_CONNECTION_ABORT, CLEAR_ABORT and ABORT_DONE are header-only and
+// must not wait behind bulk Sensor Data. is_abort_lane_packet() recognizes
+// them from the first byte alone, so a receive path can pull them out before
+// anything else is decoded, and dispatch_abort_packet() checks the trailers
+// and calls a registered AbortCallback directly, without a PacketHandler or
+// any queue in between.
+//
+// IngestServer steers these packets to a socket and thread of their own (see
+// IngestOptions::abort_callback); UringTransport steers them to a second
+// socket that poll() drains before any other completion, and sends them
+// without going through the send slots.
+//==============================================================================
+
+/**
+ * @brief Whether packet_type (the first header byte) belongs to the abort lane.
+ */
+inline bool is_abort_lane_type(uint8_t packet_type) {
+  switch (static_cast<PacketType>(packet_type)) {
+    case PacketType::ABORT:
+    case PacketType::ABORT_DONE:
+    case PacketType::CLEAR_ABORT:
+    case PacketType::NO_CONNECTION_ABORT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Whether a received datagram belongs to the abort lane. Reads only
+ * the first byte; dispatch_abort_packet() validates the rest.
+ */
+inline bool is_abort_lane_packet(const uint8_t *buffer, size_t buffer_size) {
+  return buffer && buffer_size > 0 && is_abort_lane_type(buffer[0]);
+}
+
+/**
+ * @brief An abort-lane packet handed to an AbortCallback.
+ */
+struct AbortEvent {
+  PacketHeader header; // header.packet_type tells which of the four it is
+  uint32_t source_ip;  // IPv4 source as in sockaddr_in.sin_addr.s_addr (0 if unknown)
+};
+
+/**
+ * @brief Called for every valid abort-lane packet.
+ * @param context The pointer registered with the callback.
+ */
+typedef void (*AbortCallback)(const AbortEvent &event, void *context);
+
+/**
+ * @brief Validates an abort-lane packet and hands it to callback.
+ *
+ * The CRC-32C trailer, if flagged, is verified. The sequence number, if any,
+ * is recorded in tracker but never causes a reject: a duplicate, a stale
+ * number or a board that rebooted without resyncing is still delivered, since
+ * dropping an abort is worse than acting on one twice.
+ *
+ * @param source_ip Copied into AbortEvent::source_ip.
+ * @param tracker The sending board's tracker (for its statistics), or
+ * nullptr.
+ * @param require_crc Reject packets without a CRC-32C trailer.
+ * @return DispatchResult::OK once callback has run; UNKNOWN_TYPE if the packet
+ * is not an abort-lane packet, otherwise the reject reason.
+ */
+DispatchResult dispatch_abort_packet(const uint8_t *buffer, size_t buffer_size, uint32_t source_ip,
+                                     AbortCallback callback, void *context,
+                                     BoardSequenceTracker *tracker = nullptr,
+                                     bool require_crc = DIABLO_COMMS_REQUIRE_CRC32C);
+
+/**
+ * @brief Creates a header-only abort-lane packet.
+ * @param type ABORT, ABORT_DONE, CLEAR_ABORT or NO_CONNECTION_ABORT.
+ * @return The number of bytes written (sizeof(PacketHeader)), or 0 if type is
+ * not an abort-lane type or the buffer is too small.
+ */
+size_t create_abort_lane_packet(PacketType type, uint32_t timestamp_ms, uint8_t *buffer, size_t buffer_size);
+
+} // namespace Diablo
@@ -0,0 +1,156 @@
+#include "DiabloAbortTable.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy, memset
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+void AbortThresholdTable::clear() {
+  memset(pt_slots_, 0, sizeof(pt_slots_));
+  memset(actuator_slots_, 0, sizeof(actuator_slots_));
+  memset(board_slots_, 0, sizeof(board_slots_));
+  num_pts_ = 0;
+  num_actuators_ = 0;
+  num_boards_ = 0;
+}
+
+bool AbortThresholdTable::find_key(const KeySlot *slots, uint32_t ip_address, uint8_t id, size_t &slot_out) {
+  for (size_t i = slot_of(ip_address, id);; i = (i + 1) & kMask) {
+    if (!slots[i].used || (slots[i].ip_address == ip_address && slots[i].id == id)) {
+      slot_out = i;
+      return slots[i].used != 0;
+    }
+  }
+}
+
+template <typename Actuators, typename Pts>
+bool AbortThresholdTable::build_from(const Actuators &abort_actuators, size_t num_actuators, const Pts &abort_pts,
+                                     size_t num_pts) {
+  clear();
+  if (num_actuators > MAX_ABORT_ACTUATORS || num_pts > MAX_ABORT_PTS) return false;
+
+  for (size_t i = 0; i < num_pts; ++i) {
+    const AbortPTLocation pt = abort_pts[i];
+    size_t s = slot_of(pt.ip_address, pt.sensor_id);
+    for (; pt_slots_[s].used; s = (s + 1) & kMask) {
+      if (pt_slots_[s].ip_address == pt.ip_address && pt_slots_[s].id == pt.sensor_id) {
+        clear();
+        return false;
+      }
+    }
+    PtSlot &slot = pt_slots_[s];
+    slot.ip_address = pt.ip_address;
+    slot.threshold = pt.pressure_threshold_adc;
+    slot.id = pt.sensor_id;
+    slot.used = 1;
+    slot.index = num_pts_;
+    pts_[num_pts_++] = pt;
+  }
+
+  // Count actuators per board (boards numbered by first appearance) and
+  // reject duplicates
+  for (size_t i = 0; i < num_actuators; ++i) {
+    const AbortActuatorLocation actuator = abort_actuators[i];
+    size_t s;
+    if (find_key(actuator_slots_, actuator.ip_address, actuator.actuator_id, s)) {
+      clear();
+      return false;
+    }
+    actuator_slots_[s].ip_address = actuator.ip_address;
+    actuator_slots_[s].id = actuator.actuator_id;
+    actuator_slots_[s].used = 1;
+
+    if (!find_key(board_slots_, actuator.ip_address, 0, s)) {
+      board_slots_[s].ip_address = actuator.ip_address;
+      board_slots_[s].used = 1;
+      board_slots_[s].index = num_boards_;
+      boards_[num_boards_].ip_address = actuator.ip_address;
+      boards_[num_boards_].count = 0;
+      ++num_boards_;
+    }
+    ++boards_[board_slots_[s].index].count;
+  }
+
+  uint16_t first = 0;
+  for (size_t b = 0; b < num_boards_; ++b) {
+    boards_[b].first = first;
+    first = static_cast<uint16_t>(first + boards_[b].count);
+    boards_[b].count = 0; // Refilled below
+  }
+
+  // Place each actuator in its board's run
+  for (size_t i = 0; i < num_actuators; ++i) {
+    const AbortActuatorLocation actuator = abort_actuators[i];
+    size_t s;
+    find_key(board_slots_, actuator.ip_address, 0, s);
+    Board &board = boards_[board_slots_[s].index];
+    const uint16_t index = static_cast<uint16_t>(board.first + board.count++);
+    actuators_[index] = actuator;
+
+    find_key(actuator_slots_, actuator.ip_address, actuator.actuator_id, s);
+    actuator_slots_[s].index = index;
+  }
+  num_actuators_ = static_cast<uint16_t>(num_actuators);
+  return true;
+}
+
+bool AbortThresholdTable::build(const ActuatorConfigView &config) {
+  return build_from(config.abort_actuators, config.abort_actuators.size(), config.abort_pts, config.abort_pts.size());
+}
+
+bool AbortThresholdTable::build(const std::vector<AbortActuatorLocation> &abort_actuators,
+                                const std::vector<AbortPTLocation> &abort_pts) {
+  return build_from(abort_actuators, abort_actuators.size(), abort_pts, abort_pts.size());
+}
+
+bool AbortThresholdTable::build(const AbortActuatorLocation *abort_actuators, size_t num_actuators,
+                                const AbortPTLocation *abort_pts, size_t num_pts) {
+  if ((num_actuators && !abort_actuators) || (num_pts && !abort_pts)) {
+    clear();
+    return false;
+  }
+  return build_from(abort_actuators, num_actuators, abort_pts, num_pts);
+}
+
+const AbortActuatorLocation *AbortThresholdTable::find_actuator(uint32_t ip_address, uint8_t actuator_id) const {
+  size_t s;
+  return find_key(actuator_slots_, ip_address, actuator_id, s) ? &actuators_[actuator_slots_[s].index] : nullptr;
+}
+
+int AbortThresholdTable::find_board(uint32_t ip_address) const {
+  size_t s;
+  return find_key(board_slots_, ip_address, 0, s) ? board_slots_[s].index : -1;
+}
+
+size_t AbortThresholdTable::create_abort_command_packet(size_t board, bool vent, uint32_t timestamp_ms,
+                                                        uint8_t *buffer, size_t buffer_size) const {
+  if (board >= num_boards_ || !buffer) return 0;
+  const Board &entry = boards_[board];
+  const size_t header_size = sizeof(PacketHeader);
+  const size_t body_size = sizeof(ActuatorCommandPacket);
+  const size_t total_size = header_size + body_size + entry.count * sizeof(ActuatorCommand);
+  if (buffer_size < total_size) return 0;
+
+  PacketHeader header;
+  header.packet_type = PacketType::ACTUATOR_COMMAND;
+  header.version = DIABLO_COMMS_VERSION;
+  header.timestamp = timestamp_ms;
+  memcpy(buffer, &header, header_size);
+
+  ActuatorCommandPacket body;
+  body.num_commands = static_cast<uint8_t>(entry.count);
+  memcpy(buffer + header_size, &body, body_size);
+
+  uint8_t *ptr = buffer + header_size + body_size;
+  for (size_t i = 0; i < entry.count; ++i) {
+    const AbortActuatorLocation &actuator = actuators_[entry.first + i];
+    ActuatorCommand command;
+    command.actuator_id = actuator.actuator_id;
+    command.actuator_state = vent ? actuator.vent_state : actuator.abort_state;
+    memcpy(ptr, &command, sizeof(command));
+    ptr += sizeof(command);
+  }
+  return total_size;
+}
+
+} // namespace Diablo
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "DiabloConfig.h"      // For MAX_ABORT_ACTUATORS, MAX_ABORT_PTS
+#include "DiabloPackets.h"     // For AbortActuatorLocation, AbortPTLocation
+#include "DiabloPacketViews.h" // For ActuatorConfigView
+#include <stddef.h>            // For size_t
+#include <stdint.h>            // For standard integer types
+#include <vector>              // For std::vector
+
+namespace Diablo {
+
+//==============================================================================
+// ABORT THRESHOLD TABLE
+//
+// Compiled form of the abort section of an Actuator Config packet. Abort PTs
+// are indexed by (ip_address, sensor_id) and abort actuators by
+// (ip_address, actuator_id) in fixed-size open-addressing hash tables, so
+// checking a sample against its threshold is one hash and usually one probe
+// instead of a scan over every PT. Actuators are also grouped by board, so
+// an abort fans out as one contiguous run (and one Actuator Command packet)
+// per board.
+//
+// All storage is inside the object: build() never allocates, and neither
+// does anything after it.
+//==============================================================================
+
+#define DIABLO_ABORT_TABLE_SLOT_BITS 9 // 512 slots per index: at most half full
+
+/**
+ * @brief Abort PT thresholds and abort actuators, indexed for O(1) lookup.
+ *
+ * Typical use on the abort controller:
+ * @code
+ *   AbortThresholdTable table;            // Static or long-lived: about 20 KB
+ *   table.build(config_view);             // From on_actuator_config()
+ *   ...
+ *   if (table.exceeds_threshold(board_ip, dp.sensor_id, dp.data)) {
+ *     for (size_t b = 0; b < table.num_boards(); ++b) {
+ *       const size_t n = table.create_abort_command_packet(b, false, now_ms, buffer, sizeof(buffer));
+ *       send(table.board_ip(b), buffer, n);
+ *     }
+ *   }
+ * @endcode
+ */
+class AbortThresholdTable {
+ public:
+  AbortThresholdTable() { clear(); }
+
+  /**
+   * @brief Replace the table with the abort section of a parsed config.
+   * @return false (leaving the table empty) if there are more than
+   * MAX_ABORT_PTS PTs or MAX_ABORT_ACTUATORS actuators, or if an
+   * (ip_address, id) pair appears twice.
+   */
+  bool build(const ActuatorConfigView &config);
+  bool build(const std::vector<AbortActuatorLocation> &abort_actuators,
+             const std::vector<AbortPTLocation> &abort_pts);
+  bool build(const AbortActuatorLocation *abort_actuators, size_t num_actuators,
+             const AbortPTLocation *abort_pts, size_t num_pts);
+
+  void clear();
+
+  /**
+   * @brief The abort PT for a sensor, or nullptr if it is not one.
+   */
+  const AbortPTLocation *find_pt(uint32_t ip_address, uint8_t sensor_id) const {
+    const PtSlot *slot = find_pt_slot(ip_address, sensor_id);
+    return slot ? &pts_[slot->index] : nullptr;
+  }
+
+  /**
+   * @brief Whether a sample is above its abort threshold.
+   * @return false if the sensor is not an abort PT.
+   */
+  bool exceeds_threshold(uint32_t ip_address, uint8_t sensor_id, uint32_t adc_value) const {
+    const PtSlot *slot = find_pt_slot(ip_address, sensor_id);
+    return slot && adc_value > slot->threshold;
+  }
+
+  /**
+   * @brief The abort actuator entry, or nullptr if it is not one.
+   */
+  const AbortActuatorLocation *find_actuator(uint32_t ip_address, uint8_t actuator_id) const;
+
+  size_t num_pts() const { return num_pts_; }
+  size_t num_actuators() const { return num_actuators_; }
+
+  /**
+   * @brief Boards with abort actuators, in order of first appearance.
+   */
+  size_t num_boards() const { return num_boards_; }
+  uint32_t board_ip(size_t board) const { return boards_[board].ip_address; }
+
+  /**
+   * @brief The abort actuators of one board (no bounds check on board).
+   * @param count_out Set to the number of actuators returned.
+   */
+  const AbortActuatorLocation *board_actuators(size_t board, size_t &count_out) const {
+    count_out = boards_[board].count;
+    return &actuators_[boards_[board].first];
+  }
+
+  /**
+   * @brief Index of a board for board_actuators(), or -1 if it has no
+   * abort actuators.
+   */
+  int find_board(uint32_t ip_address) const;
+
+  /**
+   * @brief Writes the Actuator Command packet that moves one board's abort
+   * actuators to their abort (or vent) states.
+   * @param vent Use vent_state instead of abort_state.
+   * @return The number of bytes written, or 0 if board is out of range or
+   * the buffer is too small.
+   */
+  size_t create_abort_command_packet(size_t board, bool vent, uint32_t timestamp_ms,
+                                     uint8_t *buffer, size_t buffer_size) const;
+
+ private:
+  static const size_t kSlots = static_cast<size_t>(1) << DIABLO_ABORT_TABLE_SLOT_BITS;
+  static const size_t kMask = kSlots - 1;
+
+  // The threshold sits in the slot so a check touches a single entry
+  struct PtSlot {
+    uint32_t ip_address;
+    uint32_t threshold;
+    uint8_t id;
+    uint8_t used;
+    uint16_t index; // Into pts_
+  };
+
+  struct KeySlot {
+    uint32_t ip_address;
+    uint8_t id; // actuator_id (unused for boards)
+    uint8_t used;
+    uint16_t index; // Into actuators_ or boards_
+  };
+
+  struct Board {
+    uint32_t ip_address;
+    uint16_t first; // Into actuators_
+    uint16_t count;
+  };
+
+  /**
+   * Multiplicative hash of the 40-bit key: the top bits of the product
+   * depend on every key bit, so neighbouring IPs and ids spread out.
+   */
+  static size_t slot_of(uint32_t ip_address, uint8_t id) {
+    const uint64_t key = (static_cast<uint64_t>(ip_address) << 8) | id;
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - DIABLO_ABORT_TABLE_SLOT_BITS));
+  }
+
+  const PtSlot *find_pt_slot(uint32_t ip_address, uint8_t sensor_id) const {
+    for (size_t i = slot_of(ip_address, sensor_id);; i = (i + 1) & kMask) {
+      const PtSlot &slot = pt_slots_[i];
+      if (!slot.used) return nullptr;
+      if (slot.ip_address == ip_address && slot.id == sensor_id) return &slot;
+    }
+  }
+
+  /**
+   * Probe slots for (ip_address, id).
+   * @param slot_out The matching slot, or else the empty slot that ends the probe.
+   * @return Whether the key is present.
+   */
+  static bool find_key(const KeySlot *slots, uint32_t ip_address, uint8_t id, size_t &slot_out);
+
+  // Shared by the build() overloads; Actuators and Pts only need operator[]
+  template <typename Actuators, typename Pts>
+  bool build_from(const Actuators &abort_actuators, size_t num_actuators, const Pts &abort_pts, size_t num_pts);
+
+  PtSlot pt_slots_[kSlots];
+  KeySlot actuator_slots_[kSlots];
+  KeySlot board_slots_[kSlots];
+  AbortPTLocation pts_[MAX_ABORT_PTS];
+  AbortActuatorLocation actuators_[MAX_ABORT_ACTUATORS]; // Grouped by board
+  Board boards_[MAX_ABORT_ACTUATORS];
+  uint16_t num_pts_;
+  uint16_t num_actuators_;
+  uint16_t num_boards_;
+};
+
+} // namespace Diablo
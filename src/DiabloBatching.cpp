@@ -0,0 +1,89 @@
+#include "DiabloBatching.h"
+#include "DAQv2-Comms.h"
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+namespace {
+
+// Defaults: per-sample latency while FIRING, large batches at rest.
+const BatchingPolicy kDefaultPolicies[] = {
+    {500, 1, 255}, // SAFE
+    {50, 1, 255},  // PRESSURIZING
+    {50, 1, 255},  // LOX_FILL
+    {2, 1, 8},     // FIRING
+    {100, 1, 255}, // POST_FIRE
+};
+
+} // namespace
+
+SensorBatchController::SensorBatchController(uint16_t sample_period_ms)
+    : sample_period_ms_(1), state_(EngineState::SAFE), load_(0) {
+  for (uint8_t i = 0; i < kNumStates; ++i) {
+    policies_[i] = kDefaultPolicies[i];
+  }
+  set_sample_period_ms(sample_period_ms);
+}
+
+void SensorBatchController::set_policy(EngineState state, const BatchingPolicy &policy) {
+  const uint8_t index = static_cast<uint8_t>(state);
+  if (index < kNumStates) {
+    policies_[index] = policy;
+  }
+}
+
+const BatchingPolicy &SensorBatchController::policy(EngineState state) const {
+  const uint8_t index = static_cast<uint8_t>(state);
+  // Unknown states get the tightest latency budget
+  return index < kNumStates ? policies_[index] : policies_[static_cast<uint8_t>(EngineState::FIRING)];
+}
+
+void SensorBatchController::on_server_heartbeat(const ServerHeartbeatPacket &heartbeat) {
+  set_engine_state(heartbeat.engine_state);
+  set_load_hint(heartbeat.load_hint);
+}
+
+void SensorBatchController::set_load_hint(uint8_t load_hint) {
+  if (load_hint >= load_) {
+    load_ = load_hint;
+  } else {
+    // Decay by a quarter of the difference per heartbeat, always moving by at least one
+    const uint8_t step = static_cast<uint8_t>((load_ - load_hint + 3) / 4);
+    load_ = static_cast<uint8_t>(load_ - step);
+  }
+}
+
+void SensorBatchController::set_sample_period_ms(uint16_t sample_period_ms) {
+  sample_period_ms_ = sample_period_ms ? sample_period_ms : 1;
+}
+
+uint8_t SensorBatchController::chunks_per_packet() const {
+  const BatchingPolicy &p = current();
+  const uint8_t max_chunks = p.max_chunks ? p.max_chunks : 1;
+  const uint8_t min_chunks = p.min_chunks > max_chunks ? max_chunks : (p.min_chunks ? p.min_chunks : 1);
+
+  uint32_t chunks = p.latency_budget_ms / sample_period_ms_;
+  if (chunks < min_chunks) chunks = min_chunks;
+  if (chunks > max_chunks) chunks = max_chunks;
+
+  // Back off toward max_chunks in proportion to server load
+  chunks += ((max_chunks - chunks) * load_ + 254) / 255;
+  return static_cast<uint8_t>(chunks);
+}
+
+bool SensorBatchController::should_flush(uint8_t pending_chunks, uint32_t oldest_chunk_ms,
+                                         uint32_t now_ms, uint8_t packet_capacity) const {
+  if (pending_chunks == 0) return false;
+  uint8_t target = chunks_per_packet();
+  if (packet_capacity && target > packet_capacity) target = packet_capacity;
+  if (pending_chunks >= target) return true;
+
+  // The deadline is the latency budget, or the time to fill the target batch
+  // if that is longer (min_chunks or server load asked for more chunks)
+  uint32_t deadline_ms = current().latency_budget_ms;
+  const uint32_t fill_ms = static_cast<uint32_t>(target) * sample_period_ms_;
+  if (fill_ms > deadline_ms) deadline_ms = fill_ms;
+  return now_ms - oldest_chunk_ms >= deadline_ms;
+}
+
+} // namespace Diablo
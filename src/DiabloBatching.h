@@ -0,0 +1,114 @@
+#pragma once
+
+#include "DiabloEnums.h"   // For EngineState
+#include "DiabloPackets.h" // For ServerHeartbeatPacket
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// ADAPTIVE SENSOR BATCHING
+//
+// Chooses how many chunks go into each Sensor Data packet. Each EngineState
+// has a latency budget: chunks are batched for at most that long, so FIRING
+// gets near per-sample packets while SAFE sends a few large ones. When the
+// server reports load through ServerHeartbeatPacket.load_hint, batches grow
+// toward the state's max_chunks to cut the packet rate.
+//==============================================================================
+
+/**
+ * @brief Batching limits for one EngineState.
+ */
+struct BatchingPolicy {
+  uint16_t latency_budget_ms; // Longest a chunk may wait before its packet is sent
+  uint8_t min_chunks;         // Never send fewer chunks per packet (unless flushing)
+  uint8_t max_chunks;         // Upper bound when backing off under server load
+};
+
+/**
+ * @brief Picks the chunk count per Sensor Data packet.
+ *
+ * Typical use on a board, together with SensorDataPacker:
+ * @code
+ *   controller.on_server_heartbeat(heartbeat);   // from the dispatcher
+ *   packer.add_chunk(now, datapoints);
+ *   if (controller.should_flush(packer.pending_chunks(), packer.oldest_pending_timestamp(), now,
+ *                               packer.max_chunks_per_packet())) {
+ *     packer.flush();
+ *   }
+ * @endcode
+ *
+ * Passing the packer's capacity matters when chunks_per_packet() is more
+ * than one packet holds: the packer then sends full packets on its own, and
+ * the flush follows the packet it is filling rather than waiting for chunks
+ * that will never be pending at once.
+ */
+class SensorBatchController {
+ public:
+  /**
+   * @param sample_period_ms Time between consecutive chunks.
+   */
+  explicit SensorBatchController(uint16_t sample_period_ms = 1);
+
+  /**
+   * @brief Replace the policy for one engine state.
+   */
+  void set_policy(EngineState state, const BatchingPolicy &policy);
+  const BatchingPolicy &policy(EngineState state) const;
+
+  /**
+   * @brief Apply the engine state and load hint from a server heartbeat.
+   */
+  void on_server_heartbeat(const ServerHeartbeatPacket &heartbeat);
+
+  void set_engine_state(EngineState state) { state_ = state; }
+
+  /**
+   * @brief Record a server load hint (0 = idle, 255 = saturated).
+   *
+   * Rising load is applied at once; falling load decays over a few
+   * heartbeats so batch sizes do not oscillate.
+   */
+  void set_load_hint(uint8_t load_hint);
+
+  void set_sample_period_ms(uint16_t sample_period_ms);
+
+  /**
+   * @brief The number of chunks each packet should carry right now.
+   *
+   * latency_budget_ms / sample_period_ms, clamped to [min_chunks, max_chunks],
+   * then scaled toward max_chunks by the smoothed load hint.
+   */
+  uint8_t chunks_per_packet() const;
+
+  /**
+   * @brief Whether the pending packet should be sent now.
+   * @param pending_chunks Chunks waiting in the packer.
+   * @param oldest_chunk_ms Timestamp of the oldest pending chunk.
+   * @param now_ms Current time.
+   * @param packet_capacity Most chunks one packet can hold (see
+   * SensorDataPacker::max_chunks_per_packet()); the target is clamped to it.
+   * 0 is ignored.
+   * @return true once chunks_per_packet() chunks are pending, or once the
+   * oldest chunk has waited for the latency budget (or, if longer, the time
+   * needed to fill chunks_per_packet() chunks).
+   */
+  bool should_flush(uint8_t pending_chunks, uint32_t oldest_chunk_ms, uint32_t now_ms,
+                    uint8_t packet_capacity = 255) const;
+
+  EngineState engine_state() const { return state_; }
+  uint8_t load() const { return load_; }
+
+ private:
+  static const uint8_t kNumStates = 5; // SAFE .. POST_FIRE
+
+  const BatchingPolicy &current() const { return policy(state_); }
+
+  BatchingPolicy policies_[kNumStates];
+  uint16_t sample_period_ms_;
+  EngineState state_;
+  uint8_t load_; // Smoothed load hint
+};
+
+} // namespace Diablo
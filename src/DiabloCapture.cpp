@@ -0,0 +1,267 @@
+#include "DiabloCapture.h"
+
+#if defined(__linux__)
+
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy, memcmp
+#include <cstddef> // For size_t, offsetof
+#include <atomic>  // For std::atomic_signal_fence
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Diablo {
+
+namespace {
+
+const size_t kHeaderSize = sizeof(CaptureFileHeader);
+
+static_assert(sizeof(CaptureFileHeader) == 32, "CaptureFileHeader layout changed");
+static_assert(sizeof(CaptureRecordHeader) == 16, "CaptureRecordHeader layout changed");
+static_assert(sizeof(CaptureFileHeader) % DIABLO_CAPTURE_ALIGNMENT == 0, "First record must be aligned");
+
+size_t page_size() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+uint64_t realtime_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+//==============================================================================
+// CaptureWriter
+//==============================================================================
+
+CaptureWriter::CaptureWriter()
+    : fd_(-1),
+      map_(nullptr),
+      map_size_(0),
+      preallocate_bytes_(0),
+      sync_interval_bytes_(0),
+      data_end_(0),
+      synced_end_(0),
+      records_(0) {}
+
+CaptureWriter::~CaptureWriter() { close(); }
+
+bool CaptureWriter::open(const char *path, size_t preallocate_bytes, size_t sync_interval_bytes) {
+  close();
+  if (!path) return false;
+
+  fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) return false;
+
+  preallocate_bytes_ = preallocate_bytes < page_size() ? page_size() : preallocate_bytes;
+  sync_interval_bytes_ = sync_interval_bytes;
+  data_end_ = kHeaderSize;
+  synced_end_ = 0;
+  records_ = 0;
+
+  if (!reserve(kHeaderSize)) {
+    const int saved = errno;
+    close();
+    errno = saved;
+    return false;
+  }
+
+  CaptureFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DIABLO_CAPTURE_MAGIC, sizeof(header.magic));
+  header.format_version = DIABLO_CAPTURE_FORMAT_VERSION;
+  header.header_size = kHeaderSize;
+  header.created_ns = realtime_ns();
+  memcpy(map_, &header, sizeof(header));
+  return true;
+}
+
+bool CaptureWriter::reserve(size_t bytes) {
+  if (data_end_ + bytes <= map_size_) return true;
+
+  // Grow in whole preallocation steps
+  size_t new_size = map_size_;
+  while (new_size < data_end_ + bytes) new_size += preallocate_bytes_;
+
+  // posix_fallocate reserves the blocks, so stores into the mapping cannot
+  // fault with SIGBUS on a full disk; fall back to ftruncate on filesystems
+  // without fallocate support
+  const int rc = posix_fallocate(fd_, 0, static_cast<off_t>(new_size));
+  if (rc != 0 && ftruncate(fd_, static_cast<off_t>(new_size)) != 0) return false;
+
+  void *map;
+  if (map_) {
+    map = mremap(map_, map_size_, new_size, MREMAP_MAYMOVE);
+  } else {
+    map = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  }
+  if (map == MAP_FAILED) return false;
+
+  map_ = static_cast<uint8_t *>(map);
+  map_size_ = new_size;
+  return true;
+}
+
+bool CaptureWriter::append(const uint8_t *packet, size_t size, uint32_t source_ip, uint64_t receive_time_ns) {
+  if (fd_ < 0 || !packet || size == 0 || size > UINT32_MAX) return false;
+
+  const size_t record_size = capture_record_size(size);
+  if (!reserve(record_size)) return false;
+
+  CaptureRecordHeader record;
+  record.length = static_cast<uint32_t>(size);
+  record.source_ip = source_ip;
+  record.receive_time_ns = receive_time_ns;
+
+  // Payload first, length last: a reader racing a crash never sees a record
+  // whose length is set but whose bytes are missing (padding is already zero)
+  uint8_t *dst = map_ + data_end_;
+  const size_t length_size = sizeof(record.length);
+  memcpy(dst + sizeof(CaptureRecordHeader), packet, size);
+  memcpy(dst + length_size, reinterpret_cast<const uint8_t *>(&record) + length_size, sizeof(record) - length_size);
+  std::atomic_signal_fence(std::memory_order_release);
+  memcpy(dst, &record.length, length_size);
+
+  data_end_ += record_size;
+  ++records_;
+
+  if (sync_interval_bytes_ && data_end_ - synced_end_ >= sync_interval_bytes_) {
+    write_data_end();
+    msync_range(synced_end_, data_end_, false);
+  }
+  return true;
+}
+
+void CaptureWriter::write_data_end() {
+  memcpy(map_ + offsetof(CaptureFileHeader, data_end), &data_end_, sizeof(data_end_));
+}
+
+bool CaptureWriter::msync_range(uint64_t begin, uint64_t end, bool blocking) {
+  const size_t page = page_size();
+  const uint64_t aligned = begin & ~static_cast<uint64_t>(page - 1);
+  const int flags = blocking ? MS_SYNC : MS_ASYNC;
+
+  // The header page holds data_end and is always included
+  bool ok = msync(map_, page, flags) == 0;
+  if (end > aligned) {
+    ok = msync(map_ + aligned, static_cast<size_t>(end - aligned), flags) == 0 && ok;
+  }
+  synced_end_ = end;
+  return ok;
+}
+
+bool CaptureWriter::sync() {
+  if (fd_ < 0) return false;
+  write_data_end();
+  return msync_range(0, data_end_, true);
+}
+
+bool CaptureWriter::close() {
+  if (fd_ < 0) return true;
+
+  bool ok = true;
+  if (map_) {
+    ok = sync();
+    munmap(map_, map_size_);
+    map_ = nullptr;
+    map_size_ = 0;
+  }
+  // Drop unused preallocated space
+  ok = ftruncate(fd_, static_cast<off_t>(data_end_)) == 0 && ok;
+  ok = ::close(fd_) == 0 && ok;
+  fd_ = -1;
+  return ok;
+}
+
+//==============================================================================
+// CaptureReader
+//==============================================================================
+
+CaptureReader::CaptureReader() : map_(nullptr), map_size_(0), position_(0) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+CaptureReader::~CaptureReader() { close(); }
+
+bool CaptureReader::open(const char *path) {
+  close();
+  if (!path) return false;
+
+  const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+    ::close(fd);
+    return false;
+  }
+
+  void *map = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd); // The mapping keeps the file alive
+  if (map == MAP_FAILED) return false;
+
+  map_ = static_cast<const uint8_t *>(map);
+  map_size_ = static_cast<size_t>(st.st_size);
+  madvise(const_cast<uint8_t *>(map_), map_size_, MADV_SEQUENTIAL);
+
+  memcpy(&header_, map_, sizeof(header_));
+  if (memcmp(header_.magic, DIABLO_CAPTURE_MAGIC, sizeof(header_.magic)) != 0 ||
+      header_.format_version != DIABLO_CAPTURE_FORMAT_VERSION || header_.header_size < kHeaderSize ||
+      header_.header_size % DIABLO_CAPTURE_ALIGNMENT != 0) {
+    close();
+    return false;
+  }
+
+  rewind();
+  return true;
+}
+
+void CaptureReader::close() {
+  if (map_) {
+    munmap(const_cast<uint8_t *>(map_), map_size_);
+  }
+  map_ = nullptr;
+  map_size_ = 0;
+  position_ = 0;
+}
+
+void CaptureReader::rewind() { position_ = header_.header_size; }
+
+bool CaptureReader::read_at(uint64_t offset, CaptureRecord &record_out) const {
+  if (!map_ || offset % DIABLO_CAPTURE_ALIGNMENT != 0) return false;
+  if (offset + sizeof(CaptureRecordHeader) > map_size_) return false;
+
+  CaptureRecordHeader record;
+  memcpy(&record, map_ + offset, sizeof(record));
+  if (record.length == 0) return false; // End of data
+  if (offset + capture_record_size(record.length) > map_size_) return false;
+
+  record_out.data = map_ + offset + sizeof(CaptureRecordHeader);
+  record_out.size = record.length;
+  record_out.source_ip = record.source_ip;
+  record_out.receive_time_ns = record.receive_time_ns;
+  record_out.offset = offset;
+  return true;
+}
+
+bool CaptureReader::next(CaptureRecord &record_out) {
+  if (!read_at(position_, record_out)) return false;
+  position_ += capture_record_size(record_out.size);
+  return true;
+}
+
+bool CaptureReader::seek(uint64_t offset, CaptureRecord &record_out) {
+  if (!read_at(offset, record_out)) return false;
+  position_ = offset + capture_record_size(record_out.size);
+  return true;
+}
+
+} // namespace Diablo
+
+#endif // __linux__
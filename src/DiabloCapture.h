@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stddef.h> // For size_t
+#include <stdint.h> // For standard integer types
+
+//==============================================================================
+// PACKET CAPTURE FILES (Linux hosts only)
+//
+// Append-only log of raw datagrams as received by the ground station, so a
+// test can be replayed through dispatch_packet() / parse_* later.
+//
+// File layout (all integers little-endian):
+//   CaptureFileHeader (32 bytes)
+//   Records, each starting on an 8-byte boundary:
+//     CaptureRecordHeader (16 bytes) + datagram bytes + zero padding
+//
+// The writer maps a preallocated region and grows it in preallocation steps;
+// msync is batched every sync_interval_bytes. Unused preallocated space is
+// zero, so a record length of 0 marks the end of data even if the writer
+// never got to close the file. The reader maps the whole file and hands out
+// pointers straight into the mapping.
+//==============================================================================
+
+#if defined(__linux__)
+
+namespace Diablo {
+
+#define DIABLO_CAPTURE_MAGIC "DIABLCAP"
+#define DIABLO_CAPTURE_FORMAT_VERSION 1
+#define DIABLO_CAPTURE_ALIGNMENT 8
+
+/**
+ * @brief First 32 bytes of a capture file.
+ */
+struct __attribute__((packed)) CaptureFileHeader {
+  char magic[8];           // DIABLO_CAPTURE_MAGIC, not NUL-terminated
+  uint16_t format_version; // DIABLO_CAPTURE_FORMAT_VERSION
+  uint16_t header_size;    // sizeof(CaptureFileHeader)
+  uint32_t reserved;
+  uint64_t data_end;       // Offset just past the last record (0 until the first sync)
+  uint64_t created_ns;     // CLOCK_REALTIME when the file was created
+};
+
+/**
+ * @brief Prefix of every record in a capture file.
+ */
+struct __attribute__((packed)) CaptureRecordHeader {
+  uint32_t length;          // Datagram bytes that follow (0 marks end of data)
+  uint32_t source_ip;       // IPv4 source as in sockaddr_in.sin_addr.s_addr
+  uint64_t receive_time_ns; // Receive time chosen by the writer (e.g. CLOCK_REALTIME)
+};
+
+/**
+ * @brief One record as returned by CaptureReader.
+ *
+ * data points into the reader's mapping and stays valid until the reader is
+ * closed.
+ */
+struct CaptureRecord {
+  const uint8_t *data;
+  uint32_t size;
+  uint32_t source_ip;
+  uint64_t receive_time_ns;
+  uint64_t offset; // File offset of the record header
+};
+
+/**
+ * @brief Appends datagrams to a memory-mapped capture file.
+ *
+ * Not thread-safe; use one writer per thread or serialize calls.
+ */
+class CaptureWriter {
+ public:
+  CaptureWriter();
+  ~CaptureWriter();
+
+  /**
+   * @brief Create (or truncate) a capture file.
+   * @param path File to write.
+   * @param preallocate_bytes Bytes reserved up front and per growth step.
+   * @param sync_interval_bytes Start an asynchronous msync after this many new
+   * bytes (0 to only sync on sync()/close()).
+   * @return false on any I/O error (errno is left set).
+   */
+  bool open(const char *path, size_t preallocate_bytes = 64u << 20, size_t sync_interval_bytes = 1u << 20);
+
+  /**
+   * @brief Append one datagram.
+   * @return false if the file is not open, size is 0, or growing the file failed.
+   */
+  bool append(const uint8_t *packet, size_t size, uint32_t source_ip, uint64_t receive_time_ns);
+
+  /**
+   * @brief Flush all records to disk and update the header (blocking).
+   */
+  bool sync();
+
+  /**
+   * @brief Sync, trim the file to its data and close it.
+   */
+  bool close();
+
+  bool is_open() const { return fd_ >= 0; }
+  uint64_t data_end() const { return data_end_; }
+  uint64_t records() const { return records_; }
+
+ private:
+  CaptureWriter(const CaptureWriter &);
+  CaptureWriter &operator=(const CaptureWriter &);
+
+  bool reserve(size_t bytes);
+  bool msync_range(uint64_t begin, uint64_t end, bool blocking);
+  void write_data_end();
+
+  int fd_;
+  uint8_t *map_;
+  size_t map_size_;
+  size_t preallocate_bytes_;
+  size_t sync_interval_bytes_;
+  uint64_t data_end_;
+  uint64_t synced_end_; // Data below this offset has had msync started
+  uint64_t records_;
+};
+
+/**
+ * @brief Iterates the records of a capture file without copying.
+ *
+ * Typical use:
+ * @code
+ *   CaptureReader reader;
+ *   reader.open("hotfire.cap");
+ *   CaptureRecord record;
+ *   while (reader.next(record)) {
+ *     dispatch_packet(record.data, record.size, handler);
+ *   }
+ * @endcode
+ */
+class CaptureReader {
+ public:
+  CaptureReader();
+  ~CaptureReader();
+
+  /**
+   * @brief Map a capture file read-only.
+   * @return false on I/O error or if the file is not a capture file.
+   */
+  bool open(const char *path);
+  void close();
+
+  /**
+   * @brief Read the next record.
+   * @return false at end of data (or at a truncated record).
+   */
+  bool next(CaptureRecord &record_out);
+
+  /**
+   * @brief Read the record at a file offset (as in CaptureRecord.offset) and
+   * continue iterating from there.
+   * @return false if no valid record starts at offset.
+   */
+  bool seek(uint64_t offset, CaptureRecord &record_out);
+
+  /**
+   * @brief Read the record at a file offset without moving the iteration
+   * position. Safe to call from several threads at once.
+   * @return false if no valid record starts at offset.
+   */
+  bool read_at(uint64_t offset, CaptureRecord &record_out) const;
+
+  /**
+   * @brief Restart iteration at the first record.
+   */
+  void rewind();
+
+  bool is_open() const { return map_ != nullptr; }
+  const uint8_t *data() const { return map_; }
+  size_t size() const { return map_size_; }
+  const CaptureFileHeader &header() const { return header_; }
+
+ private:
+  CaptureReader(const CaptureReader &);
+  CaptureReader &operator=(const CaptureReader &);
+
+  const uint8_t *map_;
+  size_t map_size_;
+  uint64_t position_;
+  CaptureFileHeader header_;
+};
+
+/**
+ * @brief Record header plus datagram, rounded up to DIABLO_CAPTURE_ALIGNMENT.
+ */
+inline size_t capture_record_size(size_t packet_size) {
+  const size_t raw = sizeof(CaptureRecordHeader) + packet_size;
+  return (raw + DIABLO_CAPTURE_ALIGNMENT - 1) & ~static_cast<size_t>(DIABLO_CAPTURE_ALIGNMENT - 1);
+}
+
+} // namespace Diablo
+
+#endif // __linux__
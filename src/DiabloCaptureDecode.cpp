@@ -0,0 +1,513 @@
+#include "DiabloCaptureDecode.h"
+
+#if defined(__linux__)
+
+#include "DAQv2-Comms.h"
+#include <cstring>      // For memset
+#include <cstddef>      // For size_t, offsetof
+#include <algorithm>    // For std::sort, std::stable_sort, std::lower_bound, std::push_heap
+#include <deque>        // For std::deque
+#include <mutex>        // For std::mutex
+#include <system_error> // For std::system_error
+#include <thread>       // For std::thread
+
+namespace Diablo {
+
+namespace {
+
+// Each board's timestamps are its own clock, so rows are only ordered by
+// timestamp within a board: segments and the merge are keyed (source_ip, timestamp)
+bool row_before(const SensorRow &a, const SensorRow &b) {
+  if (a.source_ip != b.source_ip) return a.source_ip < b.source_ip;
+  return a.timestamp < b.timestamp;
+}
+
+bool timestamp_before(const SensorRow &a, const SensorRow &b) { return a.timestamp < b.timestamp; }
+
+// For std::upper_bound over rows grouped by board
+bool ip_before_row(uint32_t source_ip, const SensorRow &row) { return source_ip < row.source_ip; }
+
+// End of the board run that starts at first
+const SensorRow *board_end(const SensorRow *first, const SensorRow *last) {
+  return std::upper_bound(first, last, first->source_ip, ip_before_row);
+}
+
+/**
+ * Per-worker deques of segment indices. The owner takes from the front, so it
+ * walks its share of the file in order; thieves take from the back.
+ */
+class WorkQueues {
+ public:
+  explicit WorkQueues(size_t num_workers) : queues_(num_workers) {}
+
+  void push(size_t worker, size_t task) { queues_[worker].tasks.push_back(task); }
+
+  bool pop(size_t worker, size_t &task_out) {
+    if (take(queues_[worker], true, task_out)) return true;
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      if (take(queues_[(worker + i) % queues_.size()], false, task_out)) return true;
+    }
+    return false; // No task is ever added while workers run, so empty means done
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+  };
+
+  static bool take(Queue &queue, bool front, size_t &task_out) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    if (front) {
+      task_out = queue.tasks.front();
+      queue.tasks.pop_front();
+    } else {
+      task_out = queue.tasks.back();
+      queue.tasks.pop_back();
+    }
+    return true;
+  }
+
+  std::vector<Queue> queues_;
+};
+
+struct SegmentResult {
+  std::vector<SensorRow> rows; // Sorted by (source_ip, timestamp) once decoded
+  uint64_t records;
+  uint64_t sensor_packets;
+  uint64_t rejected;
+};
+
+inline void push_row(std::vector<SensorRow> &rows, uint32_t timestamp, uint32_t source_ip,
+                     const SensorDatapoint &datapoint) {
+  SensorRow row;
+  row.timestamp = timestamp;
+  row.source_ip = source_ip;
+  row.value = datapoint.data;
+  row.sensor_id = datapoint.sensor_id;
+  rows.push_back(row);
+}
+
+struct BoardCount {
+  uint32_t source_ip;
+  uint32_t min_ts;
+  uint32_t max_ts;
+  uint32_t index; // Before sorting by source_ip
+  size_t count;
+  size_t base; // First counting-sort bucket, or first output index
+};
+
+bool board_before(const BoardCount &a, const BoardCount &b) { return a.source_ip < b.source_ip; }
+
+/**
+ * Reused buffers of one worker.
+ */
+struct SortScratch {
+  std::vector<SensorRow> rows;
+  std::vector<uint32_t> counts;
+  std::vector<BoardCount> boards;
+  std::vector<uint32_t> row_board; // Index into boards of each row
+  std::vector<uint32_t> board_rank; // Sorted position of each board index
+};
+
+// Index of source_ip in boards, appending it if new
+uint32_t find_board(std::vector<BoardCount> &boards, uint32_t source_ip) {
+  for (size_t b = 0; b < boards.size(); ++b) {
+    if (boards[b].source_ip == source_ip) return static_cast<uint32_t>(b);
+  }
+  BoardCount board;
+  board.source_ip = source_ip;
+  board.min_ts = 0;
+  board.max_ts = 0;
+  board.index = static_cast<uint32_t>(boards.size());
+  board.count = 0;
+  board.base = 0;
+  boards.push_back(board);
+  return board.index;
+}
+
+/**
+ * Stable sort by (source_ip, timestamp). Boards interleave, so rows arrive
+ * sorted per board but not overall; each board spans few distinct
+ * milliseconds of its own clock in a segment, so one counting sort over the
+ * boards' timestamp ranges, laid end to end, handles it in linear passes.
+ */
+void sort_rows(std::vector<SensorRow> &rows, SortScratch &scratch) {
+  if (rows.empty()) return;
+
+  // Rows come a whole packet per board at a time, so the last board found
+  // is checked first
+  std::vector<BoardCount> &boards = scratch.boards;
+  std::vector<uint32_t> &row_board = scratch.row_board;
+  boards.clear();
+  row_board.resize(rows.size());
+  bool sorted = true;
+  uint32_t board = 0;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const uint32_t ts = rows[i].timestamp;
+    if (board >= boards.size() || boards[board].source_ip != rows[i].source_ip) {
+      board = find_board(boards, rows[i].source_ip);
+    }
+    BoardCount &entry = boards[board];
+    if (entry.count == 0 || ts < entry.min_ts) entry.min_ts = ts;
+    if (entry.count == 0 || ts > entry.max_ts) entry.max_ts = ts;
+    ++entry.count;
+    row_board[i] = board;
+    sorted = sorted && (i == 0 || !row_before(rows[i], rows[i - 1]));
+  }
+  if (sorted) return;
+
+  std::sort(boards.begin(), boards.end(), board_before);
+  scratch.board_rank.resize(boards.size());
+  size_t buckets = 0;
+  for (size_t b = 0; b < boards.size(); ++b) {
+    scratch.board_rank[boards[b].index] = static_cast<uint32_t>(b);
+    boards[b].base = buckets;
+    buckets += static_cast<size_t>(boards[b].max_ts - boards[b].min_ts) + 1;
+  }
+  for (size_t i = 0; i < rows.size(); ++i) row_board[i] = scratch.board_rank[row_board[i]];
+  scratch.rows.resize(rows.size());
+
+  if (buckets > rows.size()) {
+    // Sparse timestamps (e.g. a board with a bad clock): counting would cost
+    // more than sorting, so only group by board and sort each group
+    size_t offset = 0;
+    for (size_t b = 0; b < boards.size(); ++b) {
+      boards[b].base = offset;
+      offset += boards[b].count;
+    }
+    for (size_t i = 0; i < rows.size(); ++i) scratch.rows[boards[row_board[i]].base++] = rows[i];
+    rows.swap(scratch.rows);
+    for (size_t b = 0, first = 0; b < boards.size(); first += boards[b].count, ++b) {
+      std::stable_sort(rows.begin() + first, rows.begin() + first + boards[b].count, timestamp_before);
+    }
+    return;
+  }
+
+  scratch.counts.assign(buckets + 1, 0);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const BoardCount &entry = boards[row_board[i]];
+    ++scratch.counts[entry.base + (rows[i].timestamp - entry.min_ts) + 1];
+  }
+  for (size_t i = 1; i <= buckets; ++i) scratch.counts[i] += scratch.counts[i - 1];
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const BoardCount &entry = boards[row_board[i]];
+    scratch.rows[scratch.counts[entry.base + (rows[i].timestamp - entry.min_ts)]++] = rows[i];
+  }
+  rows.swap(scratch.rows);
+}
+
+void decode_segment(const CaptureReader &reader, const CaptureSegment &segment, SegmentResult &result,
+                    SortScratch &scratch) {
+  result.rows.clear();
+  result.records = 0;
+  result.sensor_packets = 0;
+  result.rejected = 0;
+
+  SensorDataView view;
+  CompressedSensorDataView compressed;
+  SensorDatapoint datapoints[MAX_SENSORS_PER_BOARD];
+  CaptureRecord record;
+
+  uint64_t offset = segment.begin_offset;
+  while (offset < segment.end_offset && reader.read_at(offset, record)) {
+    offset += capture_record_size(record.size);
+    ++result.records;
+    if (record.size <= offsetof(PacketHeader, packet_type)) continue;
+
+    const uint8_t type = record.data[offsetof(PacketHeader, packet_type)];
+    if (type == static_cast<uint8_t>(PacketType::SENSOR_DATA)) {
+      if (!parse_sensor_data_view(record.data, record.size, view)) {
+        ++result.rejected;
+        continue;
+      }
+      ++result.sensor_packets;
+      for (size_t i = 0; i < view.num_chunks(); ++i) {
+        const SensorDataChunkView chunk = view.chunk(i);
+        const uint32_t timestamp = chunk.timestamp();
+        const PackedArrayView<SensorDatapoint> points = chunk.datapoints();
+        for (size_t j = 0; j < points.size(); ++j) {
+          push_row(result.rows, timestamp, record.source_ip, points[j]);
+        }
+      }
+    } else if (type == static_cast<uint8_t>(PacketType::SENSOR_DATA_COMPRESSED)) {
+      if (!parse_compressed_sensor_data_view(record.data, record.size, compressed)) {
+        ++result.rejected;
+        continue;
+      }
+      ++result.sensor_packets;
+      uint32_t timestamp;
+      while (compressed.next_chunk(timestamp, datapoints)) {
+        for (size_t j = 0; j < compressed.num_sensors(); ++j) {
+          push_row(result.rows, timestamp, record.source_ip, datapoints[j]);
+        }
+      }
+    }
+  }
+
+  sort_rows(result.rows, scratch);
+}
+
+struct WorkerArgs {
+  const CaptureReader *reader;
+  const CaptureSegment *segments; // First segment of the window
+  SegmentResult *results;
+  WorkQueues *queues;
+};
+
+void worker_main(WorkerArgs args, size_t worker) {
+  SortScratch scratch;
+  size_t task;
+  while (args.queues->pop(worker, task)) {
+    decode_segment(*args.reader, args.segments[task], args.results[task], scratch);
+  }
+}
+
+/**
+ * Decode results[0, count) for segments[0, count) on up to num_threads
+ * threads (including the calling one).
+ */
+void decode_window(const CaptureReader &reader, const CaptureSegment *segments, SegmentResult *results,
+                   size_t count, size_t num_threads) {
+  if (num_threads > count) num_threads = count;
+  WorkQueues queues(num_threads);
+  // Contiguous shares keep each worker's reads sequential
+  for (size_t w = 0; w < num_threads; ++w) {
+    for (size_t i = w * count / num_threads; i < (w + 1) * count / num_threads; ++i) queues.push(w, i);
+  }
+
+  WorkerArgs args;
+  args.reader = &reader;
+  args.segments = segments;
+  args.results = results;
+  args.queues = &queues;
+
+  std::vector<std::thread> threads;
+  try {
+    threads.reserve(num_threads - 1);
+    for (size_t w = 1; w < num_threads; ++w) threads.push_back(std::thread(worker_main, args, w));
+  } catch (const std::system_error &) {
+    // Out of threads: the running workers steal the orphaned queues
+  }
+  worker_main(args, 0);
+  for (size_t i = 0; i < threads.size(); ++i) threads[i].join();
+}
+
+struct MergeCursor {
+  const SensorRow *pos;
+  const SensorRow *end;
+  size_t segment; // Breaks timestamp ties in capture order
+};
+
+// Heap comparator: true if a comes after b, so the heap top is the earliest row
+bool cursor_after(const MergeCursor &a, const MergeCursor &b) {
+  if (row_before(*b.pos, *a.pos)) return true;
+  if (row_before(*a.pos, *b.pos)) return false;
+  return a.segment > b.segment;
+}
+
+/**
+ * Earliest timestamp of one board in the next window: that board's rows at
+ * or past it are carried over.
+ */
+struct BoardLimit {
+  uint32_t source_ip;
+  uint32_t timestamp;
+};
+
+bool limit_before(const BoardLimit &a, const BoardLimit &b) {
+  if (a.source_ip != b.source_ip) return a.source_ip < b.source_ip;
+  return a.timestamp < b.timestamp;
+}
+
+bool limit_ip_before(const BoardLimit &limit, uint32_t source_ip) { return limit.source_ip < source_ip; }
+
+/**
+ * One BoardLimit per board with rows in results[0, count), sorted by source_ip.
+ */
+void find_board_limits(const SegmentResult *results, size_t count, std::vector<BoardLimit> &limits_out) {
+  limits_out.clear();
+  for (size_t i = 0; i < count; ++i) {
+    const std::vector<SensorRow> &rows = results[i].rows;
+    if (rows.empty()) continue;
+    const SensorRow *const end = &rows[0] + rows.size();
+    for (const SensorRow *first = &rows[0]; first != end; first = board_end(first, end)) {
+      BoardLimit limit;
+      limit.source_ip = first->source_ip;
+      limit.timestamp = first->timestamp; // The board's earliest in this segment
+      limits_out.push_back(limit);
+    }
+  }
+  std::sort(limits_out.begin(), limits_out.end(), limit_before);
+
+  // Keep the earliest per board
+  size_t kept = 0;
+  for (size_t i = 0; i < limits_out.size(); ++i) {
+    if (kept == 0 || limits_out[kept - 1].source_ip != limits_out[i].source_ip) limits_out[kept++] = limits_out[i];
+  }
+  limits_out.resize(kept);
+}
+
+const BoardLimit *find_limit(const std::vector<BoardLimit> &limits, uint32_t source_ip) {
+  std::vector<BoardLimit>::const_iterator it =
+      std::lower_bound(limits.begin(), limits.end(), source_ip, limit_ip_before);
+  return it != limits.end() && it->source_ip == source_ip ? &*it : nullptr;
+}
+
+void add_cursor(std::vector<MergeCursor> &heap, const std::vector<SensorRow> &rows, size_t segment) {
+  if (rows.empty()) return;
+  MergeCursor cursor;
+  cursor.pos = &rows[0];
+  cursor.end = cursor.pos + rows.size();
+  cursor.segment = segment;
+  heap.push_back(cursor);
+}
+
+/**
+ * Merge carry and results[0, count). A board's rows below its limit go to
+ * the sink; the rest (still sorted) replace carry for the next window. Boards
+ * without a limit are emitted in full.
+ * @return The number of rows handed to the sink.
+ */
+uint64_t merge_window(std::vector<SensorRow> &carry, std::vector<SensorRow> &next_carry,
+                      const SegmentResult *results, size_t count, const std::vector<BoardLimit> &limits,
+                      SensorRowSink sink, void *context) {
+  // Carried rows come from earlier windows and win ties
+  std::vector<MergeCursor> heap;
+  heap.reserve(count + 1);
+  add_cursor(heap, carry, 0);
+  for (size_t i = 0; i < count; ++i) add_cursor(heap, results[i].rows, i + 1);
+  std::make_heap(heap.begin(), heap.end(), cursor_after);
+
+  next_carry.clear();
+  uint64_t rows = 0;
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), cursor_after);
+    MergeCursor &cursor = heap.back();
+
+    // Take the whole run that precedes the next cursor's head
+    const SensorRow *run_end = cursor.end;
+    if (heap.size() > 1) {
+      const MergeCursor &next = heap.front();
+      if (cursor.segment > next.segment) {
+        run_end = std::lower_bound(cursor.pos, cursor.end, *next.pos, row_before);
+      } else {
+        run_end = std::upper_bound(cursor.pos, cursor.end, *next.pos, row_before);
+      }
+    }
+
+    // A run may span several boards; each is split at its own limit
+    while (cursor.pos != run_end) {
+      const SensorRow *end = board_end(cursor.pos, run_end);
+      const SensorRow *split = end;
+      const BoardLimit *limit = find_limit(limits, cursor.pos->source_ip);
+      if (limit) {
+        SensorRow limit_row = *cursor.pos;
+        limit_row.timestamp = limit->timestamp;
+        split = std::lower_bound(cursor.pos, end, limit_row, timestamp_before);
+      }
+      if (split != cursor.pos) {
+        const size_t n = static_cast<size_t>(split - cursor.pos);
+        sink(cursor.pos, n, context);
+        rows += n;
+      }
+      next_carry.insert(next_carry.end(), split, end);
+      cursor.pos = end;
+    }
+
+    if (cursor.pos == cursor.end) {
+      heap.pop_back();
+    } else {
+      std::push_heap(heap.begin(), heap.end(), cursor_after);
+    }
+  }
+  return rows;
+}
+
+} // namespace
+
+size_t split_capture_segments(const CaptureReader &reader, size_t segment_bytes,
+                              std::vector<CaptureSegment> &segments_out) {
+  segments_out.clear();
+  if (!reader.is_open()) return 0;
+  if (segment_bytes == 0) segment_bytes = DIABLO_CAPTURE_DECODE_SEGMENT_BYTES;
+
+  CaptureSegment segment;
+  segment.begin_offset = reader.header().header_size;
+  uint64_t offset = segment.begin_offset;
+  CaptureRecord record;
+  while (reader.read_at(offset, record)) {
+    offset += capture_record_size(record.size);
+    if (offset - segment.begin_offset >= segment_bytes) {
+      segment.end_offset = offset;
+      segments_out.push_back(segment);
+      segment.begin_offset = offset;
+    }
+  }
+  if (offset > segment.begin_offset) {
+    segment.end_offset = offset;
+    segments_out.push_back(segment);
+  }
+  return segments_out.size();
+}
+
+bool decode_capture_parallel(const CaptureReader &reader, const ParallelDecodeOptions &options,
+                             SensorRowSink sink, void *context, ParallelDecodeStats *stats_out) {
+  if (stats_out) memset(stats_out, 0, sizeof(*stats_out));
+  if (!reader.is_open() || !sink) return false;
+
+  size_t num_threads = options.num_threads ? options.num_threads : std::thread::hardware_concurrency();
+  if (num_threads == 0) num_threads = 1;
+  const size_t window = options.window_segments ? options.window_segments : 4 * num_threads;
+
+  std::vector<CaptureSegment> segments;
+  split_capture_segments(reader, options.segment_bytes, segments);
+
+  ParallelDecodeStats stats;
+  memset(&stats, 0, sizeof(stats));
+  stats.segments = segments.size();
+
+  // Window k + 1 is decoded before window k is merged: rows of window k at or
+  // past their board's earliest timestamp in window k + 1 are carried over and
+  // merged with it, so packets that straddle a window boundary still come out
+  // in order
+  const size_t buffer_size = segments.size() < window ? segments.size() : window;
+  std::vector<SegmentResult> current(buffer_size);
+  std::vector<SegmentResult> upcoming(buffer_size);
+  std::vector<SensorRow> carry;
+  std::vector<SensorRow> next_carry;
+  std::vector<BoardLimit> limits;
+
+  size_t count = segments.size() < window ? segments.size() : window;
+  if (count) decode_window(reader, &segments[0], &current[0], count, num_threads);
+  for (size_t first = 0; first < segments.size(); first += window) {
+    const size_t next_first = first + count;
+    const size_t next_count =
+        segments.size() - next_first < window ? segments.size() - next_first : window;
+
+    limits.clear();
+    if (next_count) {
+      decode_window(reader, &segments[next_first], &upcoming[0], next_count, num_threads);
+      find_board_limits(&upcoming[0], next_count, limits);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      stats.records += current[i].records;
+      stats.sensor_packets += current[i].sensor_packets;
+      stats.rejected += current[i].rejected;
+    }
+    stats.rows += merge_window(carry, next_carry, &current[0], count, limits, sink, context);
+    if (next_carry.size() > stats.max_carry_rows) stats.max_carry_rows = next_carry.size();
+    carry.swap(next_carry);
+    current.swap(upcoming);
+    count = next_count;
+  }
+
+  if (stats_out) *stats_out = stats;
+  return true;
+}
+
+} // namespace Diablo
+
+#endif // __linux__
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "DiabloCapture.h" // For CaptureReader
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+
+//==============================================================================
+// PARALLEL CAPTURE DECODE (Linux hosts only)
+//
+// Offline decode of the sensor data in a capture file into flat rows:
+//   1. split_capture_segments() walks the 16-byte record headers once and
+//      cuts the file into record-aligned segments of about segment_bytes.
+//   2. Worker threads decode segments with parse_sensor_data_view() /
+//      parse_compressed_sensor_data_view() and sort each segment's rows by
+//      board, then sample timestamp. Every worker owns a deque of segments
+//      and steals from the others once its own runs dry, so a few dense
+//      segments (a firing) do not leave the other cores idle.
+//   3. A k-way merge hands the rows to the sink, each board's in timestamp
+//      order. Rows within one segment are sorted and neighbouring segments
+//      rarely overlap, so the merge emits whole runs and stays cheap.
+//
+// Sample timestamps are board time, and boards boot at different times, so
+// timestamps of different boards are never compared: within a window the
+// boards come out one after another, by source_ip.
+//
+// Segments are processed in windows of window_segments to bound memory; a
+// board's rows that reach into its rows of the next window are carried over
+// and merged with it. Each board's output is ordered unless one of its
+// packets arrives more than a whole window (window_segments * segment_bytes
+// of capture) after its samples were taken; rows with equal timestamps keep
+// their capture order.
+//==============================================================================
+
+#if defined(__linux__)
+
+#include <vector> // For std::vector
+
+namespace Diablo {
+
+#define DIABLO_CAPTURE_DECODE_SEGMENT_BYTES (8u << 20)
+
+/**
+ * @brief One decoded sensor sample.
+ */
+struct SensorRow {
+  uint32_t timestamp; // Chunk timestamp (board time, ms)
+  uint32_t source_ip; // Board that sent the packet
+  uint32_t value;     // Raw sensor value
+  uint8_t sensor_id;
+};
+
+/**
+ * @brief Record-aligned byte range [begin_offset, end_offset) of a capture file.
+ */
+struct CaptureSegment {
+  uint64_t begin_offset;
+  uint64_t end_offset;
+};
+
+/**
+ * @brief Receives merged rows in batches; every batch holds one board's rows
+ * in timestamp order.
+ *
+ * rows is only valid during the call. Called from the thread that called
+ * decode_capture_parallel().
+ */
+typedef void (*SensorRowSink)(const SensorRow *rows, size_t count, void *context);
+
+struct ParallelDecodeOptions {
+  unsigned num_threads;   // 0 = std::thread::hardware_concurrency()
+  size_t segment_bytes;   // Target segment size
+  size_t window_segments; // Segments decoded before merging (0 = 4 per thread)
+
+  ParallelDecodeOptions()
+      : num_threads(0), segment_bytes(DIABLO_CAPTURE_DECODE_SEGMENT_BYTES), window_segments(0) {}
+};
+
+struct ParallelDecodeStats {
+  uint64_t records;        // Records read
+  uint64_t sensor_packets; // (Compressed) Sensor Data packets decoded
+  uint64_t rejected;       // Sensor Data packets that failed to parse
+  uint64_t rows;           // Rows handed to the sink
+  size_t segments;
+  size_t max_carry_rows;   // Most rows held over from one window to the next
+};
+
+/**
+ * @brief Split a capture file into record-aligned segments.
+ * @param segment_bytes Target size; a segment ends at the first record
+ * boundary at or past it.
+ * @return The number of segments (0 for an empty or closed file).
+ */
+size_t split_capture_segments(const CaptureReader &reader, size_t segment_bytes,
+                              std::vector<CaptureSegment> &segments_out);
+
+/**
+ * @brief Decode every Sensor Data and Compressed Sensor Data packet of a
+ * capture file on a thread pool and hand the rows to sink, each board's in
+ * timestamp order.
+ *
+ * Does not move the reader's iteration position.
+ *
+ * If fewer threads can be started than requested, the ones that did start
+ * take over the remaining work.
+ *
+ * @return false if the reader is not open or sink is null.
+ */
+bool decode_capture_parallel(const CaptureReader &reader, const ParallelDecodeOptions &options,
+                             SensorRowSink sink, void *context, ParallelDecodeStats *stats_out = nullptr);
+
+} // namespace Diablo
+
+#endif // __linux__
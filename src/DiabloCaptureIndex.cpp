@@ -0,0 +1,208 @@
+#include "DiabloCaptureIndex.h"
+
+#if defined(__linux__)
+
+#include "DAQv2-Comms.h"
+#include <cstdio>  // For FILE, fopen
+#include <cstring> // For memcpy, memcmp
+#include <cstddef> // For size_t, offsetof
+
+namespace Diablo {
+
+namespace {
+
+struct __attribute__((packed)) IndexFileHeader {
+  char magic[8];           // DIABLO_CAPTURE_INDEX_MAGIC, not NUL-terminated
+  uint16_t format_version; // DIABLO_CAPTURE_INDEX_FORMAT_VERSION
+  uint16_t entry_size;     // sizeof(IndexFileEntry)
+  uint32_t reserved;
+  uint64_t bucket_ns;
+  uint64_t num_entries;
+};
+
+struct __attribute__((packed)) IndexFileEntry {
+  uint64_t bucket;
+  uint64_t first_offset;
+  uint64_t last_offset;
+  uint32_t count;
+  uint32_t source_ip;
+  uint8_t packet_type;
+  uint8_t reserved[7];
+};
+
+static_assert(sizeof(IndexFileHeader) == 32, "IndexFileHeader layout changed");
+static_assert(sizeof(IndexFileEntry) == 40, "IndexFileEntry layout changed");
+
+} // namespace
+
+CaptureIndex::CaptureIndex(uint64_t bucket_ns)
+    : bucket_ns_(bucket_ns ? bucket_ns : 1), last_(entries_.end()) {}
+
+void CaptureIndex::clear() {
+  entries_.clear();
+  last_ = entries_.end();
+}
+
+void CaptureIndex::add(uint64_t offset, uint32_t source_ip, uint8_t packet_type, uint64_t receive_time_ns) {
+  Key key;
+  key.source_ip = source_ip;
+  key.packet_type = packet_type;
+  key.bucket = receive_time_ns / bucket_ns_;
+
+  // Fast path: same board, type and bucket as the previous record
+  if (last_ == entries_.end() || last_->first.source_ip != source_ip ||
+      last_->first.packet_type != packet_type || last_->first.bucket != key.bucket) {
+    EntryMap::iterator it = entries_.lower_bound(key);
+    if (it == entries_.end() || key < it->first) {
+      CaptureIndexEntry entry;
+      entry.first_offset = offset;
+      entry.last_offset = offset;
+      entry.count = 0;
+      it = entries_.insert(it, EntryMap::value_type(key, entry));
+    }
+    last_ = it;
+  }
+
+  CaptureIndexEntry &entry = last_->second;
+  if (offset < entry.first_offset) entry.first_offset = offset;
+  if (offset > entry.last_offset) entry.last_offset = offset;
+  ++entry.count;
+}
+
+void CaptureIndex::add(const CaptureRecord &record) {
+  const uint8_t type = record.size > offsetof(PacketHeader, packet_type)
+                           ? record.data[offsetof(PacketHeader, packet_type)]
+                           : 0;
+  add(record.offset, record.source_ip, type, record.receive_time_ns);
+}
+
+size_t CaptureIndex::build(CaptureReader &reader) {
+  clear();
+  size_t count = 0;
+  CaptureRecord record;
+  reader.rewind();
+  while (reader.next(record)) {
+    add(record);
+    ++count;
+  }
+  reader.rewind();
+  return count;
+}
+
+const CaptureIndexEntry *CaptureIndex::find(uint32_t source_ip, PacketType type, uint64_t receive_time_ns) const {
+  Key key;
+  key.source_ip = source_ip;
+  key.packet_type = static_cast<uint8_t>(type);
+  key.bucket = receive_time_ns / bucket_ns_;
+  EntryMap::const_iterator it = entries_.find(key);
+  return it == entries_.end() ? nullptr : &it->second;
+}
+
+size_t CaptureIndex::query(CaptureReader &reader, uint32_t source_ip, PacketType type, uint64_t begin_ns,
+                           uint64_t end_ns, CaptureRecordVisitor visitor, void *context) const {
+  if (!visitor || begin_ns > end_ns) return 0;
+
+  // Offset range covering every bucket that overlaps [begin_ns, end_ns]
+  Key key;
+  key.source_ip = source_ip;
+  key.packet_type = static_cast<uint8_t>(type);
+  key.bucket = begin_ns / bucket_ns_;
+  const uint64_t last_bucket = end_ns / bucket_ns_;
+
+  uint64_t first_offset = UINT64_MAX;
+  uint64_t last_offset = 0;
+  for (EntryMap::const_iterator it = entries_.lower_bound(key);
+       it != entries_.end() && it->first.source_ip == source_ip && it->first.packet_type == key.packet_type &&
+       it->first.bucket <= last_bucket;
+       ++it) {
+    if (it->second.first_offset < first_offset) first_offset = it->second.first_offset;
+    if (it->second.last_offset > last_offset) last_offset = it->second.last_offset;
+  }
+  if (first_offset == UINT64_MAX) return 0;
+
+  // Walk the candidate range, checking only record headers and the type byte
+  size_t visited = 0;
+  CaptureRecord record;
+  bool ok = reader.seek(first_offset, record);
+  while (ok && record.offset <= last_offset) {
+    if (record.source_ip == source_ip && record.receive_time_ns >= begin_ns && record.receive_time_ns <= end_ns &&
+        record.size > offsetof(PacketHeader, packet_type) &&
+        record.data[offsetof(PacketHeader, packet_type)] == key.packet_type) {
+      ++visited;
+      if (!visitor(record, context)) break;
+    }
+    ok = reader.next(record);
+  }
+  return visited;
+}
+
+bool CaptureIndex::save(const char *path) const {
+  if (!path) return false;
+  FILE *file = fopen(path, "wb");
+  if (!file) return false;
+
+  IndexFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DIABLO_CAPTURE_INDEX_MAGIC, sizeof(header.magic));
+  header.format_version = DIABLO_CAPTURE_INDEX_FORMAT_VERSION;
+  header.entry_size = sizeof(IndexFileEntry);
+  header.bucket_ns = bucket_ns_;
+  header.num_entries = entries_.size();
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+  // Entries are written in key order, so load() can append without searching
+  for (EntryMap::const_iterator it = entries_.begin(); ok && it != entries_.end(); ++it) {
+    IndexFileEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.bucket = it->first.bucket;
+    entry.first_offset = it->second.first_offset;
+    entry.last_offset = it->second.last_offset;
+    entry.count = it->second.count;
+    entry.source_ip = it->first.source_ip;
+    entry.packet_type = it->first.packet_type;
+    ok = fwrite(&entry, sizeof(entry), 1, file) == 1;
+  }
+
+  ok = fclose(file) == 0 && ok;
+  return ok;
+}
+
+bool CaptureIndex::load(const char *path) {
+  if (!path) return false;
+  FILE *file = fopen(path, "rb");
+  if (!file) return false;
+
+  IndexFileHeader header;
+  bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+            memcmp(header.magic, DIABLO_CAPTURE_INDEX_MAGIC, sizeof(header.magic)) == 0 &&
+            header.format_version == DIABLO_CAPTURE_INDEX_FORMAT_VERSION &&
+            header.entry_size == sizeof(IndexFileEntry) && header.bucket_ns != 0;
+
+  if (ok) {
+    clear();
+    bucket_ns_ = header.bucket_ns;
+    for (uint64_t i = 0; ok && i < header.num_entries; ++i) {
+      IndexFileEntry entry;
+      ok = fread(&entry, sizeof(entry), 1, file) == 1;
+      if (!ok) break;
+
+      Key key;
+      key.source_ip = entry.source_ip;
+      key.packet_type = entry.packet_type;
+      key.bucket = entry.bucket;
+      CaptureIndexEntry value;
+      value.first_offset = entry.first_offset;
+      value.last_offset = entry.last_offset;
+      value.count = entry.count;
+      entries_.insert(entries_.end(), EntryMap::value_type(key, value));
+    }
+    if (!ok) clear();
+  }
+
+  fclose(file);
+  return ok;
+}
+
+} // namespace Diablo
+
+#endif // __linux__
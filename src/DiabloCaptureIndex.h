@@ -0,0 +1,132 @@
+#pragma once
+
+#include "DiabloCapture.h" // For CaptureReader, CaptureRecord
+#include "DiabloEnums.h"   // For PacketType
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+
+//==============================================================================
+// CAPTURE INDEX (Linux hosts only)
+//
+// Sidecar index for a capture file: for every (source IP, packet type, time
+// bucket) it stores the offsets of the first and last matching record. A
+// range query binary-searches the index, seeks straight to the first
+// candidate record and only walks the records of the buckets it needs,
+// checking each record's 16-byte header and type byte before handing it out.
+//
+// The index can be built while capturing (add() after every append) or
+// afterwards from the capture file (build()), and saved next to it.
+//==============================================================================
+
+#if defined(__linux__)
+
+#include <map> // For std::map
+
+namespace Diablo {
+
+#define DIABLO_CAPTURE_INDEX_MAGIC "DIABLIDX"
+#define DIABLO_CAPTURE_INDEX_FORMAT_VERSION 1
+#define DIABLO_CAPTURE_INDEX_DEFAULT_BUCKET_NS 100000000ull // 100 ms
+
+/**
+ * @brief Records of one (source IP, packet type, time bucket).
+ */
+struct CaptureIndexEntry {
+  uint64_t first_offset; // Capture file offset of the first matching record
+  uint64_t last_offset;  // ... and of the last one
+  uint32_t count;        // Matching records
+};
+
+/**
+ * @brief Called for every record a query returns.
+ * @return false to stop the query early.
+ */
+typedef bool (*CaptureRecordVisitor)(const CaptureRecord &record, void *context);
+
+/**
+ * @brief Time/board index over one capture file.
+ *
+ * Typical use ("board 10.0.0.7 sensor data from T-5 s to T+20 s"):
+ * @code
+ *   CaptureIndex index;
+ *   if (!index.load("hotfire.cap.idx")) index.build(reader);
+ *   index.query(reader, board_ip, PacketType::SENSOR_DATA, t0 - 5 * kSecond, t0 + 20 * kSecond,
+ *               visit, &context);  // visit() calls parse_sensor_data_view() etc.
+ * @endcode
+ */
+class CaptureIndex {
+ public:
+  /**
+   * @param bucket_ns Width of a time bucket in nanoseconds of receive time.
+   */
+  explicit CaptureIndex(uint64_t bucket_ns = DIABLO_CAPTURE_INDEX_DEFAULT_BUCKET_NS);
+
+  /**
+   * @brief Index one record (call in capture order).
+   * @param offset The record's capture file offset (CaptureWriter::data_end()
+   * just before the append).
+   */
+  void add(uint64_t offset, uint32_t source_ip, uint8_t packet_type, uint64_t receive_time_ns);
+  void add(const CaptureRecord &record);
+
+  /**
+   * @brief Rebuild the index from every record of a capture file.
+   * @return The number of records indexed.
+   */
+  size_t build(CaptureReader &reader);
+
+  /**
+   * @brief Visit every record from source_ip of the given type received in
+   * [begin_ns, end_ns], in capture order.
+   * @return The number of records visited.
+   */
+  size_t query(CaptureReader &reader, uint32_t source_ip, PacketType type, uint64_t begin_ns,
+               uint64_t end_ns, CaptureRecordVisitor visitor, void *context) const;
+
+  /**
+   * @brief Look up one bucket.
+   * @return nullptr if no record falls into it.
+   */
+  const CaptureIndexEntry *find(uint32_t source_ip, PacketType type, uint64_t receive_time_ns) const;
+
+  /**
+   * @brief Write the index to a sidecar file.
+   */
+  bool save(const char *path) const;
+
+  /**
+   * @brief Replace this index with one read from a sidecar file.
+   * @return false on I/O error or if the file is not an index.
+   */
+  bool load(const char *path);
+
+  void clear();
+
+  uint64_t bucket_ns() const { return bucket_ns_; }
+  size_t size() const { return entries_.size(); }
+
+ private:
+  CaptureIndex(const CaptureIndex &);
+  CaptureIndex &operator=(const CaptureIndex &);
+
+  struct Key {
+    uint32_t source_ip;
+    uint8_t packet_type;
+    uint64_t bucket;
+
+    bool operator<(const Key &other) const {
+      if (source_ip != other.source_ip) return source_ip < other.source_ip;
+      if (packet_type != other.packet_type) return packet_type < other.packet_type;
+      return bucket < other.bucket;
+    }
+  };
+  typedef std::map<Key, CaptureIndexEntry> EntryMap;
+
+  uint64_t bucket_ns_;
+  EntryMap entries_;
+  EntryMap::iterator last_; // Most recently updated entry; consecutive records usually share it
+};
+
+} // namespace Diablo
+
+#endif // __linux__
@@ -0,0 +1,201 @@
+#include "DiabloCaptureReplay.h"
+
+#if defined(__linux__)
+
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy, memset
+#include <cstddef> // For size_t, offsetof
+#include <vector>  // For std::vector
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace Diablo {
+
+namespace {
+
+const size_t kBatchSize = 64;
+const size_t kMaxDatagram = 65507;        // Largest IPv4 UDP payload
+const uint64_t kSpinThresholdNs = 100000; // Closer deadlines are spun on, not slept on
+const int kSendBufferBytes = 4 << 20;
+
+uint64_t monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * Sleep until shortly before the deadline, then spin: clock_nanosleep alone
+ * oversleeps by the timer slack (about 50 us), which would cap high speed
+ * factors.
+ */
+uint64_t wait_until(uint64_t deadline_ns) {
+  uint64_t now = monotonic_ns();
+  if (deadline_ns > now + kSpinThresholdNs) {
+    const uint64_t wake = deadline_ns - kSpinThresholdNs;
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(wake / 1000000000ull);
+    ts.tv_nsec = static_cast<long>(wake % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+    now = monotonic_ns();
+  }
+  while (now < deadline_ns) now = monotonic_ns();
+  return now;
+}
+
+/**
+ * Copy a packet into out with a new header timestamp, re-signing the CRC
+ * trailer if the original one was valid.
+ */
+void rewrite_timestamp(const uint8_t *packet, size_t size, uint32_t timestamp, uint8_t *out) {
+  memcpy(out, packet, size);
+  if (size < sizeof(PacketHeader)) return;
+  memcpy(out + offsetof(PacketHeader, timestamp), &timestamp, sizeof(timestamp));
+
+  uint8_t &version = out[offsetof(PacketHeader, version)];
+  if ((version & DIABLO_VERSION_FLAG_CRC32C) && verify_crc_trailer(packet, size)) {
+    version = static_cast<uint8_t>(version & ~DIABLO_VERSION_FLAG_CRC32C);
+    append_crc_trailer(out, size - DIABLO_CRC32C_SIZE, size);
+  }
+}
+
+} // namespace
+
+CaptureReplayer::CaptureReplayer() : fd_(-1), address_(0), port_(0) {}
+
+CaptureReplayer::~CaptureReplayer() { close(); }
+
+bool CaptureReplayer::open(const char *address, uint16_t port, bool allow_non_loopback) {
+  close();
+  if (!address) return false;
+
+  struct in_addr addr;
+  if (inet_pton(AF_INET, address, &addr) != 1) return false;
+  if (!allow_non_loopback && (ntohl(addr.s_addr) >> 24) != 127) return false;
+
+  fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) return false;
+
+  // Bursts at high speed factors outrun the default send buffer
+  setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &kSendBufferBytes, sizeof(kSendBufferBytes));
+
+  address_ = addr.s_addr;
+  port_ = port;
+  return true;
+}
+
+void CaptureReplayer::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
+
+bool CaptureReplayer::replay(const CaptureReader &reader, const CaptureReplayOptions &options,
+                             CaptureReplayStats *stats_out) {
+  if (stats_out) memset(stats_out, 0, sizeof(*stats_out));
+  if (fd_ < 0 || !reader.is_open()) return false;
+
+  // Not connected: ICMP port-unreachable from a closed sink would otherwise
+  // fail later sends with ECONNREFUSED
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_port = htons(port_);
+  dest.sin_addr.s_addr = address_;
+
+  struct mmsghdr msgs[kBatchSize];
+  struct iovec iovs[kBatchSize];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < kBatchSize; ++i) {
+    msgs[i].msg_hdr.msg_name = &dest;
+    msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  std::vector<uint8_t> rewritten(options.rewrite_timestamps ? kBatchSize * kMaxDatagram : 0);
+
+  CaptureReplayStats stats;
+  memset(&stats, 0, sizeof(stats));
+
+  uint64_t offset = reader.header().header_size;
+  CaptureRecord record;
+  bool have_record = reader.read_at(offset, record);
+  bool have_first = false;
+  uint64_t first_time_ns = 0;
+
+  const uint64_t start_ns = monotonic_ns();
+  uint64_t now_ns = start_ns;
+  bool done = false;
+  while (!done) {
+    // Gather every packet that is due, sleeping only for the first one
+    size_t count = 0;
+    while (count < kBatchSize) {
+      if (!have_record || (options.max_packets && stats.packets + stats.send_errors + count >= options.max_packets)) {
+        done = true;
+        break;
+      }
+      if ((options.source_ip && record.source_ip != options.source_ip) || record.size > kMaxDatagram) {
+        if (record.size > kMaxDatagram) ++stats.send_errors;
+        offset += capture_record_size(record.size);
+        have_record = reader.read_at(offset, record);
+        continue;
+      }
+
+      if (!have_first) {
+        first_time_ns = record.receive_time_ns;
+        have_first = true;
+      }
+      uint64_t due_ns = start_ns;
+      if (options.speed > 0 && record.receive_time_ns > first_time_ns) {
+        due_ns += static_cast<uint64_t>(static_cast<double>(record.receive_time_ns - first_time_ns) / options.speed);
+      }
+      if (due_ns > now_ns) {
+        if (count) break; // Send what is due now; the next batch waits
+        now_ns = wait_until(due_ns);
+      }
+
+      if (options.rewrite_timestamps) {
+        uint8_t *out = &rewritten[count * kMaxDatagram];
+        const uint32_t timestamp = options.timestamp_base_ms + static_cast<uint32_t>((now_ns - start_ns) / 1000000u);
+        rewrite_timestamp(record.data, record.size, timestamp, out);
+        iovs[count].iov_base = out;
+      } else {
+        iovs[count].iov_base = const_cast<uint8_t *>(record.data);
+      }
+      iovs[count].iov_len = record.size;
+      ++count;
+
+      offset += capture_record_size(record.size);
+      have_record = reader.read_at(offset, record);
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+      const int rc = sendmmsg(fd_, msgs + sent, static_cast<unsigned>(count - sent), 0);
+      if (rc > 0) {
+        for (int i = 0; i < rc; ++i) stats.bytes += iovs[sent + i].iov_len;
+        stats.packets += static_cast<uint64_t>(rc);
+        sent += static_cast<size_t>(rc);
+      } else if (rc < 0 && errno == EINTR) {
+        continue;
+      } else {
+        // The first unsent datagram failed; drop it and carry on
+        ++stats.send_errors;
+        ++sent;
+      }
+    }
+    now_ns = monotonic_ns();
+  }
+
+  stats.elapsed_ns = now_ns - start_ns;
+  if (stats_out) *stats_out = stats;
+  return true;
+}
+
+} // namespace Diablo
+
+#endif // __linux__
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "DiabloCapture.h" // For CaptureReader
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+
+//==============================================================================
+// CAPTURE REPLAY (Linux hosts only)
+//
+// Resends the datagrams of a capture file over UDP, for load-testing ground
+// software with real recorded traffic. The original inter-packet gaps (from
+// the recorded receive times) are divided by a speed factor, or dropped
+// entirely to send as fast as the socket allows. Packets that fall due
+// together go out in one sendmmsg() call, so high speed factors are not
+// limited by per-packet syscalls.
+//
+// Replay only goes to loopback addresses unless explicitly allowed: a
+// capture can hold actuator and abort commands, and replaying them onto the
+// test stand network must never happen by accident.
+//==============================================================================
+
+#if defined(__linux__)
+
+namespace Diablo {
+
+/**
+ * @brief How a capture is replayed.
+ */
+struct CaptureReplayOptions {
+  double speed;               // Playback rate (2.0 = twice real time); 0 = as fast as possible
+  bool rewrite_timestamps;    // Set PacketHeader.timestamp to timestamp_base_ms + replay time
+  uint32_t timestamp_base_ms; // First rewritten timestamp
+  uint32_t source_ip;         // Only replay records from this board (0 = all)
+  uint64_t max_packets;       // Stop after this many packets (0 = all)
+
+  CaptureReplayOptions()
+      : speed(1.0), rewrite_timestamps(false), timestamp_base_ms(0), source_ip(0), max_packets(0) {}
+};
+
+struct CaptureReplayStats {
+  uint64_t packets;     // Datagrams sent
+  uint64_t bytes;       // Payload bytes sent
+  uint64_t send_errors; // Datagrams the socket refused (e.g. ENOBUFS)
+  uint64_t elapsed_ns;  // Wall time of the replay
+
+  double packets_per_s() const { return elapsed_ns ? packets * 1e9 / static_cast<double>(elapsed_ns) : 0.0; }
+  double bytes_per_s() const { return elapsed_ns ? bytes * 1e9 / static_cast<double>(elapsed_ns) : 0.0; }
+};
+
+/**
+ * @brief Sends the records of a capture file to one UDP destination.
+ *
+ * Typical use:
+ * @code
+ *   CaptureReplayer replayer;
+ *   replayer.open("127.0.0.1", ground_port);
+ *   CaptureReplayOptions options;
+ *   options.speed = 10.0;
+ *   CaptureReplayStats stats;
+ *   replayer.replay(reader, options, &stats);
+ * @endcode
+ */
+class CaptureReplayer {
+ public:
+  CaptureReplayer();
+  ~CaptureReplayer();
+
+  /**
+   * @brief Create the sending socket.
+   * @param address Dotted IPv4 destination address.
+   * @param port Destination UDP port.
+   * @param allow_non_loopback Permit destinations outside 127.0.0.0/8.
+   * @return false if the address is invalid, not loopback (unless allowed)
+   * or the socket could not be created.
+   */
+  bool open(const char *address, uint16_t port, bool allow_non_loopback = false);
+  void close();
+
+  /**
+   * @brief Replay every record of reader from its first record.
+   *
+   * Blocks until the replay is done. Rewritten packets that carry a valid
+   * CRC-32C trailer get a new trailer; packets whose trailer was already
+   * wrong are sent with it unchanged. Chunk timestamps inside Sensor Data
+   * bodies are never rewritten.
+   *
+   * @return false if the replayer or the reader is not open.
+   */
+  bool replay(const CaptureReader &reader, const CaptureReplayOptions &options,
+              CaptureReplayStats *stats_out = nullptr);
+
+  bool is_open() const { return fd_ >= 0; }
+
+ private:
+  CaptureReplayer(const CaptureReplayer &);
+  CaptureReplayer &operator=(const CaptureReplayer &);
+
+  int fd_;
+  uint32_t address_; // Network byte order
+  uint16_t port_;    // Host byte order
+};
+
+} // namespace Diablo
+
+#endif // __linux__
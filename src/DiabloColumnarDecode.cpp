@@ -0,0 +1,126 @@
+#include "DiabloColumnarDecode.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t, offsetof
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DIABLO_COLUMNAR_HAVE_AVX2 1
+#endif
+
+namespace Diablo {
+
+namespace {
+
+// Offset of SensorDatapoint.data inside a chunk, for the datapoint in slot 0.
+const size_t kFirstValueOffset = sizeof(SensorDataChunk) + offsetof(SensorDatapoint, data);
+
+inline uint32_t load_u32(const uint8_t *ptr) {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(uint32_t));
+  return value;
+}
+
+void transpose_scalar(const uint8_t *chunks, size_t chunk_stride, size_t num_chunks,
+                      uint8_t num_sensors, uint32_t *timestamps, uint32_t *values,
+                      size_t column_stride) {
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const uint8_t *chunk = chunks + c * chunk_stride;
+    timestamps[c] = load_u32(chunk);
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      values[s * column_stride + c] = load_u32(chunk + kFirstValueOffset + s * sizeof(SensorDatapoint));
+    }
+  }
+}
+
+#if defined(DIABLO_COLUMNAR_HAVE_AVX2)
+
+// Gathers eight chunks at a time for each column. Lanes index whole chunks, so
+// each gather turns one 5-byte-strided sensor slot into eight contiguous values.
+__attribute__((target("avx2")))
+void transpose_avx2(const uint8_t *chunks, size_t chunk_stride, size_t num_chunks,
+                    uint8_t num_sensors, uint32_t *timestamps, uint32_t *values,
+                    size_t column_stride) {
+  const int stride = static_cast<int>(chunk_stride);
+  const __m256i chunk_offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                   _mm256_set1_epi32(stride));
+  const int *base = reinterpret_cast<const int *>(chunks);
+
+  size_t c = 0;
+  for (; c + 8 <= num_chunks; c += 8) {
+    const __m256i block = _mm256_add_epi32(chunk_offsets, _mm256_set1_epi32(static_cast<int>(c) * stride));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(timestamps + c),
+                        _mm256_i32gather_epi32(base, block, 1));
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      const int slot = static_cast<int>(kFirstValueOffset + s * sizeof(SensorDatapoint));
+      const __m256i idx = _mm256_add_epi32(block, _mm256_set1_epi32(slot));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + s * column_stride + c),
+                          _mm256_i32gather_epi32(base, idx, 1));
+    }
+  }
+
+  // Remaining chunks
+  transpose_scalar(chunks + c * chunk_stride, chunk_stride, num_chunks - c, num_sensors,
+                   timestamps + c, values + c, column_stride);
+}
+
+bool cpu_has_avx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+#endif // DIABLO_COLUMNAR_HAVE_AVX2
+
+} // namespace
+
+bool decode_sensor_data_columns(const SensorDataView &view, SensorDataColumns &columns) {
+  const uint8_t num_sensors = view.num_sensors();
+  const size_t num_chunks = view.num_chunks();
+  const size_t chunk_stride = SensorDataView::chunk_size(num_sensors);
+
+  if (num_sensors > MAX_SENSORS_PER_BOARD) return false;
+  if (columns.count + num_chunks > columns.capacity) return false;
+  if (num_chunks == 0) return true;
+
+  // The first packet fixes the column layout; later packets must match it
+  const bool first_packet = (columns.count == 0 && columns.num_columns == 0);
+  uint8_t expected_ids[MAX_SENSORS_PER_BOARD];
+  if (first_packet) {
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      expected_ids[s] = view.chunk(0)[s].sensor_id;
+    }
+  } else {
+    if (num_sensors != columns.num_columns) return false;
+    memcpy(expected_ids, columns.sensor_ids, num_sensors);
+  }
+
+  const uint8_t *chunks = view.chunks_begin();
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const uint8_t *ids = chunks + c * chunk_stride + sizeof(SensorDataChunk) + offsetof(SensorDatapoint, sensor_id);
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      if (ids[s * sizeof(SensorDatapoint)] != expected_ids[s]) return false;
+    }
+  }
+
+  if (first_packet) {
+    memcpy(columns.sensor_ids, expected_ids, num_sensors);
+    columns.num_columns = num_sensors;
+  }
+
+  uint32_t *timestamps = columns.timestamps + columns.count;
+  uint32_t *values = columns.values + columns.count;
+#if defined(DIABLO_COLUMNAR_HAVE_AVX2)
+  if (cpu_has_avx2()) {
+    transpose_avx2(chunks, chunk_stride, num_chunks, num_sensors, timestamps, values, columns.capacity);
+  } else {
+    transpose_scalar(chunks, chunk_stride, num_chunks, num_sensors, timestamps, values, columns.capacity);
+  }
+#else
+  transpose_scalar(chunks, chunk_stride, num_chunks, num_sensors, timestamps, values, columns.capacity);
+#endif
+
+  columns.count += num_chunks;
+  return true;
+}
+
+} // namespace Diablo
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "DiabloConfig.h"      // For MAX_SENSORS_PER_BOARD
+#include "DiabloPacketViews.h" // For SensorDataView
+#include <stddef.h>            // For size_t
+#include <stdint.h>            // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// COLUMNAR SENSOR DATA DECODE
+//
+// Decodes Sensor Data packets straight into structure-of-arrays output: one
+// contiguous uint32_t column per sensor plus a timestamp column. On x86 hosts
+// with AVX2 the 5-byte SensorDatapoint stride is transposed with gathers;
+// everywhere else a scalar loop is used.
+//==============================================================================
+
+/**
+ * @brief Caller-provided structure-of-arrays output for one board.
+ *
+ * Row r of the output is chunk r: timestamps[r] is the chunk timestamp and
+ * column(i)[r] is the value of sensor sensor_ids[i] in that chunk. Columns
+ * follow the sensor order of the first decoded packet.
+ */
+struct SensorDataColumns {
+  uint32_t *timestamps; // capacity entries
+  uint32_t *values;     // MAX_SENSORS_PER_BOARD columns of capacity entries each
+  size_t capacity;      // Rows available in every column
+  size_t count;         // Rows written so far
+  uint8_t num_columns;
+  uint8_t sensor_ids[MAX_SENSORS_PER_BOARD];
+
+  SensorDataColumns() : timestamps(nullptr), values(nullptr), capacity(0), count(0), num_columns(0) {}
+
+  /**
+   * @brief Use the given storage for output.
+   * @param timestamp_storage capacity entries.
+   * @param value_storage MAX_SENSORS_PER_BOARD * capacity entries.
+   * @param rows The number of rows (chunks) the storage can hold.
+   */
+  void attach(uint32_t *timestamp_storage, uint32_t *value_storage, size_t rows) {
+    timestamps = timestamp_storage;
+    values = value_storage;
+    capacity = rows;
+    clear();
+  }
+
+  /**
+   * @brief Value column for the sensor at the given column index.
+   */
+  uint32_t *column(size_t index) { return values + index * capacity; }
+  const uint32_t *column(size_t index) const { return values + index * capacity; }
+
+  /**
+   * @brief Value column for a sensor id.
+   * @return The column, or nullptr if that sensor has no column.
+   */
+  const uint32_t *column_for(uint8_t sensor_id) const {
+    for (uint8_t i = 0; i < num_columns; ++i) {
+      if (sensor_ids[i] == sensor_id) return column(i);
+    }
+    return nullptr;
+  }
+
+  /**
+   * @brief Forget all rows and the column layout.
+   */
+  void clear() {
+    count = 0;
+    num_columns = 0;
+  }
+};
+
+/**
+ * @brief Appends every chunk of a Sensor Data packet as rows of columns.
+ *
+ * The first packet decoded into empty columns fixes the column layout. Later
+ * packets must carry the same sensors in the same order.
+ *
+ * @return true on success; false if the packet has more than
+ * MAX_SENSORS_PER_BOARD sensors, its sensor order differs from the columns,
+ * or the columns are out of rows. Nothing is written on failure.
+ */
+bool decode_sensor_data_columns(const SensorDataView &view, SensorDataColumns &columns);
+
+} // namespace Diablo
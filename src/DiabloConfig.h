@@ -0,0 +1,30 @@
+#pragma once
+
+// Version information
+#define DIABLO_COMMS_VERSION 1 // Protocol version (uint8_t)
+
+// Maximum values
+#define MAX_SENSORS_PER_BOARD 10
+#define MAX_ACTUATORS_PER_BOARD 10
+#define MAX_CHUNKS_PER_PACKET 10
+#define MAX_PACKET_SIZE 512
+
+// Maximum counts for actuator config packet (used for buffer sizing and validation)
+#define MAX_ABORT_ACTUATORS 255
+#define MAX_ABORT_PTS 255
+
+// Flag bits carried in the high bits of PacketHeader.version. The low bits
+// hold DIABLO_COMMS_VERSION.
+#define DIABLO_VERSION_FLAG_CRC32C 0x80 // Packet ends with a 4-byte CRC-32C trailer
+#define DIABLO_CRC32C_SIZE 4
+#define DIABLO_VERSION_FLAG_SEQUENCE 0x40 // Packet ends with a 2-byte sequence number (before any CRC)
+#define DIABLO_SEQUENCE_SIZE 2
+#define DIABLO_VERSION_FLAGS_MASK (DIABLO_VERSION_FLAG_CRC32C | DIABLO_VERSION_FLAG_SEQUENCE)
+
+// Define as 1 to make every parser reject packets without a CRC-32C trailer.
+// The flag bit itself is not covered by any check, so without this a bit
+// flip that clears it turns off verification. dispatch_packet(), IngestServer
+// and UringTransport can also require it per call or per receiver.
+#ifndef DIABLO_COMMS_REQUIRE_CRC32C
+#define DIABLO_COMMS_REQUIRE_CRC32C 0
+#endif
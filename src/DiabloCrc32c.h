@@ -0,0 +1,81 @@
+#pragma once
+
+#include "DiabloConfig.h"  // For DIABLO_VERSION_FLAG_CRC32C, DIABLO_COMMS_REQUIRE_CRC32C
+#include "DiabloPackets.h" // For PacketHeader
+#include <stddef.h>        // For size_t, offsetof
+#include <stdint.h>        // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// PACKET INTEGRITY (CRC-32C TRAILER)
+//
+// Any packet may end with an optional 4-byte little-endian CRC-32C of all
+// preceding bytes. Its presence is signalled by DIABLO_VERSION_FLAG_CRC32C in
+// PacketHeader.version, so receivers that ignore the flag still parse the
+// packet (every parser tolerates trailing bytes).
+//
+// Senders call append_crc_trailer() after any create_* function. Every parse_*
+// function and dispatch_packet() verify the trailer, when present, before
+// decoding the body. Receivers that must not accept unprotected packets
+// require the trailer (DIABLO_COMMS_REQUIRE_CRC32C, or the require_crc
+// receive options), since a flipped flag bit would otherwise skip the check.
+//==============================================================================
+
+/**
+ * @brief Computes CRC-32C (Castagnoli) over data.
+ *
+ * Uses the SSE4.2 crc32 instruction on x86 hosts that support it and
+ * slicing-by-8 tables everywhere else.
+ *
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @param crc A previous result to continue from, or 0 to start.
+ * @return The CRC-32C of data (crc32c("123456789") == 0xE3069283).
+ */
+uint32_t crc32c(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Same as crc32c(), but always uses the portable slicing-by-8 tables.
+ */
+uint32_t crc32c_portable(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Sets the CRC flag on a packet and appends its CRC-32C trailer.
+ * @param buffer A complete packet as produced by a create_* function.
+ * @param packet_size The packet size returned by the create_* function.
+ * @param buffer_size The total size of the buffer.
+ * @return The new packet size (packet_size + DIABLO_CRC32C_SIZE), or 0 on
+ * error (buffer too small or packet already has a trailer).
+ */
+size_t append_crc_trailer(uint8_t *buffer, size_t packet_size, size_t buffer_size);
+
+/**
+ * @brief Verifies the CRC-32C trailer of a packet that has the CRC flag set.
+ * @return true if the trailer matches the preceding bytes.
+ */
+bool verify_crc_trailer(const uint8_t *buffer, size_t packet_size);
+
+/**
+ * @brief Verifies and strips the CRC-32C trailer, if the packet has one.
+ *
+ * Packets without the CRC flag are left untouched unless require_crc is set.
+ * Buffers shorter than a PacketHeader are also left for the caller's own
+ * length checks.
+ *
+ * @param buffer The received packet.
+ * @param packet_size In: bytes received. Out: bytes excluding the trailer.
+ * @param require_crc Reject packets without the CRC flag.
+ * @return false if the packet has a trailer and it does not match, or has
+ * none and require_crc is set.
+ */
+inline bool strip_crc_trailer(const uint8_t *buffer, size_t &packet_size,
+                              bool require_crc = DIABLO_COMMS_REQUIRE_CRC32C) {
+  if (!buffer || packet_size < sizeof(PacketHeader)) return true;
+  if (!(buffer[offsetof(PacketHeader, version)] & DIABLO_VERSION_FLAG_CRC32C)) return !require_crc;
+  if (!verify_crc_trailer(buffer, packet_size)) return false;
+  packet_size -= DIABLO_CRC32C_SIZE;
+  return true;
+}
+
+} // namespace Diablo
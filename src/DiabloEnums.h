@@ -21,7 +21,8 @@ enum class PacketType : uint8_t {
   NO_CONNECTION_ABORT = 11,
   SELF_TEST = 12,
   ENVIRONMENTAL_DATA = 13,
-  STACKLIGHT_COMMAND = 14
+  STACKLIGHT_COMMAND = 14,
+  SENSOR_DATA_COMPRESSED = 15
 };
 
 /**
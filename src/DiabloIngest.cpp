@@ -0,0 +1,398 @@
+#include "DiabloIngest.h"
+
+#if defined(__linux__)
+
+#include "DAQv2-Comms.h"
+#include <cstring>       // For memset
+#include <cstddef>       // For size_t
+#include <system_error>  // For std::system_error
+#include <thread>        // For std::thread
+#include <unordered_map> // For std::unordered_map
+#include <utility>       // For std::make_pair
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/filter.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Diablo {
+
+namespace {
+
+const long kReceiveTimeoutUs = 100000; // How long stop() may wait for a shard
+const size_t kAbortLaneBatch = 16;
+
+int open_shard_socket(const IngestOptions &options, uint32_t address, uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+
+  const int one = 1;
+  struct timeval timeout;
+  timeout.tv_sec = 0;
+  timeout.tv_usec = kReceiveTimeoutUs;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = address;
+  addr.sin_port = htons(port);
+
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0 ||
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+      bind(fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  if (options.receive_buffer_bytes > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &options.receive_buffer_bytes, sizeof(options.receive_buffer_bytes));
+  }
+  return fd;
+}
+
+void pin_to_cpu(std::thread &thread, size_t index) {
+  const unsigned cpus = std::thread::hardware_concurrency();
+  if (cpus == 0) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set); // Best effort
+}
+
+} // namespace
+
+bool attach_shard_program(int fd, size_t num_shards, bool abort_lane) {
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+  // The program sees the UDP payload; SKF_NET_OFF reaches back into the IPv4 header
+  const uint32_t shards = static_cast<uint32_t>(num_shards);
+  struct sock_filter code[] = {
+      BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0), // PacketHeader.packet_type
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(PacketType::ABORT), 6, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(PacketType::ABORT_DONE), 5, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(PacketType::CLEAR_ABORT), 4, 0),
+      BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(PacketType::NO_CONNECTION_ABORT), 3, 0),
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_NET_OFF + 12)), // Source address
+      BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, shards),
+      BPF_STMT(BPF_RET | BPF_A, 0),
+      BPF_STMT(BPF_RET | BPF_K, shards), // Abort lane socket
+  };
+  const size_t lane_prefix = 5; // Instructions skipped without an abort lane
+  struct sock_fprog program;
+  program.len = static_cast<unsigned short>(sizeof(code) / sizeof(code[0]) - (abort_lane ? 0 : lane_prefix + 1));
+  program.filter = abort_lane ? code : code + lane_prefix;
+  return setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+#else
+  (void)fd;
+  (void)num_shards;
+  (void)abort_lane;
+  return false;
+#endif
+}
+
+struct IngestServer::Shard {
+  int fd;
+  IngestHandler *handler;
+  IngestOptions options;
+  const std::atomic<bool> *stopping;
+  std::thread thread;
+
+  // Only touched by the shard thread
+  std::unordered_map<uint32_t, BoardSequenceTracker> boards;
+  BoardSequenceTracker *tracker; // Last board looked up
+  uint32_t tracker_ip;
+
+  std::atomic<uint64_t> datagrams;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> batches;
+  std::atomic<uint64_t> rejected;
+  std::atomic<uint64_t> boards_seen;
+  std::atomic<uint64_t> aborts;
+
+  Shard()
+      : fd(-1), handler(nullptr), stopping(nullptr), tracker(nullptr), tracker_ip(0), datagrams(0), bytes(0),
+        batches(0), rejected(0), boards_seen(0), aborts(0) {}
+
+  BoardSequenceTracker &tracker_for(uint32_t source_ip) {
+    // Consecutive datagrams usually come from the same board
+    if (!tracker || source_ip != tracker_ip) {
+      std::unordered_map<uint32_t, BoardSequenceTracker>::iterator it = boards.find(source_ip);
+      if (it == boards.end()) {
+        it = boards.insert(std::make_pair(source_ip, BoardSequenceTracker())).first;
+        boards_seen.store(boards.size(), std::memory_order_relaxed);
+      }
+      tracker = &it->second;
+      tracker_ip = source_ip;
+    }
+    return *tracker;
+  }
+
+  // Single writer: plain load/store keeps the counters off locked instructions
+  static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+};
+
+IngestServer::IngestServer() : abort_lane_(nullptr), stopping_(false), port_(0), sharded_by_ip_(false) {}
+
+IngestServer::~IngestServer() { stop(); }
+
+bool IngestServer::start(const IngestOptions &options, IngestHandler *const *handlers, size_t num_shards) {
+  if (running() || !handlers || num_shards == 0 || num_shards > DIABLO_INGEST_MAX_SHARDS) return false;
+  if (options.batch_size == 0 || options.max_datagram_bytes == 0) return false;
+  for (size_t i = 0; i < num_shards; ++i) {
+    if (!handlers[i]) return false;
+  }
+
+  struct in_addr address;
+  address.s_addr = htonl(INADDR_ANY);
+  if (options.bind_address && inet_pton(AF_INET, options.bind_address, &address) != 1) return false;
+
+  // Bind every socket before any thread starts so the shard order is fixed
+  stopping_.store(false);
+  port_ = options.port;
+  bool ok = true;
+  for (size_t i = 0; ok && i < num_shards; ++i) {
+    Shard *shard = new Shard();
+    shard->handler = handlers[i];
+    shard->options = options;
+    shard->stopping = &stopping_;
+    shard->fd = open_shard_socket(options, address.s_addr, port_);
+    shards_.push_back(shard);
+    ok = shard->fd >= 0;
+
+    if (ok && port_ == 0) {
+      // The remaining shards join the port the kernel picked for the first
+      struct sockaddr_in bound;
+      socklen_t length = sizeof(bound);
+      ok = getsockname(shard->fd, reinterpret_cast<struct sockaddr *>(&bound), &length) == 0;
+      port_ = ntohs(bound.sin_port);
+    }
+  }
+
+  // The abort lane socket joins last, as number num_shards. It only gets
+  // traffic through the program, so without one it is closed again.
+  if (ok && options.abort_callback) {
+    abort_lane_ = new Shard();
+    abort_lane_->options = options;
+    abort_lane_->stopping = &stopping_;
+    abort_lane_->fd = open_shard_socket(options, address.s_addr, port_);
+    if (abort_lane_->fd < 0) {
+      delete abort_lane_;
+      abort_lane_ = nullptr;
+    }
+  }
+  sharded_by_ip_ = ok && attach_shard_program(shards_[0]->fd, num_shards, abort_lane_ != nullptr);
+  if (abort_lane_ && !sharded_by_ip_) {
+    close(abort_lane_->fd);
+    delete abort_lane_;
+    abort_lane_ = nullptr;
+  }
+
+  if (ok && abort_lane_) {
+    try {
+      abort_lane_->thread = std::thread(run_abort_lane, abort_lane_);
+    } catch (const std::system_error &) {
+      ok = false;
+    }
+  }
+
+  for (size_t i = 0; ok && i < shards_.size(); ++i) {
+    try {
+      shards_[i]->thread = std::thread(run_shard, shards_[i]);
+    } catch (const std::system_error &) {
+      ok = false;
+      break;
+    }
+    if (options.pin_threads) pin_to_cpu(shards_[i]->thread, i);
+  }
+
+  if (!ok) stop();
+  return ok;
+}
+
+void IngestServer::stop() {
+  stopping_.store(true);
+  if (abort_lane_) {
+    if (abort_lane_->thread.joinable()) abort_lane_->thread.join();
+    close(abort_lane_->fd);
+    delete abort_lane_;
+    abort_lane_ = nullptr;
+  }
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (shards_[i]->thread.joinable()) shards_[i]->thread.join();
+    if (shards_[i]->fd >= 0) close(shards_[i]->fd);
+    delete shards_[i];
+  }
+  shards_.clear();
+  sharded_by_ip_ = false;
+}
+
+void IngestServer::run_shard(Shard *shard) {
+  const size_t batch = shard->options.batch_size;
+  const size_t slot = shard->options.max_datagram_bytes;
+  std::vector<uint8_t> buffers(batch * slot);
+  std::vector<struct mmsghdr> msgs(batch);
+  std::vector<struct iovec> iovs(batch);
+  std::vector<struct sockaddr_in> sources(batch);
+  memset(&msgs[0], 0, batch * sizeof(msgs[0]));
+  for (size_t i = 0; i < batch; ++i) {
+    iovs[i].iov_base = &buffers[i * slot];
+    iovs[i].iov_len = slot;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &sources[i];
+  }
+
+  IngestHandler &handler = *shard->handler;
+  const IngestOptions &options = shard->options;
+
+  while (!shard->stopping->load(std::memory_order_relaxed)) {
+    for (size_t i = 0; i < batch; ++i) msgs[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+
+    // Blocks for the first datagram only, then takes whatever else is queued
+    const int received = recvmmsg(shard->fd, &msgs[0], static_cast<unsigned>(batch), MSG_WAITFORONE, nullptr);
+    if (received <= 0) continue; // Timeout (checks stopping) or EINTR
+
+    // Abort-lane packets only get here without the BPF program; deliver them
+    // before anything else in the batch
+    uint64_t aborts = 0;
+    uint64_t rejected = 0;
+    if (options.abort_callback) {
+      for (int i = 0; i < received; ++i) {
+        const uint8_t *data = &buffers[static_cast<size_t>(i) * slot];
+        if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) || !is_abort_lane_packet(data, msgs[i].msg_len)) continue;
+        const uint32_t source_ip = sources[i].sin_addr.s_addr;
+        const DispatchResult result =
+            dispatch_abort_packet(data, msgs[i].msg_len, source_ip, options.abort_callback, options.abort_context,
+                                  options.track_sequences ? &shard->tracker_for(source_ip) : nullptr,
+                                  options.require_crc);
+        if (result == DispatchResult::OK) {
+          ++aborts;
+        } else {
+          ++rejected;
+        }
+      }
+    }
+
+    uint64_t bytes = 0;
+    for (int i = 0; i < received; ++i) {
+      const uint8_t *data = &buffers[static_cast<size_t>(i) * slot];
+      const size_t size = msgs[i].msg_len;
+      const uint32_t source_ip = sources[i].sin_addr.s_addr;
+      const bool truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+      bytes += size;
+      if (options.abort_callback && !truncated && is_abort_lane_packet(data, size)) continue; // Delivered above
+
+      BoardSequenceTracker &tracker = shard->tracker_for(source_ip);
+      handler.on_datagram(source_ip, size);
+      if (truncated) {
+        handler.on_reject(DispatchResult::MALFORMED, data, size);
+        ++rejected;
+        continue;
+      }
+      const DispatchResult result =
+          dispatch_packet(data, size, handler, options.track_sequences ? &tracker : nullptr, options.require_crc);
+      if (result != DispatchResult::OK) ++rejected;
+    }
+    handler.on_batch_end();
+
+    Shard::add(shard->datagrams, static_cast<uint64_t>(received));
+    Shard::add(shard->bytes, bytes);
+    Shard::add(shard->batches, 1);
+    Shard::add(shard->rejected, rejected);
+    Shard::add(shard->aborts, aborts);
+  }
+}
+
+void IngestServer::run_abort_lane(Shard *lane) {
+  uint8_t buffers[kAbortLaneBatch][MAX_PACKET_SIZE];
+  struct mmsghdr msgs[kAbortLaneBatch];
+  struct iovec iovs[kAbortLaneBatch];
+  struct sockaddr_in sources[kAbortLaneBatch];
+  memset(msgs, 0, sizeof(msgs));
+  for (size_t i = 0; i < kAbortLaneBatch; ++i) {
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = sizeof(buffers[i]);
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &sources[i];
+  }
+
+  const IngestOptions &options = lane->options;
+  while (!lane->stopping->load(std::memory_order_relaxed)) {
+    for (size_t i = 0; i < kAbortLaneBatch; ++i) msgs[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+    const int received = recvmmsg(lane->fd, msgs, kAbortLaneBatch, MSG_WAITFORONE, nullptr);
+    if (received <= 0) continue;
+
+    uint64_t bytes = 0;
+    uint64_t aborts = 0;
+    uint64_t rejected = 0;
+    for (int i = 0; i < received; ++i) {
+      const size_t size = msgs[i].msg_len;
+      const uint32_t source_ip = sources[i].sin_addr.s_addr;
+      bytes += size;
+      const DispatchResult result =
+          (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+              ? DispatchResult::MALFORMED
+              : dispatch_abort_packet(buffers[i], size, source_ip, options.abort_callback, options.abort_context,
+                                      options.track_sequences ? &lane->tracker_for(source_ip) : nullptr,
+                                      options.require_crc);
+      if (result == DispatchResult::OK) {
+        ++aborts;
+      } else {
+        ++rejected;
+      }
+    }
+
+    Shard::add(lane->datagrams, static_cast<uint64_t>(received));
+    Shard::add(lane->bytes, bytes);
+    Shard::add(lane->batches, 1);
+    Shard::add(lane->rejected, rejected);
+    Shard::add(lane->aborts, aborts);
+  }
+}
+
+IngestShardStats IngestServer::stats_of(const Shard &shard) {
+  IngestShardStats stats;
+  stats.datagrams = shard.datagrams.load(std::memory_order_relaxed);
+  stats.bytes = shard.bytes.load(std::memory_order_relaxed);
+  stats.batches = shard.batches.load(std::memory_order_relaxed);
+  stats.rejected = shard.rejected.load(std::memory_order_relaxed);
+  stats.boards = shard.boards_seen.load(std::memory_order_relaxed);
+  stats.aborts = shard.aborts.load(std::memory_order_relaxed);
+  return stats;
+}
+
+IngestShardStats IngestServer::shard_stats(size_t index) const {
+  if (index < shards_.size()) return stats_of(*shards_[index]);
+  IngestShardStats stats;
+  memset(&stats, 0, sizeof(stats));
+  return stats;
+}
+
+IngestShardStats IngestServer::abort_lane_stats() const {
+  if (abort_lane_) return stats_of(*abort_lane_);
+  IngestShardStats stats;
+  memset(&stats, 0, sizeof(stats));
+  return stats;
+}
+
+IngestShardStats IngestServer::total_stats() const {
+  IngestShardStats total;
+  memset(&total, 0, sizeof(total));
+  for (size_t i = 0; i <= shards_.size(); ++i) {
+    const IngestShardStats stats = i < shards_.size() ? shard_stats(i) : abort_lane_stats();
+    total.datagrams += stats.datagrams;
+    total.bytes += stats.bytes;
+    total.batches += stats.batches;
+    total.rejected += stats.rejected;
+    if (i < shards_.size()) total.boards += stats.boards; // Lane boards also send to a shard
+    total.aborts += stats.aborts;
+  }
+  return total;
+}
+
+} // namespace Diablo
+
+#endif // __linux__
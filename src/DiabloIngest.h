@@ -0,0 +1,191 @@
+#pragma once
+
+#include "DiabloAbortLane.h"      // For AbortCallback
+#include "DiabloPacketDispatch.h" // For PacketHandler, DispatchResult
+#include <stddef.h>               // For size_t
+#include <stdint.h>               // For standard integer types
+
+//==============================================================================
+// SHARDED INGEST SERVER (Linux hosts only)
+//
+// Reference receive side for the ground station. One UDP socket per shard is
+// bound to the same port with SO_REUSEPORT, and a classic BPF program picks
+// the socket from the datagram's source address (source IP modulo the shard
+// count), so every board always lands on the same shard. Each shard runs on
+// its own thread and owns its boards' state outright: sequence trackers and
+// the user's handler are only ever touched by that thread, without locks.
+//
+// Shards receive in batches with recvmmsg() and hand every datagram to
+// dispatch_packet(). Kernels without SO_ATTACH_REUSEPORT_CBPF (before 4.5)
+// fall back to the default 4-tuple hash, which still keeps a board on one
+// shard as long as it sends from a fixed port.
+//
+// With an abort callback registered, one more socket joins the group and the
+// BPF program sends every abort-lane packet (see DiabloAbortLane.h) to it
+// before looking at the source address. Aborts then never queue behind Sensor
+// Data in a shard's socket buffer; a dedicated thread receives them and calls
+// the callback directly. Without the program, shards pick abort-lane packets
+// out of each batch and deliver them before the rest.
+//==============================================================================
+
+#if defined(__linux__)
+
+#include <atomic> // For std::atomic
+#include <vector> // For std::vector
+
+namespace Diablo {
+
+#define DIABLO_INGEST_MAX_SHARDS 64
+
+/**
+ * @brief PacketHandler that also learns which board each datagram is from.
+ *
+ * One handler per shard; all calls come from that shard's thread.
+ */
+class IngestHandler : public PacketHandler {
+ public:
+  /**
+   * @brief Called before each datagram is dispatched.
+   * @param source_ip IPv4 source as in sockaddr_in.sin_addr.s_addr.
+   */
+  virtual void on_datagram(uint32_t, size_t) {}
+
+  /**
+   * @brief Called after every recvmmsg() batch (e.g. to flush output).
+   */
+  virtual void on_batch_end() {}
+};
+
+struct IngestOptions {
+  const char *bind_address;  // Dotted IPv4 address (nullptr = any)
+  uint16_t port;             // 0 = pick a free port (see IngestServer::port())
+  size_t batch_size;         // Datagrams per recvmmsg() call
+  size_t max_datagram_bytes; // Larger datagrams are rejected as MALFORMED
+  int receive_buffer_bytes;  // SO_RCVBUF per shard (0 = system default)
+  bool pin_threads;          // Pin shard i to CPU i
+  bool track_sequences;      // Drop duplicate packets per board (never abort-lane packets)
+  bool require_crc;          // Reject packets without a CRC-32C trailer
+
+  // Receives ABORT, ABORT_DONE, CLEAR_ABORT and NO_CONNECTION_ABORT instead of
+  // the shard handlers (nullptr = no abort lane). Called from the abort lane
+  // thread and, without the BPF program, from shard threads: must be
+  // thread-safe.
+  AbortCallback abort_callback;
+  void *abort_context;
+
+  IngestOptions()
+      : bind_address(nullptr),
+        port(0),
+        batch_size(64),
+        max_datagram_bytes(2048),
+        receive_buffer_bytes(4 << 20),
+        pin_threads(true),
+        track_sequences(true),
+        require_crc(DIABLO_COMMS_REQUIRE_CRC32C),
+        abort_callback(nullptr),
+        abort_context(nullptr) {}
+};
+
+/**
+ * @brief Counters of one shard (read at any time from any thread).
+ */
+struct IngestShardStats {
+  uint64_t datagrams; // Datagrams received
+  uint64_t bytes;     // Bytes received
+  uint64_t batches;   // recvmmsg() calls that returned data
+  uint64_t rejected;  // Datagrams dispatch_packet() rejected
+  uint64_t boards;    // Distinct source addresses seen
+  uint64_t aborts;    // Abort-lane packets delivered to the abort callback
+};
+
+/**
+ * @brief Attach the shard program to the SO_REUSEPORT group of fd.
+ *
+ * Steers every datagram to socket (source IP % num_shards); sockets are
+ * numbered in bind order. With abort_lane, abort-lane packets go to socket
+ * num_shards instead.
+ *
+ * @return false if the kernel lacks SO_ATTACH_REUSEPORT_CBPF.
+ */
+bool attach_shard_program(int fd, size_t num_shards, bool abort_lane);
+
+/**
+ * @brief Multi-threaded UDP receiver sharded by board.
+ *
+ * Typical use:
+ * @code
+ *   MyHandler handlers[4];
+ *   IngestHandler *shards[4] = {&handlers[0], &handlers[1], &handlers[2], &handlers[3]};
+ *   IngestServer server;
+ *   IngestOptions options;
+ *   options.port = ground_port;
+ *   server.start(options, shards, 4);
+ *   ...
+ *   server.stop();
+ * @endcode
+ */
+class IngestServer {
+ public:
+  IngestServer();
+  ~IngestServer();
+
+  /**
+   * @brief Bind one socket per handler and start the shard threads.
+   * @param handlers One handler per shard; must outlive stop().
+   * @param num_shards Number of handlers (1 to DIABLO_INGEST_MAX_SHARDS).
+   * @return false if already running, on bad arguments or if a socket or
+   * thread could not be created (nothing is left running).
+   */
+  bool start(const IngestOptions &options, IngestHandler *const *handlers, size_t num_shards);
+
+  /**
+   * @brief Stop and join all shard threads (and the abort lane) and close
+   * their sockets.
+   *
+   * Shards notice within their receive timeout (100 ms).
+   */
+  void stop();
+
+  bool running() const { return !shards_.empty(); }
+  size_t num_shards() const { return shards_.size(); }
+  uint16_t port() const { return port_; }
+
+  /**
+   * @brief Whether the source-IP shard program is attached (false means the
+   * kernel's default hash distributes boards).
+   */
+  bool sharded_by_ip() const { return sharded_by_ip_; }
+
+  /**
+   * @brief Whether abort-lane packets arrive on their own socket and thread
+   * (needs an abort callback and the BPF program).
+   */
+  bool has_abort_lane() const { return abort_lane_ != nullptr; }
+
+  IngestShardStats shard_stats(size_t shard) const;
+  IngestShardStats abort_lane_stats() const;
+
+  /**
+   * @brief Sum over every shard and the abort lane.
+   */
+  IngestShardStats total_stats() const;
+
+ private:
+  IngestServer(const IngestServer &);
+  IngestServer &operator=(const IngestServer &);
+
+  struct Shard;
+  static void run_shard(Shard *shard);
+  static void run_abort_lane(Shard *lane);
+  static IngestShardStats stats_of(const Shard &shard);
+
+  std::vector<Shard *> shards_;
+  Shard *abort_lane_; // nullptr unless has_abort_lane()
+  std::atomic<bool> stopping_;
+  uint16_t port_;
+  bool sharded_by_ip_;
+};
+
+} // namespace Diablo
+
+#endif // __linux__
@@ -0,0 +1,195 @@
+#include "DiabloLiveness.h"
+#include "DAQv2-Comms.h"
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+namespace {
+
+// Serial comparison, so millis() wrapping after 49 days is harmless
+inline bool before(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) < 0; }
+
+} // namespace
+
+void LivenessTracker::reset() {
+  for (size_t i = 0; i < DIABLO_LIVENESS_MAX_PEERS; ++i) {
+    Peer &peer = peers_[i];
+    peer.deadline_ms = 0;
+    peer.last_heard_ms = 0;
+    peer.next = kNil;
+    peer.prev = kNil;
+    peer.bucket = kNil;
+    peer.state = BoardState::SETUP;
+    peer.tracked = 0;
+  }
+  for (size_t b = 0; b <= kFiring; ++b) heads_[b] = kNil;
+  for (size_t level = 0; level < kLevels; ++level) occupied_[level] = 0;
+  now_ = 0;
+  num_tracked_ = 0;
+  started_ = false;
+}
+
+void LivenessTracker::arm(uint16_t index) {
+  Peer &peer = peers_[index];
+
+  // Overdue deadlines go in the bucket for now_, so they fire on the next tick
+  const uint32_t delta = before(peer.deadline_ms, now_) ? 0 : peer.deadline_ms - now_;
+  unsigned level = 0;
+  while (level + 1 < kLevels && delta >> (kLevelBits * (level + 1))) ++level;
+  uint32_t at = now_ + delta;
+  const uint32_t horizon = 1u << (kLevelBits * kLevels);
+  if (delta >= horizon) at = now_ + horizon - 1; // Re-filed when its bucket cascades
+
+  const uint32_t slot = (at >> (kLevelBits * level)) & kSlotMask;
+  const uint16_t bucket = static_cast<uint16_t>(level * kSlots + slot);
+  peer.bucket = bucket;
+  peer.prev = kNil;
+  peer.next = heads_[bucket];
+  if (peer.next != kNil) peers_[peer.next].prev = index;
+  heads_[bucket] = index;
+  occupied_[level] |= 1ull << slot;
+}
+
+void LivenessTracker::disarm(uint16_t index) {
+  Peer &peer = peers_[index];
+  if (peer.bucket == kNil) return;
+  if (peer.prev != kNil) {
+    peers_[peer.prev].next = peer.next;
+  } else {
+    heads_[peer.bucket] = peer.next;
+    if (peer.next == kNil && peer.bucket != kFiring) {
+      occupied_[peer.bucket / kSlots] &= ~(1ull << (peer.bucket & kSlotMask));
+    }
+  }
+  if (peer.next != kNil) peers_[peer.next].prev = peer.prev;
+  peer.bucket = kNil;
+  peer.next = kNil;
+  peer.prev = kNil;
+}
+
+void LivenessTracker::cascade(unsigned level, uint32_t slot) {
+  const uint16_t bucket = static_cast<uint16_t>(level * kSlots + slot);
+  uint16_t index = heads_[bucket];
+  heads_[bucket] = kNil;
+  occupied_[level] &= ~(1ull << slot);
+  while (index != kNil) {
+    const uint16_t next = peers_[index].next;
+    arm(index);
+    index = next;
+  }
+}
+
+void LivenessTracker::report(uint16_t index, BoardState previous, uint32_t time_ms) {
+  if (!options_.callback) return;
+  LivenessEvent event;
+  event.board_id = static_cast<uint8_t>(index);
+  event.previous = previous;
+  event.state = peers_[index].state;
+  event.time_ms = time_ms;
+  event.last_heard_ms = peers_[index].last_heard_ms;
+  options_.callback(event, options_.context);
+}
+
+void LivenessTracker::expire(uint16_t index, size_t &transitions) {
+  Peer &peer = peers_[index];
+  const BoardState previous = peer.state;
+  const uint32_t deadline = peer.deadline_ms;
+  if (previous == BoardState::ACTIVE) {
+    peer.state = BoardState::CONNECTION_LOSS_DETECTED;
+    if (options_.abort_timeout_ms) {
+      // Counted from the last heartbeat, but never before the loss itself
+      peer.deadline_ms = peer.last_heard_ms + options_.abort_timeout_ms;
+      if (before(peer.deadline_ms, deadline)) peer.deadline_ms = deadline;
+      arm(index);
+    }
+  } else if (previous == BoardState::CONNECTION_LOSS_DETECTED) {
+    peer.state = BoardState::NO_CONNECTION_ABORT;
+  } else {
+    return;
+  }
+  ++transitions;
+  report(index, previous, deadline);
+}
+
+void LivenessTracker::heartbeat(uint8_t board_id, uint32_t now_ms) {
+  if (!started_) {
+    now_ = now_ms;
+    started_ = true;
+  }
+  Peer &peer = peers_[board_id];
+  if (peer.tracked) {
+    disarm(board_id);
+  } else {
+    peer.tracked = 1;
+    ++num_tracked_;
+  }
+  const BoardState previous = peer.state;
+  peer.state = BoardState::ACTIVE;
+  peer.last_heard_ms = now_ms;
+  peer.deadline_ms = now_ms + options_.loss_timeout_ms;
+  arm(board_id);
+  if (previous != BoardState::ACTIVE) report(board_id, previous, now_ms);
+}
+
+void LivenessTracker::forget(uint8_t board_id) {
+  Peer &peer = peers_[board_id];
+  if (!peer.tracked) return;
+  disarm(board_id);
+  peer.tracked = 0;
+  peer.state = BoardState::SETUP;
+  --num_tracked_;
+}
+
+size_t LivenessTracker::poll(uint32_t now_ms) {
+  if (!started_) {
+    now_ = now_ms;
+    started_ = true;
+  }
+
+  size_t transitions = 0;
+  while (!before(now_ms, now_)) {
+    const uint32_t tick = now_;
+
+    // Entering a new period of a higher level: spread its bucket over the
+    // levels below, top level first
+    if ((tick & kSlotMask) == 0) {
+      for (unsigned level = kLevels - 1; level > 0; --level) {
+        if ((tick & ((1u << (kLevelBits * level)) - 1)) == 0) {
+          cascade(level, (tick >> (kLevelBits * level)) & kSlotMask);
+        }
+      }
+    }
+
+    // Every peer in this level-0 bucket is due. They move to kFiring so the
+    // callback can heartbeat() or forget() any of them while the rest wait.
+    const uint32_t slot = tick & kSlotMask;
+    uint16_t index = heads_[slot];
+    heads_[slot] = kNil;
+    occupied_[0] &= ~(1ull << slot);
+    while (index != kNil) {
+      const uint16_t next = peers_[index].next;
+      peers_[index].bucket = kFiring;
+      peers_[index].prev = kNil;
+      peers_[index].next = heads_[kFiring];
+      if (heads_[kFiring] != kNil) peers_[heads_[kFiring]].prev = index;
+      heads_[kFiring] = index;
+      index = next;
+    }
+    now_ = tick + 1;
+    while ((index = heads_[kFiring]) != kNil) {
+      disarm(index);
+      expire(index, transitions);
+    }
+
+    // Skip empty level-0 buckets up to the next cascade
+    const uint32_t position = now_ & kSlotMask;
+    if (position != 0) {
+      const uint64_t pending = occupied_[0] >> position;
+      const uint32_t next_tick = pending ? now_ + static_cast<uint32_t>(__builtin_ctzll(pending)) : (now_ | kSlotMask) + 1;
+      now_ = before(now_ms, next_tick) ? now_ms + 1 : next_tick;
+    }
+  }
+  return transitions;
+}
+
+} // namespace Diablo
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "DiabloEnums.h"   // For BoardState
+#include "DiabloPackets.h" // For BoardHeartbeatPacket
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// HEARTBEAT LIVENESS
+//
+// Tracks when each peer was last heard from and reports, through one
+// callback, when it goes quiet: ACTIVE -> CONNECTION_LOSS_DETECTED after
+// loss_timeout_ms without a heartbeat, then -> NO_CONNECTION_ABORT after
+// abort_timeout_ms. The server keeps one entry per board_id (refreshed by
+// BOARD_HEARTBEAT); a board keeps a single entry for the server (refreshed
+// by SERVER_HEARTBEAT).
+//
+// Deadlines live in a hierarchical timer wheel with 1 ms ticks: a heartbeat
+// moves its entry to a new bucket and a poll only visits buckets that hold
+// something, so both are O(1) per board rather than a rescan of every board
+// on each tick. A transition is reported at its exact deadline, however many
+// boards are tracked, as long as poll() runs at least once per millisecond.
+//
+// All storage is inside the object; nothing allocates. Not thread-safe: call
+// heartbeat() and poll() from the same thread.
+//==============================================================================
+
+#define DIABLO_LIVENESS_MAX_PEERS 256 // One per board_id
+
+/**
+ * @brief A liveness state change handed to a LivenessCallback.
+ */
+struct LivenessEvent {
+  uint8_t board_id;
+  BoardState previous;    // SETUP for a peer's first heartbeat
+  BoardState state;       // ACTIVE, CONNECTION_LOSS_DETECTED or NO_CONNECTION_ABORT
+  uint32_t time_ms;       // Heartbeat arrival, or the deadline that expired
+  uint32_t last_heard_ms; // Last heartbeat from the peer
+};
+
+/**
+ * @brief Called for every state change.
+ * @param context The pointer registered with the callback.
+ */
+typedef void (*LivenessCallback)(const LivenessEvent &event, void *context);
+
+/**
+ * @brief Timeouts and callback for a LivenessTracker.
+ */
+struct LivenessOptions {
+  uint32_t loss_timeout_ms;  // Silence before CONNECTION_LOSS_DETECTED
+  uint32_t abort_timeout_ms; // Silence before NO_CONNECTION_ABORT (0 = never)
+  LivenessCallback callback;
+  void *context;
+
+  LivenessOptions() : loss_timeout_ms(500), abort_timeout_ms(3000), callback(nullptr), context(nullptr) {}
+};
+
+/**
+ * @brief Heartbeat timeouts for up to 256 peers keyed by board_id.
+ *
+ * Typical use on the server:
+ * @code
+ *   LivenessTracker liveness;                       // About 4 KB
+ *   liveness.set_options(options);                  // Callback and timeouts
+ *   ...
+ *   void on_board_heartbeat(const PacketHeader &, const BoardHeartbeatPacket &body) {
+ *     liveness.heartbeat(body, millis());
+ *   }
+ *   ...
+ *   liveness.poll(millis());                        // Every loop iteration
+ * @endcode
+ *
+ * A peer that comes back after a loss is reported as ACTIVE again, including
+ * from NO_CONNECTION_ABORT; clearing the abort itself is up to the caller.
+ */
+class LivenessTracker {
+ public:
+  LivenessTracker() { reset(); }
+  explicit LivenessTracker(const LivenessOptions &options) : options_(options) { reset(); }
+
+  /**
+   * @brief Change the timeouts and callback. Deadlines already armed keep
+   * their old timeout until the next heartbeat.
+   */
+  void set_options(const LivenessOptions &options) { options_ = options; }
+  const LivenessOptions &options() const { return options_; }
+
+  /**
+   * @brief Records a heartbeat and restarts the peer's loss timeout. Starts
+   * tracking board_id if it was not already.
+   *
+   * Reports a transition to ACTIVE (from SETUP, CONNECTION_LOSS_DETECTED or
+   * NO_CONNECTION_ABORT) if the peer was not already ACTIVE.
+   */
+  void heartbeat(uint8_t board_id, uint32_t now_ms);
+  void heartbeat(const BoardHeartbeatPacket &packet, uint32_t now_ms) { heartbeat(packet.board_id, now_ms); }
+
+  /**
+   * @brief Reports every deadline up to and including now_ms.
+   *
+   * The callback may call heartbeat() or forget().
+   *
+   * @return The number of transitions reported.
+   */
+  size_t poll(uint32_t now_ms);
+
+  /**
+   * @brief Stop tracking a peer without reporting anything.
+   */
+  void forget(uint8_t board_id);
+
+  /**
+   * @brief Stop tracking every peer.
+   */
+  void reset();
+
+  bool is_tracked(uint8_t board_id) const { return peers_[board_id].tracked != 0; }
+
+  /**
+   * @brief SETUP for a peer that is not tracked.
+   */
+  BoardState state(uint8_t board_id) const { return peers_[board_id].state; }
+  uint32_t last_heard_ms(uint8_t board_id) const { return peers_[board_id].last_heard_ms; }
+  size_t num_tracked() const { return num_tracked_; }
+
+ private:
+  static const unsigned kLevelBits = 6;
+  static const unsigned kLevels = 4; // 2^24 ms (about 4.6 hours) ahead at most
+  static const unsigned kSlots = 1u << kLevelBits;
+  static const uint32_t kSlotMask = kSlots - 1;
+  static const uint16_t kNil = 0xFFFF;
+  static const uint16_t kFiring = kLevels * kSlots; // Bucket of peers poll() is expiring
+
+  struct Peer {
+    uint32_t deadline_ms;
+    uint32_t last_heard_ms;
+    uint16_t next; // Within the bucket, or kNil
+    uint16_t prev;
+    uint16_t bucket; // level * kSlots + slot, kFiring, or kNil if not armed
+    BoardState state;
+    uint8_t tracked;
+  };
+
+  // Put peer in the bucket for its deadline_ms relative to now_
+  void arm(uint16_t peer);
+  void disarm(uint16_t peer);
+
+  // Move every peer in a higher-level bucket down to the level below
+  void cascade(unsigned level, uint32_t slot);
+
+  // The peer's deadline expired: advance its state and arm the next deadline
+  void expire(uint16_t peer, size_t &transitions);
+
+  void report(uint16_t peer, BoardState previous, uint32_t time_ms);
+
+  LivenessOptions options_;
+  Peer peers_[DIABLO_LIVENESS_MAX_PEERS];
+  uint16_t heads_[kLevels * kSlots + 1]; // Last one is kFiring
+  uint64_t occupied_[kLevels]; // Bit s set: heads_[level * kSlots + s] is not empty
+  uint32_t now_;               // Next tick poll() will process
+  size_t num_tracked_;
+  bool started_;
+};
+
+} // namespace Diablo
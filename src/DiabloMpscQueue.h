@@ -0,0 +1,250 @@
+#pragma once
+
+#include "DiabloConfig.h"   // For MAX_SENSORS_PER_BOARD
+#include "DiabloPackets.h"  // For SensorDatapoint, FixedSensorDataChunkList
+#include "DiabloSpscRing.h" // For DIABLO_CACHE_LINE_SIZE
+#include <atomic>           // For std::atomic
+#include <stddef.h>         // For size_t
+#include <stdint.h>         // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// MPSC SAMPLE QUEUE
+//
+// Lock-free multi-producer/single-consumer queue over fixed storage, for
+// handing samples from several ADC tasks (or ISRs) to the one task that builds
+// Sensor Data packets. Producers never block on the consumer or on each other
+// beyond a single compare-and-swap, so sample timestamps no longer pick up
+// jitter from packet serialization.
+//==============================================================================
+
+/**
+ * @brief One sensor reading and the time it was taken.
+ */
+struct SensorSample {
+  uint32_t timestamp;
+  SensorDatapoint datapoint;
+};
+
+/**
+ * @brief Bounded lock-free multi-producer/single-consumer queue.
+ *
+ * Each slot carries its own sequence number (Vyukov's bounded queue), so
+ * producers only contend on one compare-and-swap of the enqueue index and the
+ * consumer never writes to a line producers spin on. try_push() never blocks
+ * and is safe from ISRs and from any number of tasks; try_pop() must only be
+ * called from one task.
+ *
+ * If a producer is preempted between claiming a slot and publishing it, the
+ * consumer sees the queue as empty at that slot until the producer resumes;
+ * later slots are not lost.
+ *
+ * @tparam T Element type; copied in and out.
+ * @tparam Capacity Number of slots; must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+ public:
+  MpscQueue() : enqueue_pos_(0), dequeue_pos_(0) {
+    for (size_t i = 0; i < Capacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  static size_t capacity() { return Capacity; }
+
+  /**
+   * @brief Enqueue a copy of item (any thread or ISR).
+   * @return false if the queue is full.
+   */
+  bool try_push(const T &item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & kMask];
+      const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        // Slot is free for this lap; claim it
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false; // Slot still holds last lap's item: full
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed); // Another producer won
+      }
+    }
+    slot->value = item;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Dequeue the oldest item (consumer task only).
+   * @return false if the queue is empty.
+   */
+  bool try_pop(T &item_out) {
+    Slot &slot = slots_[dequeue_pos_ & kMask];
+    const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeue_pos_ + 1) return false; // Not yet published
+    item_out = slot.value;
+    slot.sequence.store(dequeue_pos_ + Capacity, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+  }
+
+  /**
+   * @brief Copy the oldest item without dequeuing it (consumer task only).
+   * @return false if the queue is empty.
+   */
+  bool try_peek(T &item_out) const {
+    const Slot &slot = slots_[dequeue_pos_ & kMask];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) return false;
+    item_out = slot.value;
+    return true;
+  }
+
+  /**
+   * @brief Whether the next try_pop() would fail (consumer task only).
+   */
+  bool empty() const {
+    return slots_[dequeue_pos_ & kMask].sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1;
+  }
+
+ private:
+  static const size_t kMask = Capacity - 1;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  alignas(DIABLO_CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_; // Shared by producers
+  alignas(DIABLO_CACHE_LINE_SIZE) size_t dequeue_pos_;              // Consumer only
+  alignas(DIABLO_CACHE_LINE_SIZE) Slot slots_[Capacity];
+};
+
+namespace detail {
+
+inline bool chunk_has_sensor(const FixedSensorDataChunkCollection &chunk, uint8_t sensor_id) {
+  for (size_t i = 0; i < chunk.size(); ++i) {
+    if (chunk.datapoints[i].sensor_id == sensor_id) return true;
+  }
+  return false;
+}
+
+// Removes chunks[index], moving the later chunks up. Returns its datapoints.
+inline size_t erase_sensor_chunk(FixedSensorDataChunkList &chunks, size_t index) {
+  const size_t dropped = chunks[index].size();
+  for (size_t i = index + 1; i < chunks.size(); ++i) chunks[i - 1] = chunks[i];
+  --chunks.count;
+  return dropped;
+}
+
+} // namespace detail
+
+/**
+ * @brief Number of complete chunks at the front of chunks: the ones
+ * create_sensor_data_packet() can send now.
+ */
+inline size_t complete_sensor_chunks(const FixedSensorDataChunkList &chunks) {
+  size_t n = 0;
+  while (n < chunks.size() && chunks[n].full()) ++n;
+  return n;
+}
+
+/**
+ * @brief Removes the first count chunks (once sent), keeping the rest in
+ * order at the front.
+ */
+inline void pop_sensor_chunks(FixedSensorDataChunkList &chunks, size_t count) {
+  if (count > chunks.size()) count = chunks.size();
+  for (size_t i = count; i < chunks.size(); ++i) chunks[i - count] = chunks[i];
+  chunks.count = static_cast<uint8_t>(chunks.size() - count);
+}
+
+/**
+ * @brief Moves queued samples into chunks for create_sensor_data_packet().
+ *
+ * Each sample goes into the oldest chunk with its own timestamp that does not
+ * hold its sensor yet; a new chunk is started when there is none. So samples
+ * from several ADC tasks may interleave across ticks, and a chunk never mixes
+ * ticks or repeats a sensor.
+ *
+ * Every task pushes its samples in time order, so once a chunk is complete no
+ * older chunk can still gain a sample: older incomplete chunks (a sample was
+ * lost, e.g. to a full queue) are dropped then. Complete chunks therefore
+ * collect at the front, and incomplete ones carry over to the next call.
+ *
+ * Draining stops when the queue is empty, or when a new chunk is needed and
+ * the list is full; the sample stays queued. If none of a full list's chunks
+ * is complete, its oldest chunk is dropped to make room, so the tasks must
+ * stay within MAX_CHUNKS_PER_PACKET ticks of each other.
+ *
+ * Typical use (network task):
+ * @code
+ *   drain_sensor_samples(queue, chunks, num_sensors);
+ *   const size_t ready = complete_sensor_chunks(chunks);
+ *   if (chunks.full() && ready) {
+ *     send(buffer, create_sensor_data_packet(chunks.chunks, ready, num_sensors, millis(), buffer, sizeof(buffer)));
+ *     pop_sensor_chunks(chunks, ready);
+ *   }
+ * @endcode
+ *
+ * @param dropped_out If not null, incremented by the number of datapoints
+ * dropped with chunks that could no longer complete.
+ * @return The number of samples moved, or 0 if num_sensors is 0 or larger
+ * than MAX_SENSORS_PER_BOARD.
+ */
+template <size_t Capacity>
+size_t drain_sensor_samples(MpscQueue<SensorSample, Capacity> &queue, FixedSensorDataChunkList &chunks,
+                            uint8_t num_sensors, size_t *dropped_out = nullptr) {
+  if (num_sensors == 0 || num_sensors > MAX_SENSORS_PER_BOARD) return 0;
+
+  size_t moved = 0;
+  size_t dropped = 0;
+  SensorSample sample;
+  while (queue.try_peek(sample)) {
+    const uint8_t sensor_id = sample.datapoint.sensor_id;
+
+    // Oldest chunk of this tick that still lacks the sensor
+    FixedSensorDataChunkCollection *chunk = nullptr;
+    for (size_t i = 0; i < chunks.size() && !chunk; ++i) {
+      if (chunks[i].timestamp == sample.timestamp && !chunks[i].full() &&
+          !detail::chunk_has_sensor(chunks[i], sensor_id)) {
+        chunk = &chunks[i];
+      }
+    }
+
+    if (!chunk) {
+      if (chunks.full()) {
+        if (complete_sensor_chunks(chunks)) break; // Caller sends those first
+        size_t oldest = 0;
+        while (chunks[oldest].full()) ++oldest;
+        dropped += detail::erase_sensor_chunk(chunks, oldest);
+      }
+      chunk = chunks.add_chunk(sample.timestamp, num_sensors);
+    }
+
+    queue.try_pop(sample);
+    chunk->add_datapoint(sensor_id, sample.datapoint.data);
+    ++moved;
+
+    if (chunk->full()) {
+      const uint32_t completed = chunk->timestamp;
+      for (size_t i = 0; i < chunks.size();) {
+        if (!chunks[i].full() && static_cast<int32_t>(chunks[i].timestamp - completed) < 0) {
+          dropped += detail::erase_sensor_chunk(chunks, i);
+        } else {
+          ++i;
+        }
+      }
+    }
+  }
+  if (dropped_out) *dropped_out += dropped;
+  return moved;
+}
+
+} // namespace Diablo
@@ -0,0 +1,128 @@
+#include "DiabloPacketBatch.h"
+#include "DAQv2-Comms.h"
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+namespace {
+
+// Appends every dispatched packet to the matching PacketBatch output.
+class BatchHandler : public PacketHandler {
+ public:
+  explicit BatchHandler(PacketBatch &out) : out_(out), index_(0), stored_(0) {}
+
+  void set_index(uint32_t index) { index_ = index; }
+  size_t stored() const { return stored_; }
+
+  void on_board_heartbeat(const PacketHeader &header, const BoardHeartbeatPacket &data) override {
+    store(out_.board_heartbeats, header, data);
+  }
+  void on_server_heartbeat(const PacketHeader &header, const ServerHeartbeatPacket &data) override {
+    store(out_.server_heartbeats, header, data);
+  }
+  void on_sensor_data(const SensorDataView &view) override {
+    store(out_.sensor_data, view.header(), view);
+  }
+  void on_actuator_command(const PacketHeader &header, const PackedArrayView<ActuatorCommand> &commands) override {
+    store(out_.actuator_commands, header, commands);
+  }
+  void on_sensor_config(const PacketHeader &header, const SensorConfigView &view) override {
+    store(out_.sensor_configs, header, view);
+  }
+  void on_actuator_config(const PacketHeader &header, const ActuatorConfigView &view) override {
+    store(out_.actuator_configs, header, view);
+  }
+  void on_abort(const PacketHeader &header) override { store_header(header); }
+  void on_abort_done(const PacketHeader &header) override { store_header(header); }
+  void on_clear_abort(const PacketHeader &header) override { store_header(header); }
+  void on_pwm_actuator_command(const PacketHeader &header, const PackedArrayView<PWMActuatorCommand> &commands) override {
+    store(out_.pwm_actuator_commands, header, commands);
+  }
+  void on_no_connection_abort(const PacketHeader &header) override { store_header(header); }
+  void on_self_test(const PacketHeader &header, const SelfTestView &view) override {
+    store(out_.self_tests, header, view);
+  }
+  void on_environmental_data(const PacketHeader &header, const EnvironmentalDataPacket &data) override {
+    store(out_.environmental_data, header, data);
+  }
+  void on_stacklight_command(const PacketHeader &header, const StacklightCommandPacket &data) override {
+    store(out_.stacklight_commands, header, data);
+  }
+  void on_compressed_sensor_data(CompressedSensorDataView &view) override {
+    store(out_.compressed_sensor_data, view.header(), view);
+  }
+
+  void on_reject(DispatchResult, const uint8_t *, size_t) override {
+    ++out_.num_rejected;
+    uint32_t *slot = out_.rejected.push();
+    if (slot) {
+      *slot = index_;
+    }
+  }
+
+ private:
+  template <typename Body>
+  void store(BatchOutput<DecodedPacket<Body> > &output, const PacketHeader &header, const Body &body) {
+    DecodedPacket<Body> *slot = output.push();
+    if (!slot) {
+      ++out_.num_overflowed;
+      return;
+    }
+    slot->index = index_;
+    slot->header = header;
+    slot->body = body;
+    ++stored_;
+  }
+
+  void store_header(const PacketHeader &header) {
+    DecodedHeader *slot = out_.control.push();
+    if (!slot) {
+      ++out_.num_overflowed;
+      return;
+    }
+    slot->index = index_;
+    slot->header = header;
+    ++stored_;
+  }
+
+  PacketBatch &out_;
+  uint32_t index_;
+  size_t stored_;
+};
+
+} // namespace
+
+void PacketBatch::clear() {
+  board_heartbeats.clear();
+  server_heartbeats.clear();
+  sensor_data.clear();
+  actuator_commands.clear();
+  sensor_configs.clear();
+  actuator_configs.clear();
+  pwm_actuator_commands.clear();
+  self_tests.clear();
+  environmental_data.clear();
+  stacklight_commands.clear();
+  compressed_sensor_data.clear();
+  control.clear();
+  rejected.clear();
+  num_rejected = 0;
+  num_overflowed = 0;
+}
+
+size_t decode_packet_batch(const DatagramRef *datagrams, size_t count,
+                           PacketBatch &out) {
+  out.clear();
+  if (!datagrams) {
+    return 0;
+  }
+
+  BatchHandler handler(out);
+  for (size_t i = 0; i < count; ++i) {
+    handler.set_index(static_cast<uint32_t>(i));
+    dispatch_packet(datagrams[i].data, datagrams[i].size, handler);
+  }
+  return handler.stored();
+}
+
+} // namespace Diablo
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "DiabloPacketDispatch.h" // For dispatch_packet and DispatchResult
+#include "DiabloPackets.h"        // For all packet data structures
+#include "DiabloPacketViews.h"    // For non-owning packet views
+#include <stddef.h>               // For size_t
+#include <stdint.h>               // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// BATCH DECODE
+//
+// decode_packet_batch() classifies and decodes a whole receive batch (for
+// example one recvmmsg() call) in one pass, writing every packet into a
+// caller-provided output array for its type. Nothing is allocated, and
+// variable-length bodies are views into the original datagram buffers.
+//==============================================================================
+
+/**
+ * @brief One received datagram: a pointer to its bytes and its length.
+ */
+struct DatagramRef {
+  const uint8_t *data;
+  size_t size;
+};
+
+/**
+ * @brief A decoded packet and the index of the datagram it came from.
+ */
+template <typename Body>
+struct DecodedPacket {
+  uint32_t index; // Position in the datagram array passed to decode_packet_batch
+  PacketHeader header;
+  Body body;
+};
+
+/**
+ * @brief A decoded header-only packet (ABORT, ABORT_DONE, CLEAR_ABORT,
+ * NO_CONNECTION_ABORT). The type is in header.packet_type.
+ */
+struct DecodedHeader {
+  uint32_t index;
+  PacketHeader header;
+};
+
+/**
+ * @brief Caller-provided output array for one kind of decoded packet.
+ */
+template <typename T>
+struct BatchOutput {
+  T *items;
+  size_t capacity;
+  size_t count;
+
+  BatchOutput() : items(nullptr), capacity(0), count(0) {}
+
+  /**
+   * @brief Use storage (capacity entries) as the output array.
+   */
+  void attach(T *storage, size_t storage_capacity) {
+    items = storage;
+    capacity = storage ? storage_capacity : 0;
+    count = 0;
+  }
+
+  /**
+   * @brief Reserve the next slot.
+   * @return Pointer to the slot, or nullptr if the array is full.
+   */
+  T *push() { return count < capacity ? &items[count++] : nullptr; }
+
+  void clear() { count = 0; }
+};
+
+/**
+ * @brief Output of decode_packet_batch(), grouped by packet type.
+ *
+ * Attach storage to the outputs you need; an output with no storage counts
+ * its packets as overflowed.
+ */
+struct PacketBatch {
+  BatchOutput<DecodedPacket<BoardHeartbeatPacket> > board_heartbeats;
+  BatchOutput<DecodedPacket<ServerHeartbeatPacket> > server_heartbeats;
+  BatchOutput<DecodedPacket<SensorDataView> > sensor_data;
+  BatchOutput<DecodedPacket<PackedArrayView<ActuatorCommand> > > actuator_commands;
+  BatchOutput<DecodedPacket<SensorConfigView> > sensor_configs;
+  BatchOutput<DecodedPacket<ActuatorConfigView> > actuator_configs;
+  BatchOutput<DecodedPacket<PackedArrayView<PWMActuatorCommand> > > pwm_actuator_commands;
+  BatchOutput<DecodedPacket<SelfTestView> > self_tests;
+  BatchOutput<DecodedPacket<EnvironmentalDataPacket> > environmental_data;
+  BatchOutput<DecodedPacket<StacklightCommandPacket> > stacklight_commands;
+  BatchOutput<DecodedPacket<CompressedSensorDataView> > compressed_sensor_data;
+  BatchOutput<DecodedHeader> control;  // Header-only abort/control packets
+  BatchOutput<uint32_t> rejected;      // Indices of malformed/unknown datagrams
+  size_t num_rejected;                 // Rejected datagrams, even if not recorded
+  size_t num_overflowed;               // Valid packets dropped for lack of space
+
+  PacketBatch() : num_rejected(0), num_overflowed(0) {}
+
+  /**
+   * @brief Empty every output array and reset the counters.
+   */
+  void clear();
+};
+
+/**
+ * @brief Decodes a batch of datagrams into per-type output arrays.
+ *
+ * out is cleared first. Views stored in out point into the datagram buffers
+ * and are only valid while those buffers are.
+ *
+ * @param datagrams Array of count received datagrams.
+ * @param count The number of datagrams.
+ * @param out Per-type output arrays.
+ * @return The number of datagrams decoded and stored in out.
+ */
+size_t decode_packet_batch(const DatagramRef *datagrams, size_t count,
+                           PacketBatch &out);
+
+} // namespace Diablo
@@ -0,0 +1,272 @@
+#include "DiabloPacketBuilder.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t, offsetof
+
+namespace Diablo {
+
+SensorDataPacketBuilder::SensorDataPacketBuilder(size_t payload_limit)
+    : payload_limit_(0),
+      size_(0),
+      chunk_fill_(0),
+      num_sensors_(0),
+      num_chunks_(0),
+      open_count_(0),
+      started_(false),
+      chunk_open_(false) {
+  set_payload_limit(payload_limit);
+}
+
+void SensorDataPacketBuilder::set_payload_limit(size_t payload_limit) {
+  payload_limit_ = payload_limit > MAX_PACKET_SIZE ? MAX_PACKET_SIZE : payload_limit;
+}
+
+size_t SensorDataPacketBuilder::chunk_size() const {
+  return sizeof(SensorDataChunk) + (static_cast<size_t>(num_sensors_) * sizeof(SensorDatapoint));
+}
+
+bool SensorDataPacketBuilder::begin(uint32_t timestamp_ms, uint8_t num_sensors) {
+  const size_t header_size = sizeof(PacketHeader);
+  const size_t body_header_size = sizeof(SensorDataPacket);
+
+  started_ = false;
+  chunk_open_ = false;
+  num_chunks_ = 0;
+  open_count_ = 0;
+  chunk_fill_ = 0;
+  size_ = 0;
+
+  if (payload_limit_ < header_size + body_header_size) {
+    return false; // Not even an empty packet fits
+  }
+
+  // Header
+  PacketHeader header;
+  header.packet_type = PacketType::SENSOR_DATA;
+  header.version = DIABLO_COMMS_VERSION;
+  header.timestamp = timestamp_ms;
+  memcpy(buffer_, &header, header_size);
+
+  // Body header; num_chunks is patched by finalize()
+  SensorDataPacket body;
+  body.num_chunks = 0;
+  body.num_sensors = num_sensors;
+  memcpy(buffer_ + header_size, &body, body_header_size);
+
+  num_sensors_ = num_sensors;
+  size_ = header_size + body_header_size;
+  started_ = true;
+  return true;
+}
+
+bool SensorDataPacketBuilder::full() const {
+  return !started_ || num_chunks_ == 255 || size_ + chunk_size() > payload_limit_;
+}
+
+uint8_t SensorDataPacketBuilder::max_chunks() const {
+  if (!started_) {
+    return 0;
+  }
+  const size_t room = payload_limit_ > size_ ? (payload_limit_ - size_) / chunk_size() : 0;
+  const size_t total = num_chunks_ + room;
+  return static_cast<uint8_t>(total > 255 ? 255 : total);
+}
+
+bool SensorDataPacketBuilder::begin_chunk(uint32_t timestamp) {
+  chunk_open_ = false;
+  if (full()) {
+    return false;
+  }
+
+  // Chunk header (timestamp), written just past the committed chunks
+  SensorDataChunk chunk_hdr;
+  chunk_hdr.timestamp = timestamp;
+  memcpy(buffer_ + size_, &chunk_hdr, sizeof(SensorDataChunk));
+  chunk_fill_ = sizeof(SensorDataChunk);
+  open_count_ = 0;
+  chunk_open_ = true;
+
+  if (num_sensors_ == 0) {
+    // A chunk without datapoints is complete as soon as it is opened
+    size_ += chunk_fill_;
+    ++num_chunks_;
+    chunk_open_ = false;
+  }
+  return true;
+}
+
+bool SensorDataPacketBuilder::add_datapoint(uint8_t sensor_id, uint32_t data) {
+  if (!chunk_open_) {
+    return false;
+  }
+
+  SensorDatapoint dp;
+  dp.sensor_id = sensor_id;
+  dp.data = data;
+  memcpy(buffer_ + size_ + chunk_fill_, &dp, sizeof(SensorDatapoint));
+  chunk_fill_ += sizeof(SensorDatapoint);
+
+  if (++open_count_ == num_sensors_) {
+    // Commit the completed chunk
+    size_ += chunk_fill_;
+    ++num_chunks_;
+    chunk_open_ = false;
+  }
+  return true;
+}
+
+bool SensorDataPacketBuilder::append_chunk(uint32_t timestamp, const SensorDatapoint *datapoints) {
+  if (num_sensors_ && !datapoints) {
+    return false;
+  }
+  if (!begin_chunk(timestamp)) {
+    return false;
+  }
+  if (num_sensors_) {
+    const size_t datapoints_total_size = static_cast<size_t>(num_sensors_) * sizeof(SensorDatapoint);
+    memcpy(buffer_ + size_ + chunk_fill_, datapoints, datapoints_total_size);
+    size_ += chunk_fill_ + datapoints_total_size;
+    ++num_chunks_;
+    chunk_open_ = false;
+  }
+  return true;
+}
+
+size_t SensorDataPacketBuilder::finalize() {
+  if (!started_) {
+    return 0;
+  }
+
+  // Drop any incomplete chunk; only committed bytes are part of the packet
+  chunk_open_ = false;
+  buffer_[sizeof(PacketHeader) + offsetof(SensorDataPacket, num_chunks)] = num_chunks_;
+  return size_;
+}
+
+//==============================================================================
+// SensorDataPacker
+//==============================================================================
+
+SensorDataPacker::SensorDataPacker(PacketSink sink, void *context, size_t payload_limit)
+    : builder_(payload_limit),
+      sink_(sink),
+      context_(context),
+      payload_limit_(0),
+      timestamp_ms_(0),
+      oldest_timestamp_(0),
+      packets_emitted_(0),
+      chunks_emitted_(0),
+      num_sensors_(0),
+      started_(false) {
+  set_payload_limit(payload_limit);
+}
+
+bool SensorDataPacker::restart() {
+  builder_.set_payload_limit(payload_limit_);
+  started_ = builder_.begin(timestamp_ms_, num_sensors_) && !builder_.full();
+  return started_;
+}
+
+bool SensorDataPacker::begin(uint32_t timestamp_ms, uint8_t num_sensors) {
+  timestamp_ms_ = timestamp_ms;
+  num_sensors_ = num_sensors;
+  return restart();
+}
+
+bool SensorDataPacker::add_chunk(uint32_t timestamp, const SensorDatapoint *datapoints) {
+  if (!started_ || (num_sensors_ && !datapoints)) {
+    return false;
+  }
+  if (builder_.full()) {
+    flush();
+    if (!started_) {
+      return false; // Payload limit was lowered below one chunk
+    }
+  }
+  const bool first = builder_.empty();
+  if (!builder_.append_chunk(timestamp, datapoints)) {
+    return false;
+  }
+  if (first) {
+    oldest_timestamp_ = timestamp;
+  }
+  return true;
+}
+
+bool SensorDataPacker::add_chunk(const SensorDataChunkCollection &chunk) {
+  if (chunk.datapoints.size() != num_sensors_) {
+    return false;
+  }
+  return add_chunk(chunk.timestamp, chunk.datapoints.data());
+}
+
+bool SensorDataPacker::add_chunk(const FixedSensorDataChunkCollection &chunk) {
+  if (chunk.size() != num_sensors_) {
+    return false;
+  }
+  return add_chunk(chunk.timestamp, chunk.datapoints);
+}
+
+size_t SensorDataPacker::flush() {
+  if (!started_ || builder_.empty()) {
+    return 0;
+  }
+
+  const uint8_t num_chunks = builder_.num_chunks();
+  const size_t size = builder_.finalize();
+  if (sink_) {
+    sink_(builder_.data(), size, context_);
+  }
+  ++packets_emitted_;
+  chunks_emitted_ += num_chunks;
+
+  restart();
+  return 1;
+}
+
+namespace {
+
+size_t chunk_count(const SensorDataChunkCollection &chunk) { return chunk.datapoints.size(); }
+size_t chunk_count(const FixedSensorDataChunkCollection &chunk) { return chunk.size(); }
+
+template <typename Chunk>
+size_t pack_chunks(const Chunk *chunks, size_t num_chunks, uint8_t num_sensors, uint32_t timestamp_ms,
+                   size_t payload_limit, PacketSink sink, void *context) {
+  if (num_chunks && !chunks) {
+    return 0;
+  }
+  for (size_t i = 0; i < num_chunks; ++i) {
+    if (chunk_count(chunks[i]) != num_sensors) {
+      return 0; // Every chunk must be complete
+    }
+  }
+
+  SensorDataPacker packer(sink, context, payload_limit);
+  if (!packer.begin(timestamp_ms, num_sensors)) {
+    return 0; // A single chunk does not fit
+  }
+  for (size_t i = 0; i < num_chunks; ++i) {
+    packer.add_chunk(chunks[i]);
+  }
+  packer.flush();
+  return packer.packets_emitted();
+}
+
+} // namespace
+
+size_t pack_sensor_data_packets(const std::vector<SensorDataChunkCollection> &chunks, uint8_t num_sensors,
+                                uint32_t timestamp_ms, size_t payload_limit,
+                                PacketSink sink, void *context) {
+  return pack_chunks(chunks.data(), chunks.size(), num_sensors, timestamp_ms, payload_limit, sink, context);
+}
+
+size_t pack_sensor_data_packets(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                uint8_t num_sensors, uint32_t timestamp_ms, size_t payload_limit,
+                                PacketSink sink, void *context) {
+  if (num_sensors > MAX_SENSORS_PER_BOARD) {
+    return 0;
+  }
+  return pack_chunks(chunks, num_chunks, num_sensors, timestamp_ms, payload_limit, sink, context);
+}
+
+} // namespace Diablo
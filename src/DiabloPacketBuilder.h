@@ -0,0 +1,247 @@
+#pragma once
+
+#include "DiabloConfig.h"  // For MAX_PACKET_SIZE
+#include "DiabloPackets.h" // For all packet data structures
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+#include <vector>          // For std::vector
+
+namespace Diablo {
+
+/**
+ * @brief Builds a Sensor Data packet in place, one chunk at a time.
+ *
+ * The builder owns a MAX_PACKET_SIZE output buffer. begin() writes the
+ * PacketHeader and SensorDataPacket up front; chunks and their datapoints are
+ * then appended straight into the buffer as samples arrive, and finalize()
+ * patches num_chunks. The result is byte-for-byte what
+ * create_sensor_data_packet() would produce for the same chunks, without the
+ * intermediate chunk collections or the second copy.
+ *
+ * Typical use:
+ * @code
+ *   builder.begin(millis(), num_sensors);
+ *   while (!builder.full()) {
+ *     builder.begin_chunk(sample_time);
+ *     for (...) builder.add_datapoint(id, value);
+ *   }
+ *   send(builder.data(), builder.finalize());
+ * @endcode
+ */
+class SensorDataPacketBuilder {
+ public:
+  /**
+   * @param payload_limit Maximum packet size in bytes (clamped to MAX_PACKET_SIZE).
+   */
+  explicit SensorDataPacketBuilder(size_t payload_limit = MAX_PACKET_SIZE);
+
+  /**
+   * @brief Start a new packet, discarding anything built so far.
+   * @param timestamp_ms Value for PacketHeader.timestamp.
+   * @param num_sensors Number of datapoints in every chunk of this packet.
+   * @return false if not even an empty packet fits in the payload limit.
+   */
+  bool begin(uint32_t timestamp_ms, uint8_t num_sensors);
+
+  /**
+   * @brief Open a new chunk. Any incomplete chunk still open is dropped.
+   * @param timestamp Value for SensorDataChunk.timestamp.
+   * @return false if the packet was not begun or a full chunk would not fit.
+   */
+  bool begin_chunk(uint32_t timestamp);
+
+  /**
+   * @brief Append a datapoint to the open chunk.
+   *
+   * The chunk is committed automatically once it holds num_sensors datapoints.
+   *
+   * @return false if no chunk is open.
+   */
+  bool add_datapoint(uint8_t sensor_id, uint32_t data);
+
+  /**
+   * @brief Append a complete chunk in one call.
+   * @param timestamp Value for SensorDataChunk.timestamp.
+   * @param datapoints Exactly num_sensors datapoints.
+   * @return false if the chunk does not fit.
+   */
+  bool append_chunk(uint32_t timestamp, const SensorDatapoint *datapoints);
+
+  /**
+   * @brief Patch num_chunks and close the packet.
+   *
+   * An incomplete chunk that is still open is dropped.
+   *
+   * @return The total packet size in bytes, or 0 if the packet was not begun.
+   */
+  size_t finalize();
+
+  /**
+   * @brief Check whether another complete chunk would still fit.
+   * @return True if no further chunk can be added.
+   */
+  bool full() const;
+
+  /**
+   * @brief The number of complete chunks this packet holds once full: the
+   * chunks already added plus as many more as still fit.
+   * @return 0 if the packet was not begun.
+   */
+  uint8_t max_chunks() const;
+
+  /**
+   * @brief Change the maximum packet size (clamped to MAX_PACKET_SIZE).
+   *
+   * Takes effect for chunks begun after the call.
+   */
+  void set_payload_limit(size_t payload_limit);
+
+  const uint8_t *data() const { return buffer_; }
+  size_t size() const { return size_; }
+  size_t payload_limit() const { return payload_limit_; }
+  uint8_t num_sensors() const { return num_sensors_; }
+  uint8_t num_chunks() const { return num_chunks_; }
+  bool empty() const { return num_chunks_ == 0; }
+  bool chunk_open() const { return chunk_open_; }
+
+ private:
+  size_t chunk_size() const;
+
+  uint8_t buffer_[MAX_PACKET_SIZE];
+  size_t payload_limit_;
+  size_t size_;        // Bytes of committed header, body and complete chunks
+  size_t chunk_fill_;  // Bytes written for the open chunk
+  uint8_t num_sensors_;
+  uint8_t num_chunks_;
+  uint8_t open_count_; // Datapoints written to the open chunk
+  bool started_;
+  bool chunk_open_;
+};
+
+/**
+ * @brief Receives each finished packet from a SensorDataPacker.
+ * @param packet The complete packet; only valid for the duration of the call.
+ * @param size The packet size in bytes.
+ * @param context The context pointer given to the packer.
+ */
+typedef void (*PacketSink)(const uint8_t *packet, size_t size, void *context);
+
+/**
+ * @brief Splits any number of sensor chunks across as few packets as possible.
+ *
+ * Chunks are appended to a SensorDataPacketBuilder; whenever the next chunk
+ * would push the packet past the payload limit, the packet is finalized,
+ * handed to the sink and a new one is begun with the same header timestamp
+ * and sensor count. Since every chunk has the same size, this greedy fill
+ * gives the minimum number of packets.
+ *
+ * Typical use:
+ * @code
+ *   SensorDataPacker packer(send_udp, &socket);
+ *   packer.begin(millis(), num_sensors);
+ *   for (...) packer.add_chunk(sample_time, datapoints);
+ *   packer.flush();
+ * @endcode
+ */
+class SensorDataPacker {
+ public:
+  /**
+   * @param sink Called once per finished packet.
+   * @param context Passed through to sink.
+   * @param payload_limit Maximum packet size in bytes (clamped to MAX_PACKET_SIZE).
+   */
+  SensorDataPacker(PacketSink sink, void *context, size_t payload_limit = MAX_PACKET_SIZE);
+
+  /**
+   * @brief Start packing, discarding anything not yet flushed.
+   * @param timestamp_ms Value for PacketHeader.timestamp of every packet.
+   * @param num_sensors Number of datapoints in every chunk.
+   * @return false if not even one chunk fits in the payload limit.
+   */
+  bool begin(uint32_t timestamp_ms, uint8_t num_sensors);
+
+  /**
+   * @brief Append one chunk, emitting the current packet first if it is full.
+   * @param timestamp Value for SensorDataChunk.timestamp.
+   * @param datapoints Exactly num_sensors datapoints.
+   * @return false if the packer was not begun or datapoints is null.
+   */
+  bool add_chunk(uint32_t timestamp, const SensorDatapoint *datapoints);
+
+  /**
+   * @brief Append one complete chunk collection.
+   * @return false if the chunk does not hold exactly num_sensors datapoints.
+   */
+  bool add_chunk(const SensorDataChunkCollection &chunk);
+  bool add_chunk(const FixedSensorDataChunkCollection &chunk);
+
+  /**
+   * @brief Emit the pending packet, if it holds any chunks.
+   * @return The number of packets emitted (0 or 1).
+   */
+  size_t flush();
+
+  /**
+   * @brief Change the maximum packet size (clamped to MAX_PACKET_SIZE).
+   *
+   * Takes effect from the next packet.
+   */
+  void set_payload_limit(size_t payload_limit) {
+    payload_limit_ = payload_limit > MAX_PACKET_SIZE ? MAX_PACKET_SIZE : payload_limit;
+  }
+
+  size_t payload_limit() const { return payload_limit_; }
+  uint8_t num_sensors() const { return num_sensors_; }
+  uint8_t pending_chunks() const { return started_ ? builder_.num_chunks() : 0; }
+
+  /**
+   * @brief Timestamp given to add_chunk() for the first chunk of the pending
+   * packet. Only meaningful while pending_chunks() is not 0.
+   */
+  uint32_t oldest_pending_timestamp() const { return oldest_timestamp_; }
+
+  /**
+   * @brief The most chunks the pending packet can hold before add_chunk()
+   * emits it, or 0 if the packer was not begun.
+   */
+  uint8_t max_chunks_per_packet() const { return started_ ? builder_.max_chunks() : 0; }
+  uint32_t packets_emitted() const { return packets_emitted_; }
+  uint32_t chunks_emitted() const { return chunks_emitted_; }
+
+ private:
+  bool restart();
+
+  SensorDataPacketBuilder builder_;
+  PacketSink sink_;
+  void *context_;
+  size_t payload_limit_;
+  uint32_t timestamp_ms_;
+  uint32_t oldest_timestamp_; // Of the first chunk in the pending packet
+  uint32_t packets_emitted_;
+  uint32_t chunks_emitted_;
+  uint8_t num_sensors_;
+  bool started_;
+};
+
+/**
+ * @brief Packs every chunk into as few Sensor Data packets as possible.
+ *
+ * All chunks are validated before anything is emitted.
+ *
+ * @param chunks The chunks to send, in order.
+ * @param num_sensors Number of datapoints in every chunk.
+ * @param timestamp_ms Value for PacketHeader.timestamp of every packet.
+ * @param payload_limit Maximum packet size in bytes (clamped to MAX_PACKET_SIZE).
+ * @param sink Called once per finished packet.
+ * @param context Passed through to sink.
+ * @return The number of packets emitted, or 0 on error (a chunk with the wrong
+ * number of datapoints, or a single chunk larger than the payload limit).
+ */
+size_t pack_sensor_data_packets(const std::vector<SensorDataChunkCollection> &chunks, uint8_t num_sensors,
+                                uint32_t timestamp_ms, size_t payload_limit,
+                                PacketSink sink, void *context);
+size_t pack_sensor_data_packets(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                uint8_t num_sensors, uint32_t timestamp_ms, size_t payload_limit,
+                                PacketSink sink, void *context);
+
+} // namespace Diablo
@@ -0,0 +1,228 @@
+#include "DiabloPacketDispatch.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+namespace {
+
+// Decodes the body that follows an already-read PacketHeader and invokes the
+// typed callback. Returns false if the body is malformed.
+typedef bool (*BodyDecoder)(const PacketHeader &header, const uint8_t *body,
+                            size_t body_size, PacketHandler &handler);
+
+template <typename Body>
+bool read_fixed_body(const uint8_t *body, size_t body_size, Body &body_out) {
+  if (body_size < sizeof(Body)) return false;
+  memcpy(&body_out, body, sizeof(Body));
+  return true;
+}
+
+bool decode_board_heartbeat(const PacketHeader &header, const uint8_t *body,
+                            size_t body_size, PacketHandler &handler) {
+  BoardHeartbeatPacket data;
+  if (!read_fixed_body(body, body_size, data)) return false;
+  handler.on_board_heartbeat(header, data);
+  return true;
+}
+
+bool decode_server_heartbeat(const PacketHeader &header, const uint8_t *body,
+                             size_t body_size, PacketHandler &handler) {
+  ServerHeartbeatPacket data;
+  if (!read_fixed_packet_body(body, body_size, data)) return false;
+  handler.on_server_heartbeat(header, data);
+  return true;
+}
+
+bool decode_sensor_data(const PacketHeader &header, const uint8_t *body,
+                        size_t body_size, PacketHandler &handler) {
+  SensorDataView view;
+  if (!view.reset(header, body, body_size)) return false;
+  handler.on_sensor_data(view);
+  return true;
+}
+
+bool decode_actuator_command(const PacketHeader &header, const uint8_t *body,
+                             size_t body_size, PacketHandler &handler) {
+  ActuatorCommandPacket body_hdr;
+  if (!read_fixed_body(body, body_size, body_hdr)) return false;
+  const size_t commands_bytes = static_cast<size_t>(body_hdr.num_commands) * sizeof(ActuatorCommand);
+  if (body_size < sizeof(ActuatorCommandPacket) + commands_bytes) return false;
+  handler.on_actuator_command(header, PackedArrayView<ActuatorCommand>(body + sizeof(ActuatorCommandPacket),
+                                                                       body_hdr.num_commands));
+  return true;
+}
+
+bool decode_sensor_config(const PacketHeader &header, const uint8_t *body,
+                          size_t body_size, PacketHandler &handler) {
+  SensorConfigView view;
+  if (!view.reset(body, body_size)) return false;
+  handler.on_sensor_config(header, view);
+  return true;
+}
+
+bool decode_actuator_config(const PacketHeader &header, const uint8_t *body,
+                            size_t body_size, PacketHandler &handler) {
+  ActuatorConfigView view;
+  if (!view.reset(body, body_size)) return false;
+  handler.on_actuator_config(header, view);
+  return true;
+}
+
+bool decode_abort(const PacketHeader &header, const uint8_t *, size_t,
+                  PacketHandler &handler) {
+  handler.on_abort(header);
+  return true;
+}
+
+bool decode_abort_done(const PacketHeader &header, const uint8_t *, size_t,
+                       PacketHandler &handler) {
+  handler.on_abort_done(header);
+  return true;
+}
+
+bool decode_clear_abort(const PacketHeader &header, const uint8_t *, size_t,
+                        PacketHandler &handler) {
+  handler.on_clear_abort(header);
+  return true;
+}
+
+bool decode_pwm_actuator_command(const PacketHeader &header, const uint8_t *body,
+                                 size_t body_size, PacketHandler &handler) {
+  PWMActuatorCommandPacket body_hdr;
+  if (!read_fixed_body(body, body_size, body_hdr)) return false;
+  const size_t commands_bytes = static_cast<size_t>(body_hdr.num_commands) * sizeof(PWMActuatorCommand);
+  if (body_size < sizeof(PWMActuatorCommandPacket) + commands_bytes) return false;
+  handler.on_pwm_actuator_command(header, PackedArrayView<PWMActuatorCommand>(body + sizeof(PWMActuatorCommandPacket),
+                                                                              body_hdr.num_commands));
+  return true;
+}
+
+bool decode_no_connection_abort(const PacketHeader &header, const uint8_t *, size_t,
+                                PacketHandler &handler) {
+  handler.on_no_connection_abort(header);
+  return true;
+}
+
+bool decode_self_test(const PacketHeader &header, const uint8_t *body,
+                      size_t body_size, PacketHandler &handler) {
+  SelfTestView view;
+  if (!view.reset(body, body_size)) return false;
+  handler.on_self_test(header, view);
+  return true;
+}
+
+bool decode_environmental_data(const PacketHeader &header, const uint8_t *body,
+                               size_t body_size, PacketHandler &handler) {
+  EnvironmentalDataPacket data;
+  if (!read_fixed_body(body, body_size, data)) return false;
+  handler.on_environmental_data(header, data);
+  return true;
+}
+
+bool decode_stacklight_command(const PacketHeader &header, const uint8_t *body,
+                               size_t body_size, PacketHandler &handler) {
+  StacklightCommandPacket data;
+  if (!read_fixed_body(body, body_size, data)) return false;
+  handler.on_stacklight_command(header, data);
+  return true;
+}
+
+bool decode_compressed_sensor_data(const PacketHeader &header, const uint8_t *body,
+                                   size_t body_size, PacketHandler &handler) {
+  CompressedSensorDataView view;
+  if (!view.reset(header, body, body_size)) return false;
+  handler.on_compressed_sensor_data(view);
+  return true;
+}
+
+// Indexed by the raw PacketType value; nullptr marks an unknown type.
+const BodyDecoder kDecoders[] = {
+    nullptr,                       // 0 (unused)
+    decode_board_heartbeat,        // BOARD_HEARTBEAT
+    decode_server_heartbeat,       // SERVER_HEARTBEAT
+    decode_sensor_data,            // SENSOR_DATA
+    decode_actuator_command,       // ACTUATOR_COMMAND
+    decode_sensor_config,          // SENSOR_CONFIG
+    decode_actuator_config,        // ACTUATOR_CONFIG
+    decode_abort,                  // ABORT
+    decode_abort_done,             // ABORT_DONE
+    decode_clear_abort,            // CLEAR_ABORT
+    decode_pwm_actuator_command,   // PWM_ACTUATOR_COMMAND
+    decode_no_connection_abort,    // NO_CONNECTION_ABORT
+    decode_self_test,              // SELF_TEST
+    decode_environmental_data,     // ENVIRONMENTAL_DATA
+    decode_stacklight_command,     // STACKLIGHT_COMMAND
+    decode_compressed_sensor_data, // SENSOR_DATA_COMPRESSED
+};
+
+const size_t kNumDecoders = sizeof(kDecoders) / sizeof(kDecoders[0]);
+
+DispatchResult dispatch_impl(const uint8_t *buffer, size_t buffer_size,
+                             PacketHandler &handler, BoardSequenceTracker *tracker, bool require_crc) {
+  const size_t header_size = sizeof(PacketHeader);
+
+  // Fast reject path: length and type byte only
+  if (!buffer || buffer_size < header_size) {
+    handler.on_reject(DispatchResult::TOO_SHORT, buffer, buffer_size);
+    return DispatchResult::TOO_SHORT;
+  }
+  const uint8_t type = buffer[offsetof(PacketHeader, packet_type)];
+  if (type >= kNumDecoders || !kDecoders[type]) {
+    handler.on_reject(DispatchResult::UNKNOWN_TYPE, buffer, buffer_size);
+    return DispatchResult::UNKNOWN_TYPE;
+  }
+
+  if (!strip_crc_trailer(buffer, buffer_size, require_crc)) {
+    handler.on_reject(DispatchResult::BAD_CRC, buffer, buffer_size);
+    return DispatchResult::BAD_CRC;
+  }
+  // The sequence number is only marked as seen once the body has decoded,
+  // so a corrupt packet cannot shadow a good retransmission of it. Abort-lane
+  // packets are never dropped as duplicates: a board that rebooted without
+  // resyncing must still be able to abort.
+  const size_t sequenced_size = buffer_size;
+  if (tracker && !is_abort_lane_type(type)) {
+    const SequenceResult seq = tracker->peek(buffer, buffer_size);
+    if (seq == SequenceResult::DUPLICATE || seq == SequenceResult::STALE) {
+      tracker->check(buffer, buffer_size); // Counts the duplicate
+      handler.on_reject(DispatchResult::DUPLICATE, buffer, buffer_size);
+      return DispatchResult::DUPLICATE;
+    }
+  }
+  if (!strip_sequence_trailer(buffer, buffer_size)) {
+    handler.on_reject(DispatchResult::MALFORMED, buffer, buffer_size);
+    return DispatchResult::MALFORMED;
+  }
+
+  // Header is read exactly once
+  PacketHeader hdr;
+  read_packet_header(buffer, hdr);
+
+  if (!kDecoders[type](hdr, buffer + header_size, buffer_size - header_size, handler)) {
+    handler.on_reject(DispatchResult::MALFORMED, buffer, buffer_size);
+    return DispatchResult::MALFORMED;
+  }
+  if (tracker) tracker->check(buffer, sequenced_size);
+  return DispatchResult::OK;
+}
+
+} // namespace
+
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler) {
+  return dispatch_impl(buffer, buffer_size, handler, nullptr, DIABLO_COMMS_REQUIRE_CRC32C);
+}
+
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler, BoardSequenceTracker &tracker) {
+  return dispatch_impl(buffer, buffer_size, handler, &tracker, DIABLO_COMMS_REQUIRE_CRC32C);
+}
+
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler, BoardSequenceTracker *tracker, bool require_crc) {
+  return dispatch_impl(buffer, buffer_size, handler, tracker, require_crc);
+}
+
+} // namespace Diablo
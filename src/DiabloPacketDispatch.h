@@ -0,0 +1,108 @@
+#pragma once
+
+#include "DiabloEnums.h"       // For enums like PacketType
+#include "DiabloPackets.h"     // For all packet data structures
+#include "DiabloPacketViews.h" // For non-owning packet views
+#include "DiabloSequence.h"    // For BoardSequenceTracker
+#include <stddef.h>            // For size_t
+#include <stdint.h>            // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// PACKET DISPATCH
+//
+// dispatch_packet() reads the PacketHeader once, then jumps through a table
+// indexed by PacketType to a decoder that hands the typed body to the matching
+// PacketHandler callback. Variable-length bodies are passed as views into the
+// caller's buffer, so dispatch never allocates. A CRC-32C trailer, when
+// flagged, is verified and stripped before any decoder runs, and a
+// BoardSequenceTracker can drop duplicates before the body is touched.
+//==============================================================================
+
+/**
+ * @brief Outcome of dispatch_packet().
+ */
+enum class DispatchResult : uint8_t {
+  OK = 0,           // Decoded and delivered to the typed callback
+  TOO_SHORT = 1,    // Buffer is null or shorter than a PacketHeader
+  UNKNOWN_TYPE = 2, // packet_type is not a known PacketType
+  MALFORMED = 3,    // Body is shorter than its own length fields require
+  BAD_CRC = 4,      // CRC-32C trailer does not match, or is missing but required
+  DUPLICATE = 5     // Sequence number already seen (or too old to tell)
+};
+
+/**
+ * @brief Receives decoded packets from dispatch_packet().
+ *
+ * Override only the callbacks you care about; the rest ignore their packet.
+ * Views passed to callbacks are only valid for the duration of the call.
+ */
+class PacketHandler {
+ public:
+  virtual ~PacketHandler() {}
+
+  virtual void on_board_heartbeat(const PacketHeader &, const BoardHeartbeatPacket &) {}
+  virtual void on_server_heartbeat(const PacketHeader &, const ServerHeartbeatPacket &) {}
+  virtual void on_sensor_data(const SensorDataView &) {}
+  virtual void on_actuator_command(const PacketHeader &, const PackedArrayView<ActuatorCommand> &) {}
+  virtual void on_sensor_config(const PacketHeader &, const SensorConfigView &) {}
+  virtual void on_actuator_config(const PacketHeader &, const ActuatorConfigView &) {}
+  virtual void on_abort(const PacketHeader &) {}
+  virtual void on_abort_done(const PacketHeader &) {}
+  virtual void on_clear_abort(const PacketHeader &) {}
+  virtual void on_pwm_actuator_command(const PacketHeader &, const PackedArrayView<PWMActuatorCommand> &) {}
+  virtual void on_no_connection_abort(const PacketHeader &) {}
+  virtual void on_self_test(const PacketHeader &, const SelfTestView &) {}
+  virtual void on_environmental_data(const PacketHeader &, const EnvironmentalDataPacket &) {}
+  virtual void on_stacklight_command(const PacketHeader &, const StacklightCommandPacket &) {}
+  virtual void on_compressed_sensor_data(CompressedSensorDataView &) {}
+
+  /**
+   * @brief Called instead of a typed callback when a packet is rejected.
+   * @param reason Why the packet was rejected (never DispatchResult::OK).
+   */
+  virtual void on_reject(DispatchResult, const uint8_t *, size_t) {}
+};
+
+/**
+ * @brief Classifies a received packet and delivers it to handler.
+ *
+ * Exactly one handler callback is invoked: the typed callback on success, or
+ * on_reject() otherwise. The PacketHeader passed to callbacks has the
+ * trailer flags cleared from version.
+ *
+ * @param buffer The received packet.
+ * @param buffer_size The number of bytes received.
+ * @param handler Receives the decoded packet.
+ * @return DispatchResult::OK on success, otherwise the reject reason.
+ */
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler);
+
+/**
+ * @brief Same as dispatch_packet(), but also tracks sequence numbers.
+ *
+ * Sequenced packets are checked against tracker (the sending board's tracker)
+ * after CRC verification. Duplicate and stale packets are rejected with
+ * DispatchResult::DUPLICATE without decoding the body, except abort-lane
+ * packets (see is_abort_lane_type()), which are always delivered and only
+ * counted in the tracker's statistics. A sequence number is recorded as
+ * received only after its body decodes, so a MALFORMED packet does not cause
+ * a later good copy to be rejected.
+ */
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler, BoardSequenceTracker &tracker);
+
+/**
+ * @brief Same as dispatch_packet(), with the receive options spelled out.
+ * @param tracker The sending board's tracker, or nullptr to skip sequence
+ * tracking.
+ * @param require_crc Reject packets without a CRC-32C trailer as
+ * DispatchResult::BAD_CRC (the other overloads use
+ * DIABLO_COMMS_REQUIRE_CRC32C).
+ */
+DispatchResult dispatch_packet(const uint8_t *buffer, size_t buffer_size,
+                               PacketHandler &handler, BoardSequenceTracker *tracker, bool require_crc);
+
+} // namespace Diablo
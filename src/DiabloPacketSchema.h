@@ -0,0 +1,133 @@
+#pragma once
+
+#include "DiabloConfig.h"   // For DIABLO_COMMS_VERSION
+#include "DiabloEnums.h"    // For enums like PacketType
+#include "DiabloPackets.h"  // For all packet data structures
+#include "DiabloSequence.h" // For strip_packet_trailers, read_packet_header
+#include <stddef.h>         // For size_t
+#include <stdint.h>         // For standard integer types
+#include <string.h>         // For memcpy
+
+namespace Diablo {
+
+//==============================================================================
+// COMPILE-TIME PACKET SCHEMAS
+//
+// PacketSchema<Body> maps each fixed-size body struct to its PacketType and
+// wire size. encode_fixed_packet()/decode_fixed_packet() are generated from
+// it, so every fixed-size packet is one bounds check plus two copies and the
+// header fields can never drift between packet types.
+//==============================================================================
+
+/**
+ * @brief Compile-time description of a fixed-size packet.
+ *
+ * Specializations provide:
+ * - type:      the PacketType written to / required in PacketHeader
+ * - body_size: bytes of body after PacketHeader (0 for header-only packets)
+ * - min_body_size: shortest body accepted on receive; fields past it were
+ *   added later and read as 0 when an older sender leaves them out
+ * - wire_size: total bytes on the wire
+ */
+template <typename Body>
+struct PacketSchema;
+
+#define DIABLO_FIXED_PACKET_SCHEMA_MIN(BODY, TYPE, BODY_SIZE, MIN_BODY_SIZE) \
+  template <>                                                               \
+  struct PacketSchema<BODY> {                                               \
+    static constexpr PacketType type = TYPE;                                \
+    static constexpr size_t body_size = BODY_SIZE;                          \
+    static constexpr size_t min_body_size = MIN_BODY_SIZE;                  \
+    static constexpr size_t wire_size = sizeof(PacketHeader) + BODY_SIZE;   \
+  }
+
+#define DIABLO_FIXED_PACKET_SCHEMA(BODY, TYPE, BODY_SIZE) \
+  DIABLO_FIXED_PACKET_SCHEMA_MIN(BODY, TYPE, BODY_SIZE, BODY_SIZE)
+
+static_assert(sizeof(PacketHeader) == 6, "PacketHeader must be 6 bytes on the wire");
+static_assert(sizeof(BoardHeartbeatPacket) == 35, "BoardHeartbeatPacket wire layout changed");
+static_assert(sizeof(ServerHeartbeatPacket) == 2, "ServerHeartbeatPacket wire layout changed");
+static_assert(sizeof(EnvironmentalDataPacket) == 12, "EnvironmentalDataPacket wire layout changed");
+static_assert(sizeof(StacklightCommandPacket) == 4, "StacklightCommandPacket wire layout changed");
+
+DIABLO_FIXED_PACKET_SCHEMA(BoardHeartbeatPacket, PacketType::BOARD_HEARTBEAT, sizeof(BoardHeartbeatPacket));
+// load_hint was appended later: older servers send engine_state alone
+DIABLO_FIXED_PACKET_SCHEMA_MIN(ServerHeartbeatPacket, PacketType::SERVER_HEARTBEAT, sizeof(ServerHeartbeatPacket),
+                               offsetof(ServerHeartbeatPacket, load_hint));
+DIABLO_FIXED_PACKET_SCHEMA(EnvironmentalDataPacket, PacketType::ENVIRONMENTAL_DATA, sizeof(EnvironmentalDataPacket));
+DIABLO_FIXED_PACKET_SCHEMA(StacklightCommandPacket, PacketType::STACKLIGHT_COMMAND, sizeof(StacklightCommandPacket));
+
+// Header-only packets have no body on the wire
+DIABLO_FIXED_PACKET_SCHEMA(AbortPacket, PacketType::ABORT, 0);
+DIABLO_FIXED_PACKET_SCHEMA(AbortDonePacket, PacketType::ABORT_DONE, 0);
+DIABLO_FIXED_PACKET_SCHEMA(ClearAbortPacket, PacketType::CLEAR_ABORT, 0);
+DIABLO_FIXED_PACKET_SCHEMA(NoConnectionAbortPacket, PacketType::NO_CONNECTION_ABORT, 0);
+
+#undef DIABLO_FIXED_PACKET_SCHEMA
+#undef DIABLO_FIXED_PACKET_SCHEMA_MIN
+
+/**
+ * @brief Writes a complete fixed-size packet for Body into buffer.
+ * @param body The body to encode (ignored for header-only packets).
+ * @param timestamp_ms Value for PacketHeader.timestamp.
+ * @param buffer The output buffer to write the packet into.
+ * @param buffer_size The size of the provided buffer.
+ * @return PacketSchema<Body>::wire_size, or 0 if the buffer is too small.
+ */
+template <typename Body>
+inline size_t encode_fixed_packet(const Body &body, uint32_t timestamp_ms,
+                                  uint8_t *buffer, size_t buffer_size) {
+  typedef PacketSchema<Body> Schema;
+  if (!buffer || buffer_size < Schema::wire_size) return 0;
+
+  PacketHeader header;
+  header.packet_type = Schema::type;
+  header.version = DIABLO_COMMS_VERSION;
+  header.timestamp = timestamp_ms;
+
+  memcpy(buffer, &header, sizeof(PacketHeader));
+  memcpy(buffer + sizeof(PacketHeader), &body, Schema::body_size);
+  return Schema::wire_size;
+}
+
+/**
+ * @brief Reads the body of a fixed-size packet for Body, already stripped of
+ * trailers.
+ *
+ * Accepts any body of at least PacketSchema<Body>::min_body_size bytes; fields
+ * the body is too short for are zeroed. body_out is only written on success.
+ *
+ * @return true on success, false if body_size is too small.
+ */
+template <typename Body>
+inline bool read_fixed_packet_body(const uint8_t *body, size_t body_size, Body &body_out) {
+  typedef PacketSchema<Body> Schema;
+  if (body_size < Schema::min_body_size) return false;
+  const size_t copy_size = body_size < Schema::body_size ? body_size : Schema::body_size;
+  if (copy_size < Schema::body_size) memset(&body_out, 0, sizeof(Body));
+  memcpy(&body_out, body, copy_size);
+  return true;
+}
+
+/**
+ * @brief Reads a complete fixed-size packet for Body from buffer.
+ *
+ * The packet type is checked on the raw byte before anything is copied.
+ * Outputs are only written on success.
+ *
+ * @return true on success, false on error (size/type/trailer mismatch).
+ */
+template <typename Body>
+inline bool decode_fixed_packet(const uint8_t *buffer, size_t buffer_size,
+                                PacketHeader &header_out, Body &body_out) {
+  typedef PacketSchema<Body> Schema;
+  const size_t min_size = sizeof(PacketHeader) + Schema::min_body_size;
+  if (!buffer || buffer_size < min_size) return false;
+  if (buffer[offsetof(PacketHeader, packet_type)] != static_cast<uint8_t>(Schema::type)) return false;
+  if (!strip_packet_trailers(buffer, buffer_size) || buffer_size < min_size) return false;
+
+  read_packet_header(buffer, header_out);
+  return read_fixed_packet_body(buffer + sizeof(PacketHeader), buffer_size - sizeof(PacketHeader), body_out);
+}
+
+} // namespace Diablo
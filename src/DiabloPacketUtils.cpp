@@ -1,5 +1,6 @@
 #include "DiabloPacketUtils.h"
 #include "DAQv2-Comms.h"
+#include "DiabloPacketSchema.h"
 #include <cstring> // For memcpy
 #include <cstddef> // For size_t
 
@@ -13,38 +14,36 @@ namespace Diablo {
 size_t create_board_heartbeat_packet(const BoardHeartbeatPacket &data,
                                      uint32_t timestamp_ms,
                                      uint8_t *buffer, size_t buffer_size) {
-  // Calculate the total packet size
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(BoardHeartbeatPacket);
-  const size_t total_size = header_size + body_size;
-  
-  // Check if buffer is large enough
-  if (buffer_size < total_size) {
-    return 0; // Error: buffer too small
-  }
-  
-  // Create the packet header
-  PacketHeader header;
-  header.packet_type = PacketType::BOARD_HEARTBEAT;
-  header.version = DIABLO_COMMS_VERSION; // Current protocol version
-  header.timestamp = timestamp_ms;
-  
-  // Copy header to buffer
-  memcpy(buffer, &header, header_size);
-  
-  // Copy body data to buffer
-  memcpy(buffer + header_size, &data, body_size);
-  
-  return total_size;
+  return encode_fixed_packet(data, timestamp_ms, buffer, buffer_size);
 }
 
-size_t create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &chunks, const uint8_t num_sensors,
+size_t create_server_heartbeat_packet(const ServerHeartbeatPacket &data,
+                                      uint32_t timestamp_ms,
+                                      uint8_t *buffer, size_t buffer_size) {
+  return encode_fixed_packet(data, timestamp_ms, buffer, buffer_size);
+}
+
+namespace {
+
+const SensorDatapoint *chunk_datapoints(const SensorDataChunkCollection &chunk) {
+  return chunk.datapoints.data();
+}
+
+const SensorDatapoint *chunk_datapoints(const FixedSensorDataChunkCollection &chunk) {
+  return chunk.datapoints;
+}
+
+// Shared writer for both the vector and fixed-capacity chunk types.
+template <typename Chunk>
+size_t write_sensor_data_packet(const Chunk *chunks, size_t num_chunks, const uint8_t num_sensors,
                                 uint32_t timestamp_ms,
                                 uint8_t *buffer, size_t buffer_size) {
   const size_t header_size = sizeof(PacketHeader);
   const size_t body_header_size = sizeof(SensorDataPacket);
 
-  const size_t num_chunks = chunks.size();
+  if (num_chunks > 255) {
+    return 0; // num_chunks must fit in SensorDataPacket.num_chunks
+  }
 
   // Compute total size: header + body + per-chunk (timestamp + datapoints)
   const size_t per_chunk_size = sizeof(SensorDataChunk) + (static_cast<size_t>(num_sensors) * sizeof(SensorDatapoint));
@@ -67,13 +66,13 @@ size_t create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &c
 
   // Write body header
   SensorDataPacket body;
-  body.num_chunks = num_chunks;
+  body.num_chunks = static_cast<uint8_t>(num_chunks);
   body.num_sensors = num_sensors;
   memcpy(ptr, &body, body_header_size);
   ptr += body_header_size;
 
   // Write chunks and datapoints
-  for (uint8_t i = 0; i < num_chunks; ++i) {
+  for (size_t i = 0; i < num_chunks; ++i) {
     // Chunk header (timestamp)
     SensorDataChunk chunk_hdr;
     chunk_hdr.timestamp = chunks[i].timestamp;
@@ -81,7 +80,7 @@ size_t create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &c
     ptr += sizeof(SensorDataChunk);
 
     // Datapoints (assume exactly num_sensors datapoints are present)
-    const SensorDatapoint *dp = chunks[i].datapoints.data();
+    const SensorDatapoint *dp = chunk_datapoints(chunks[i]);
     size_t datapoints_total_size = static_cast<size_t>(num_sensors) * sizeof(SensorDatapoint);
     memcpy(ptr, dp, datapoints_total_size);
     ptr += datapoints_total_size;
@@ -90,26 +89,139 @@ size_t create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &c
   return total_size;
 }
 
-size_t create_abort_done_packet(uint32_t timestamp_ms,
-                                uint8_t *buffer, size_t buffer_size) {
-  // Calculate the total packet size (header only, no body)
+// Writes value as an unsigned LEB128 varint. Returns nullptr if it does not fit.
+uint8_t *write_varint(uint8_t *ptr, const uint8_t *end, uint32_t value) {
+  while (value >= 0x80u) {
+    if (ptr >= end) return nullptr;
+    *ptr++ = static_cast<uint8_t>(value | 0x80u);
+    value >>= 7;
+  }
+  if (ptr >= end) return nullptr;
+  *ptr++ = static_cast<uint8_t>(value);
+  return ptr;
+}
+
+inline uint32_t zigzag_encode(uint32_t delta) {
+  // Arithmetic on the two's complement bits; delta is a modulo-2^32 difference
+  return (delta << 1) ^ (0u - (delta >> 31));
+}
+
+// Shared compressed writer for both the vector and fixed-capacity chunk types.
+template <typename Chunk>
+size_t write_compressed_sensor_data_packet(const Chunk *chunks, size_t num_chunks, const uint8_t num_sensors,
+                                           uint32_t timestamp_ms,
+                                           uint8_t *buffer, size_t buffer_size) {
   const size_t header_size = sizeof(PacketHeader);
-  
-  // Check if buffer is large enough
-  if (buffer_size < header_size) {
-    return 0; // Error: buffer too small
+  const size_t body_header_size = sizeof(CompressedSensorDataPacket);
+
+  if (num_chunks > 255 || num_sensors > MAX_SENSORS_PER_BOARD || (num_chunks && !chunks)) {
+    return 0;
+  }
+  if (!buffer || buffer_size < header_size + body_header_size + num_sensors) {
+    return 0; // Buffer too small
+  }
+
+  // Every chunk must carry the same sensors in the same order as the first
+  for (size_t i = 0; i < num_chunks; ++i) {
+    if (chunks[i].size() != num_sensors) return 0;
+    const SensorDatapoint *dp = chunk_datapoints(chunks[i]);
+    const SensorDatapoint *first = chunk_datapoints(chunks[0]);
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      if (dp[s].sensor_id != first[s].sensor_id) return 0;
+    }
   }
-  
-  // Create the packet header
+
   PacketHeader header;
-  header.packet_type = PacketType::ABORT_DONE;
-  header.version = 1; // Current protocol version
+  header.packet_type = PacketType::SENSOR_DATA_COMPRESSED;
+  header.version = DIABLO_COMMS_VERSION;
   header.timestamp = timestamp_ms;
-  
-  // Copy header to buffer
-  memcpy(buffer, &header, header_size);
-  
-  return header_size;
+
+  uint8_t *ptr = buffer;
+  const uint8_t *end = buffer + buffer_size;
+  memcpy(ptr, &header, header_size);
+  ptr += header_size;
+
+  CompressedSensorDataPacket body;
+  body.num_chunks = static_cast<uint8_t>(num_chunks);
+  body.num_sensors = num_sensors;
+  memcpy(ptr, &body, body_header_size);
+  ptr += body_header_size;
+
+  // Sensor ids, once for the whole packet
+  for (uint8_t s = 0; s < num_sensors; ++s) {
+    *ptr++ = num_chunks ? chunk_datapoints(chunks[0])[s].sensor_id : 0;
+  }
+
+  uint32_t prev_timestamp = timestamp_ms;
+  uint32_t prev_values[MAX_SENSORS_PER_BOARD] = {0};
+  for (size_t i = 0; i < num_chunks; ++i) {
+    ptr = write_varint(ptr, end, zigzag_encode(chunks[i].timestamp - prev_timestamp));
+    if (!ptr) return 0;
+    prev_timestamp = chunks[i].timestamp;
+
+    const SensorDatapoint *dp = chunk_datapoints(chunks[i]);
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      const uint32_t value = dp[s].data;
+      ptr = write_varint(ptr, end, zigzag_encode(value - prev_values[s]));
+      if (!ptr) return 0;
+      prev_values[s] = value;
+    }
+  }
+
+  return static_cast<size_t>(ptr - buffer);
+}
+
+} // namespace
+
+size_t create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &chunks, const uint8_t num_sensors,
+                                uint32_t timestamp_ms,
+                                uint8_t *buffer, size_t buffer_size) {
+  return write_sensor_data_packet(chunks.data(), chunks.size(), num_sensors,
+                                  timestamp_ms, buffer, buffer_size);
+}
+
+size_t create_sensor_data_packet(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                 const uint8_t num_sensors,
+                                 uint32_t timestamp_ms,
+                                 uint8_t *buffer, size_t buffer_size) {
+  if (num_sensors > MAX_SENSORS_PER_BOARD || (num_chunks && !chunks)) {
+    return 0;
+  }
+  for (size_t i = 0; i < num_chunks; ++i) {
+    if (chunks[i].size() != num_sensors) {
+      return 0; // Every chunk must be complete
+    }
+  }
+  return write_sensor_data_packet(chunks, num_chunks, num_sensors,
+                                  timestamp_ms, buffer, buffer_size);
+}
+
+size_t create_sensor_data_packet(const FixedSensorDataChunkList &chunks, const uint8_t num_sensors,
+                                 uint32_t timestamp_ms,
+                                 uint8_t *buffer, size_t buffer_size) {
+  return create_sensor_data_packet(chunks.chunks, chunks.size(), num_sensors,
+                                   timestamp_ms, buffer, buffer_size);
+}
+
+size_t create_compressed_sensor_data_packet(const std::vector<SensorDataChunkCollection> &chunks,
+                                            const uint8_t num_sensors,
+                                            uint32_t timestamp_ms,
+                                            uint8_t *buffer, size_t buffer_size) {
+  return write_compressed_sensor_data_packet(chunks.data(), chunks.size(), num_sensors,
+                                             timestamp_ms, buffer, buffer_size);
+}
+
+size_t create_compressed_sensor_data_packet(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                            const uint8_t num_sensors,
+                                            uint32_t timestamp_ms,
+                                            uint8_t *buffer, size_t buffer_size) {
+  return write_compressed_sensor_data_packet(chunks, num_chunks, num_sensors,
+                                             timestamp_ms, buffer, buffer_size);
+}
+
+size_t create_abort_done_packet(uint32_t timestamp_ms,
+                                uint8_t *buffer, size_t buffer_size) {
+  return encode_fixed_packet(AbortDonePacket(), timestamp_ms, buffer, buffer_size);
 }
 
 size_t create_actuator_command_packet(const std::vector<ActuatorCommand> &commands,
@@ -203,129 +315,46 @@ size_t create_environmental_data_packet(float temperature_c,
                                         float humidity_rh,
                                         uint32_t timestamp_ms,
                                         uint8_t *buffer, size_t buffer_size) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(EnvironmentalDataPacket);
-  const size_t total_size = header_size + body_size;
-
-  if (!buffer || buffer_size < total_size) {
-    return 0;
-  }
-
-  PacketHeader header;
-  header.packet_type = PacketType::ENVIRONMENTAL_DATA;
-  header.version = DIABLO_COMMS_VERSION;
-  header.timestamp = timestamp_ms;
-
   EnvironmentalDataPacket body;
   body.temperature_c = temperature_c;
   body.pressure_pa = pressure_pa;
   body.humidity_rh = humidity_rh;
-
-  uint8_t *ptr = buffer;
-  memcpy(ptr, &header, header_size);
-  ptr += header_size;
-  memcpy(ptr, &body, body_size);
-  return total_size;
+  return encode_fixed_packet(body, timestamp_ms, buffer, buffer_size);
 }
 
 size_t create_stacklight_command_packet(const StacklightCommandPacket &data,
                                         uint32_t timestamp_ms,
                                         uint8_t *buffer, size_t buffer_size) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(StacklightCommandPacket);
-  const size_t total_size = header_size + body_size;
-
-  if (!buffer || buffer_size < total_size) {
-    return 0;
-  }
-
-  PacketHeader header;
-  header.packet_type = PacketType::STACKLIGHT_COMMAND;
-  header.version = DIABLO_COMMS_VERSION;
-  header.timestamp = timestamp_ms;
-
-  uint8_t *ptr = buffer;
-  memcpy(ptr, &header, header_size);
-  ptr += header_size;
-  memcpy(ptr, &data, body_size);
-  return total_size;
+  return encode_fixed_packet(data, timestamp_ms, buffer, buffer_size);
 }
 
 bool parse_board_heartbeat_packet(const uint8_t *buffer, size_t buffer_size,
                                   PacketHeader &header_out,
                                   BoardHeartbeatPacket &data_out) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(BoardHeartbeatPacket);
-  const size_t total_size = header_size + body_size;
-  if (!buffer || buffer_size < total_size) return false;
-
-  // Read header
-  PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
-  if (hdr.packet_type != PacketType::BOARD_HEARTBEAT) return false;
-
-  // Read body
-  memcpy(&data_out, buffer + header_size, body_size);
-  header_out = hdr;
-  return true;
+  return decode_fixed_packet(buffer, buffer_size, header_out, data_out);
 }
 
 bool parse_server_heartbeat_packet(const uint8_t *buffer, size_t buffer_size,
                                     PacketHeader &header_out,
                                     ServerHeartbeatPacket &data_out) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(ServerHeartbeatPacket);
-  const size_t total_size = header_size + body_size;
-  if (!buffer || buffer_size < total_size) return false;
-
-  // Read header
-  PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
-  if (hdr.packet_type != PacketType::SERVER_HEARTBEAT) return false;
-
-  // Read body
-  memcpy(&data_out, buffer + header_size, body_size);
-  header_out = hdr;
-  return true;
+  return decode_fixed_packet(buffer, buffer_size, header_out, data_out);
 }
 
 bool parse_environmental_data_packet(const uint8_t *buffer, size_t buffer_size,
                                      PacketHeader &header_out,
                                      EnvironmentalDataPacket &data_out) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(EnvironmentalDataPacket);
-  const size_t total_size = header_size + body_size;
-  if (!buffer || buffer_size < total_size) return false;
-
-  PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
-  if (hdr.packet_type != PacketType::ENVIRONMENTAL_DATA) return false;
-
-  memcpy(&data_out, buffer + header_size, body_size);
-  header_out = hdr;
-  return true;
+  return decode_fixed_packet(buffer, buffer_size, header_out, data_out);
 }
 
 bool parse_stacklight_command_packet(const uint8_t *buffer, size_t buffer_size,
                                      PacketHeader &header_out,
                                      StacklightCommandPacket &data_out) {
-  const size_t header_size = sizeof(PacketHeader);
-  const size_t body_size = sizeof(StacklightCommandPacket);
-  const size_t total_size = header_size + body_size;
-  if (!buffer || buffer_size < total_size) return false;
-
-  PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
-  if (hdr.packet_type != PacketType::STACKLIGHT_COMMAND) return false;
-
-  memcpy(&data_out, buffer + header_size, body_size);
-  header_out = hdr;
-  return true;
+  return decode_fixed_packet(buffer, buffer_size, header_out, data_out);
 }
 
-bool parse_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
-                              PacketHeader &header_out,
-                              std::vector<SensorDataChunkCollection> &chunks_out) {
+bool parse_sensor_data_view(const uint8_t *buffer, size_t buffer_size,
+                            SensorDataView &view_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   const size_t body_hdr_size = sizeof(SensorDataPacket);
 
@@ -333,63 +362,90 @@ bool parse_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
 
   // Header
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::SENSOR_DATA) return false;
 
-  const uint8_t *ptr = buffer + header_size;
-  // Body header
-  SensorDataPacket body;
-  memcpy(&body, ptr, body_hdr_size);
-  ptr += body_hdr_size;
+  // Body header and chunk length checks
+  return view_out.reset(hdr, buffer + header_size, buffer_size - header_size);
+}
 
-  const size_t per_chunk_size = sizeof(SensorDataChunk) + (static_cast<size_t>(body.num_sensors) * sizeof(SensorDatapoint));
-  const size_t expected_size = header_size + body_hdr_size + (static_cast<size_t>(body.num_chunks) * per_chunk_size);
-  if (buffer_size < expected_size) return false;
+bool parse_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
+                              PacketHeader &header_out,
+                              std::vector<SensorDataChunkCollection> &chunks_out) {
+  SensorDataView view;
+  if (!parse_sensor_data_view(buffer, buffer_size, view)) return false;
 
   chunks_out.clear();
-  chunks_out.reserve(body.num_chunks);
+  chunks_out.reserve(view.num_chunks());
 
-  for (uint8_t c = 0; c < body.num_chunks; ++c) {
-    // Chunk header
-    SensorDataChunk chunk_hdr;
-    memcpy(&chunk_hdr, ptr, sizeof(SensorDataChunk));
-    ptr += sizeof(SensorDataChunk);
+  for (uint8_t c = 0; c < view.num_chunks(); ++c) {
+    const SensorDataChunkView chunk = view.chunk(c);
 
     // Datapoints
-    SensorDataChunkCollection col(chunk_hdr.timestamp, body.num_sensors);
-    if (body.num_sensors) {
-      col.datapoints.resize(body.num_sensors);
-      memcpy(col.datapoints.data(), ptr, static_cast<size_t>(body.num_sensors) * sizeof(SensorDatapoint));
-      ptr += static_cast<size_t>(body.num_sensors) * sizeof(SensorDatapoint);
+    SensorDataChunkCollection col(chunk.timestamp(), view.num_sensors());
+    if (view.num_sensors()) {
+      col.datapoints.resize(view.num_sensors());
+      chunk.datapoints().copy_to(col.datapoints.data());
     }
     chunks_out.push_back(std::move(col));
   }
 
-  header_out = hdr;
+  header_out = view.header();
   return true;
 }
 
-bool parse_abort_done_packet(const uint8_t *buffer, size_t buffer_size,
-                             PacketHeader &header_out) {
+bool parse_compressed_sensor_data_view(const uint8_t *buffer, size_t buffer_size,
+                                       CompressedSensorDataView &view_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
-  if (!buffer || buffer_size < header_size) return false;
+  const size_t body_hdr_size = sizeof(CompressedSensorDataPacket);
+
+  if (!buffer || buffer_size < header_size + body_hdr_size) return false;
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
-  if (hdr.packet_type != PacketType::ABORT_DONE) return false;
-  header_out = hdr;
+  read_packet_header(buffer, hdr);
+  if (hdr.packet_type != PacketType::SENSOR_DATA_COMPRESSED) return false;
+
+  return view_out.reset(hdr, buffer + header_size, buffer_size - header_size);
+}
+
+bool parse_compressed_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
+                                         PacketHeader &header_out,
+                                         std::vector<SensorDataChunkCollection> &chunks_out) {
+  CompressedSensorDataView view;
+  if (!parse_compressed_sensor_data_view(buffer, buffer_size, view)) return false;
+
+  chunks_out.clear();
+  chunks_out.reserve(view.num_chunks());
+
+  uint32_t timestamp;
+  SensorDatapoint datapoints[MAX_SENSORS_PER_BOARD];
+  while (view.next_chunk(timestamp, datapoints)) {
+    SensorDataChunkCollection col(timestamp, view.num_sensors());
+    col.datapoints.assign(datapoints, datapoints + view.num_sensors());
+    chunks_out.push_back(std::move(col));
+  }
+
+  header_out = view.header();
   return true;
 }
 
+bool parse_abort_done_packet(const uint8_t *buffer, size_t buffer_size,
+                             PacketHeader &header_out) {
+  AbortDonePacket body;
+  return decode_fixed_packet(buffer, buffer_size, header_out, body);
+}
+
 bool parse_actuator_command_packet(const uint8_t *buffer, size_t buffer_size,
                                    PacketHeader &header_out,
                                    std::vector<ActuatorCommand> &commands_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   const size_t body_size = sizeof(ActuatorCommandPacket);
   if (!buffer || buffer_size < header_size + body_size) return false;
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::ACTUATOR_COMMAND) return false;
 
   const uint8_t *ptr = buffer + header_size;
@@ -415,12 +471,13 @@ bool parse_self_test_packet(const uint8_t *buffer, size_t buffer_size,
                             PacketHeader &header_out,
                             uint8_t &adc_good_out,
                             std::vector<SelfTestResult> &results_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   const size_t body_size = sizeof(SelfTestPacket);
   if (!buffer || buffer_size < header_size + body_size) return false;
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::SELF_TEST) return false;
 
   const uint8_t *ptr = buffer + header_size;
@@ -489,12 +546,13 @@ size_t create_pwm_actuator_packet(const std::vector<PWMActuatorCommand> &command
 bool parse_pwm_actuator_packet(const uint8_t *buffer, size_t buffer_size,
                                PacketHeader &header_out,
                                std::vector<PWMActuatorCommand> &commands_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   const size_t body_size = sizeof(PWMActuatorCommandPacket);
   if (!buffer || buffer_size < header_size + body_size) return false;
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::PWM_ACTUATOR_COMMAND) return false;
 
   const uint8_t *ptr = buffer + header_size;
@@ -582,6 +640,7 @@ bool parse_sensor_config_packet(const uint8_t *buffer, size_t buffer_size,
                                 bool &necessary_for_abort_out,
                                 uint32_t &controller_ip_out,
                                 uint8_t &enable_serial_printing_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   // Minimum body: num_sensors(1) + ref_voltage(1) + necessary_for_abort(1) + enable_serial(1)
   const size_t min_body = 4u;
@@ -591,7 +650,7 @@ bool parse_sensor_config_packet(const uint8_t *buffer, size_t buffer_size,
   }
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::SENSOR_CONFIG) {
     return false;
   }
@@ -713,6 +772,7 @@ bool parse_actuator_config_packet(const uint8_t *buffer, size_t buffer_size,
                                   std::vector<AbortActuatorLocation> &abort_actuators_out,
                                   std::vector<AbortPTLocation> &abort_pts_out,
                                   uint8_t &enable_serial_printing_out) {
+  if (!strip_packet_trailers(buffer, buffer_size)) return false;
   const size_t header_size = sizeof(PacketHeader);
   const size_t config_header_size = sizeof(ActuatorConfigPacket);
   const size_t pt_count_size = sizeof(AbortPTSectionHeader);
@@ -723,7 +783,7 @@ bool parse_actuator_config_packet(const uint8_t *buffer, size_t buffer_size,
   }
 
   PacketHeader hdr;
-  memcpy(&hdr, buffer, header_size);
+  read_packet_header(buffer, hdr);
   if (hdr.packet_type != PacketType::ACTUATOR_CONFIG) {
     return false;
   }
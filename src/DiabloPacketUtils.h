@@ -2,6 +2,7 @@
 
 #include "DiabloEnums.h"   // For enums like PacketType
 #include "DiabloPackets.h" // For all packet data structures
+#include "DiabloPacketViews.h" // For non-owning packet views
 #include <stdint.h>        // For standard integer types
 #include <vector>          // For std::vector
 
@@ -33,6 +34,22 @@ size_t create_board_heartbeat_packet(const BoardHeartbeatPacket &data,
                                      uint32_t timestamp_ms,
                                      uint8_t *buffer, size_t buffer_size);
 
+/**
+ * @brief Creates a complete Server Heartbeat packet in the provided buffer.
+ *
+ * This is a fixed-size packet sent periodically by the server to all boards.
+ *
+ * @param data The heartbeat data to encode.
+ * @param timestamp_ms Value for PacketHeader.timestamp.
+ * @param buffer The output buffer to write the final packet into.
+ * @param buffer_size The total size of the output buffer.
+ * @return The number of bytes written to the buffer (always
+ * sizeof(PacketHeader) + sizeof(ServerHeartbeatPacket)), or 0 on error.
+ */
+size_t create_server_heartbeat_packet(const ServerHeartbeatPacket &data,
+                                      uint32_t timestamp_ms,
+                                      uint8_t *buffer, size_t buffer_size);
+
 /**
  * @brief Creates a complete Sensor Data packet in the provided buffer.
  *
@@ -54,6 +71,64 @@ create_sensor_data_packet(const std::vector<SensorDataChunkCollection> &chunks,
                           uint32_t timestamp_ms,
                           uint8_t *buffer, size_t buffer_size);
 
+/**
+ * @brief Creates a complete Sensor Data packet from fixed-capacity chunks.
+ *
+ * Same wire format as the vector overload, but makes no heap allocations.
+ * Every chunk must hold exactly num_sensors datapoints.
+ *
+ * @param chunks Array of num_chunks FixedSensorDataChunkCollection structs.
+ * @param num_chunks The number of chunks in the array.
+ * @param num_sensors The number of sensors that are included in the packet
+ * (at most MAX_SENSORS_PER_BOARD).
+ * @param timestamp_ms Value for PacketHeader.timestamp.
+ * @param buffer The output buffer to write the final packet into.
+ * @param buffer_size The total size of the output buffer.
+ * @return The total number of bytes written to the buffer, or 0 on error.
+ */
+size_t create_sensor_data_packet(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                 const uint8_t num_sensors,
+                                 uint32_t timestamp_ms,
+                                 uint8_t *buffer, size_t buffer_size);
+
+/**
+ * @brief Creates a complete Sensor Data packet from a FixedSensorDataChunkList.
+ * @return The total number of bytes written to the buffer, or 0 on error.
+ */
+size_t create_sensor_data_packet(const FixedSensorDataChunkList &chunks, const uint8_t num_sensors,
+                                 uint32_t timestamp_ms,
+                                 uint8_t *buffer, size_t buffer_size);
+
+/**
+ * @brief Creates a Compressed Sensor Data packet in the provided buffer.
+ *
+ * Carries the same chunks as create_sensor_data_packet(), but chunk
+ * timestamps and per-sensor values are delta-encoded against the previous
+ * chunk and packed as zigzag varints (see CompressedSensorDataPacket). Slowly
+ * changing channels take 1-2 bytes per sample instead of 5.
+ *
+ * @param chunks Chunks to encode. Every chunk must hold exactly num_sensors
+ * datapoints, with the same sensor_id sequence as the first chunk.
+ * @param num_sensors The number of sensors per chunk (at most MAX_SENSORS_PER_BOARD).
+ * @param timestamp_ms Value for PacketHeader.timestamp.
+ * @param buffer The output buffer to write the final packet into.
+ * @param buffer_size The total size of the output buffer.
+ * @return The total number of bytes written to the buffer, or 0 on error.
+ */
+size_t create_compressed_sensor_data_packet(const std::vector<SensorDataChunkCollection> &chunks,
+                                            const uint8_t num_sensors,
+                                            uint32_t timestamp_ms,
+                                            uint8_t *buffer, size_t buffer_size);
+
+/**
+ * @brief Creates a Compressed Sensor Data packet from fixed-capacity chunks.
+ * @return The total number of bytes written to the buffer, or 0 on error.
+ */
+size_t create_compressed_sensor_data_packet(const FixedSensorDataChunkCollection *chunks, size_t num_chunks,
+                                            const uint8_t num_sensors,
+                                            uint32_t timestamp_ms,
+                                            uint8_t *buffer, size_t buffer_size);
+
 /**
  * @brief Creates a simple Abort Done packet.
  *
@@ -161,6 +236,9 @@ bool parse_board_heartbeat_packet(const uint8_t *buffer, size_t buffer_size,
 
 /**
  * @brief Parses a Server Heartbeat packet from buffer.
+ *
+ * Also accepts the older body without load_hint, which then reads as 0.
+ *
  * @return true on success, false on error (size/type mismatch).
  */
 bool parse_server_heartbeat_packet(const uint8_t *buffer, size_t buffer_size,
@@ -169,12 +247,51 @@ bool parse_server_heartbeat_packet(const uint8_t *buffer, size_t buffer_size,
 
 /**
  * @brief Parses a Sensor Data packet from buffer into chunk collections.
+ *
+ * Thin wrapper around parse_sensor_data_view() that copies every chunk into
+ * its own SensorDataChunkCollection.
+ *
  * @return true on success, false on error.
  */
 bool parse_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
                               PacketHeader &header_out,
                               std::vector<SensorDataChunkCollection> &chunks_out);
 
+/**
+ * @brief Validates a Sensor Data packet and points view_out at it.
+ *
+ * The header and total length are checked once; chunks and datapoints are
+ * then read directly from buffer without copying or allocating. view_out is
+ * only valid while buffer is.
+ *
+ * @return true on success, false on error (size/type mismatch).
+ */
+bool parse_sensor_data_view(const uint8_t *buffer, size_t buffer_size,
+                            SensorDataView &view_out);
+
+/**
+ * @brief Parses a Compressed Sensor Data packet into chunk collections.
+ *
+ * Produces the same representation parse_sensor_data_packet() returns for
+ * the equivalent uncompressed packet.
+ *
+ * @return true on success, false on error.
+ */
+bool parse_compressed_sensor_data_packet(const uint8_t *buffer, size_t buffer_size,
+                                         PacketHeader &header_out,
+                                         std::vector<SensorDataChunkCollection> &chunks_out);
+
+/**
+ * @brief Validates a Compressed Sensor Data packet and points view_out at it.
+ *
+ * Chunks are decoded one at a time with CompressedSensorDataView::next_chunk()
+ * without allocating. view_out is only valid while buffer is.
+ *
+ * @return true on success, false on error (size/type mismatch).
+ */
+bool parse_compressed_sensor_data_view(const uint8_t *buffer, size_t buffer_size,
+                                       CompressedSensorDataView &view_out);
+
 /**
  * @brief Parses an Abort Done packet from buffer.
  * @return true on success, false on error.
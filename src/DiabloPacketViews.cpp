@@ -0,0 +1,105 @@
+#include "DiabloPacketViews.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+namespace {
+
+// Reads one unsigned LEB128 varint of at most 5 bytes. Returns nullptr if the
+// varint runs past end or is too long for a uint32_t (including a 5th byte
+// with any of bits 4-6 set, which would be shifted out).
+const uint8_t *read_varint(const uint8_t *ptr, const uint8_t *end, uint32_t &value_out) {
+  uint32_t value = 0;
+  for (unsigned shift = 0; shift < 35; shift += 7) {
+    if (ptr >= end) return nullptr;
+    const uint8_t byte = *ptr++;
+    if (shift == 28 && (byte & 0x70u)) return nullptr;
+    value |= static_cast<uint32_t>(byte & 0x7Fu) << shift;
+    if (!(byte & 0x80u)) {
+      value_out = value;
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+inline uint32_t zigzag_decode(uint32_t value) {
+  return (value >> 1) ^ (0u - (value & 1u));
+}
+
+} // namespace
+
+CompressedSensorDataView::CompressedSensorDataView()
+    : sensor_ids_(nullptr),
+      chunks_(nullptr),
+      chunks_end_(nullptr),
+      pos_(nullptr),
+      num_chunks_(0),
+      num_sensors_(0),
+      next_index_(0),
+      prev_timestamp_(0) {
+  header_.packet_type = PacketType::SENSOR_DATA_COMPRESSED;
+  header_.version = 0;
+  header_.timestamp = 0;
+}
+
+bool CompressedSensorDataView::reset(const PacketHeader &header, const uint8_t *body, size_t body_size) {
+  const size_t body_hdr_size = sizeof(CompressedSensorDataPacket);
+  if (!body || body_size < body_hdr_size) return false;
+
+  CompressedSensorDataPacket body_hdr;
+  memcpy(&body_hdr, body, body_hdr_size);
+  if (body_hdr.num_sensors > MAX_SENSORS_PER_BOARD) return false;
+  if (body_size < body_hdr_size + body_hdr.num_sensors) return false;
+
+  const uint8_t *chunks = body + body_hdr_size + body_hdr.num_sensors;
+  const uint8_t *end = body + body_size;
+
+  // Walk every varint once so next_chunk() cannot run off the end
+  const size_t num_varints = static_cast<size_t>(body_hdr.num_chunks) * (1u + body_hdr.num_sensors);
+  const uint8_t *ptr = chunks;
+  uint32_t scratch;
+  for (size_t i = 0; i < num_varints; ++i) {
+    ptr = read_varint(ptr, end, scratch);
+    if (!ptr) return false;
+  }
+
+  header_ = header;
+  sensor_ids_ = body + body_hdr_size;
+  chunks_ = chunks;
+  chunks_end_ = ptr;
+  num_chunks_ = body_hdr.num_chunks;
+  num_sensors_ = body_hdr.num_sensors;
+  rewind();
+  return true;
+}
+
+void CompressedSensorDataView::rewind() {
+  pos_ = chunks_;
+  next_index_ = 0;
+  prev_timestamp_ = header_.timestamp;
+  memset(prev_values_, 0, sizeof(prev_values_));
+}
+
+bool CompressedSensorDataView::next_chunk(uint32_t &timestamp_out, SensorDatapoint *datapoints_out) {
+  if (next_index_ >= num_chunks_) return false;
+
+  uint32_t delta = 0;
+  pos_ = read_varint(pos_, chunks_end_, delta);
+  prev_timestamp_ += zigzag_decode(delta);
+  timestamp_out = prev_timestamp_;
+
+  for (uint8_t s = 0; s < num_sensors_; ++s) {
+    pos_ = read_varint(pos_, chunks_end_, delta);
+    prev_values_[s] += zigzag_decode(delta);
+    datapoints_out[s].sensor_id = sensor_ids_[s];
+    datapoints_out[s].data = prev_values_[s];
+  }
+
+  ++next_index_;
+  return true;
+}
+
+} // namespace Diablo
@@ -0,0 +1,336 @@
+#pragma once
+
+#include "DiabloEnums.h"   // For enums like PacketType
+#include "DiabloPackets.h" // For all packet data structures
+#include <stddef.h>        // For size_t
+#include <stdint.h>        // For standard integer types
+#include <string.h>        // For memcpy
+
+namespace Diablo {
+
+//==============================================================================
+// NON-OWNING PACKET VIEWS
+//
+// These types point straight into a received packet buffer instead of copying
+// it into vectors. They never allocate, and they are only valid for as long as
+// the buffer they were created from.
+//==============================================================================
+
+/**
+ * @brief Read-only view of a contiguous array of packed wire structs.
+ *
+ * Elements are copied out with memcpy on access, so the underlying buffer does
+ * not need any particular alignment.
+ */
+template <typename T>
+class PackedArrayView {
+ public:
+  PackedArrayView() : data_(nullptr), count_(0) {}
+  PackedArrayView(const uint8_t *data, size_t count)
+      : data_(data), count_(count) {}
+
+  /**
+   * @brief Get the element at the given index (no bounds check).
+   */
+  T operator[](size_t index) const {
+    T value;
+    memcpy(&value, data_ + index * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  /**
+   * @brief Copy all elements into out, which must hold at least size() items.
+   */
+  void copy_to(T *out) const {
+    if (count_) {
+      memcpy(out, data_, count_ * sizeof(T));
+    }
+  }
+
+  size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  /**
+   * @brief Raw wire bytes of the array (size() * sizeof(T) bytes).
+   */
+  const uint8_t *data() const { return data_; }
+
+ private:
+  const uint8_t *data_;
+  size_t count_;
+};
+
+/**
+ * @brief View of one SensorDataChunk and its datapoints inside a packet.
+ */
+class SensorDataChunkView {
+ public:
+  SensorDataChunkView() : data_(nullptr), num_sensors_(0) {}
+  SensorDataChunkView(const uint8_t *data, uint8_t num_sensors)
+      : data_(data), num_sensors_(num_sensors) {}
+
+  /**
+   * @brief Timestamp of this chunk.
+   */
+  uint32_t timestamp() const {
+    SensorDataChunk chunk_hdr;
+    memcpy(&chunk_hdr, data_, sizeof(SensorDataChunk));
+    return chunk_hdr.timestamp;
+  }
+
+  /**
+   * @brief The num_sensors datapoints that follow the chunk timestamp.
+   */
+  PackedArrayView<SensorDatapoint> datapoints() const {
+    return PackedArrayView<SensorDatapoint>(data_ + sizeof(SensorDataChunk),
+                                            num_sensors_);
+  }
+
+  /**
+   * @brief Get a single datapoint (no bounds check).
+   */
+  SensorDatapoint operator[](size_t index) const { return datapoints()[index]; }
+
+  size_t size() const { return num_sensors_; }
+
+ private:
+  const uint8_t *data_;
+  uint8_t num_sensors_;
+};
+
+/**
+ * @brief View of a whole Sensor Data packet.
+ *
+ * Created by parse_sensor_data_view(), which checks the header and length once.
+ * After that, chunks and datapoints are read straight out of the buffer.
+ */
+class SensorDataView {
+ public:
+  SensorDataView() : body_(nullptr), num_chunks_(0), num_sensors_(0) {
+    header_.packet_type = PacketType::SENSOR_DATA;
+    header_.version = 0;
+    header_.timestamp = 0;
+  }
+
+  /**
+   * @brief Point this view at a Sensor Data body (the bytes after PacketHeader).
+   *
+   * The packet type is not checked here; callers that have already classified
+   * the packet can use this to skip re-reading the header.
+   *
+   * @return true if body_size holds every chunk announced by the body header.
+   */
+  bool reset(const PacketHeader &header, const uint8_t *body, size_t body_size) {
+    if (!body || body_size < sizeof(SensorDataPacket)) return false;
+
+    SensorDataPacket body_hdr;
+    memcpy(&body_hdr, body, sizeof(SensorDataPacket));
+
+    const size_t per_chunk_size = chunk_size(body_hdr.num_sensors);
+    const size_t expected_size = sizeof(SensorDataPacket) + (static_cast<size_t>(body_hdr.num_chunks) * per_chunk_size);
+    if (body_size < expected_size) return false;
+
+    header_ = header;
+    body_ = body;
+    num_chunks_ = body_hdr.num_chunks;
+    num_sensors_ = body_hdr.num_sensors;
+    return true;
+  }
+
+  /**
+   * @brief Get the chunk at the given index (no bounds check).
+   */
+  SensorDataChunkView chunk(size_t index) const {
+    return SensorDataChunkView(chunks_begin() + index * chunk_size(num_sensors_),
+                               num_sensors_);
+  }
+
+  SensorDataChunkView operator[](size_t index) const { return chunk(index); }
+
+  const PacketHeader &header() const { return header_; }
+  uint8_t num_chunks() const { return num_chunks_; }
+  uint8_t num_sensors() const { return num_sensors_; }
+
+  /**
+   * @brief Raw wire bytes of the first chunk; chunks are chunk_size() apart.
+   */
+  const uint8_t *chunks_begin() const { return body_ + sizeof(SensorDataPacket); }
+
+  /**
+   * @brief Size in bytes of one chunk on the wire.
+   */
+  static size_t chunk_size(uint8_t num_sensors) {
+    return sizeof(SensorDataChunk) + (static_cast<size_t>(num_sensors) * sizeof(SensorDatapoint));
+  }
+
+ private:
+  PacketHeader header_;
+  const uint8_t *body_;
+  uint8_t num_chunks_;
+  uint8_t num_sensors_;
+};
+
+/**
+ * @brief Sequential decoder over a Compressed Sensor Data packet.
+ *
+ * Created by parse_compressed_sensor_data_view(), which walks every varint
+ * once to validate the packet. Chunks are then decoded in order with
+ * next_chunk(); rewind() starts over from the first chunk. Nothing is copied
+ * out of the buffer except the decoded values.
+ */
+class CompressedSensorDataView {
+ public:
+  CompressedSensorDataView();
+
+  /**
+   * @brief Point this view at a Compressed Sensor Data body (the bytes after
+   * PacketHeader) and validate it.
+   *
+   * The packet type is not checked here.
+   *
+   * @return true if the body is complete and num_sensors <= MAX_SENSORS_PER_BOARD.
+   */
+  bool reset(const PacketHeader &header, const uint8_t *body, size_t body_size);
+
+  /**
+   * @brief Decode the next chunk.
+   * @param timestamp_out Set to the chunk timestamp.
+   * @param datapoints_out Receives num_sensors() datapoints.
+   * @return false once every chunk has been decoded.
+   */
+  bool next_chunk(uint32_t &timestamp_out, SensorDatapoint *datapoints_out);
+
+  /**
+   * @brief Restart decoding from the first chunk.
+   */
+  void rewind();
+
+  const PacketHeader &header() const { return header_; }
+  uint8_t num_chunks() const { return num_chunks_; }
+  uint8_t num_sensors() const { return num_sensors_; }
+  PackedArrayView<uint8_t> sensor_ids() const { return PackedArrayView<uint8_t>(sensor_ids_, num_sensors_); }
+
+ private:
+  PacketHeader header_;
+  const uint8_t *sensor_ids_;
+  const uint8_t *chunks_;     // First varint of the first chunk
+  const uint8_t *chunks_end_;
+  const uint8_t *pos_;        // Next varint to decode
+  uint8_t num_chunks_;
+  uint8_t num_sensors_;
+  uint8_t next_index_;
+  uint32_t prev_timestamp_;
+  uint32_t prev_values_[MAX_SENSORS_PER_BOARD];
+};
+
+/**
+ * @brief View of a Self Test body (adc_good + SelfTestResult array).
+ */
+struct SelfTestView {
+  uint8_t adc_good;
+  PackedArrayView<SelfTestResult> results;
+
+  SelfTestView() : adc_good(0) {}
+
+  /**
+   * @brief Point this view at a Self Test body (the bytes after PacketHeader).
+   * @return true if body_size holds every announced result.
+   */
+  bool reset(const uint8_t *body, size_t body_size) {
+    if (!body || body_size < sizeof(SelfTestPacket)) return false;
+
+    SelfTestPacket body_hdr;
+    memcpy(&body_hdr, body, sizeof(SelfTestPacket));
+    const size_t results_bytes = static_cast<size_t>(body_hdr.num_sensors) * sizeof(SelfTestResult);
+    if (body_size < sizeof(SelfTestPacket) + results_bytes) return false;
+
+    adc_good = body_hdr.adc_good;
+    results = PackedArrayView<SelfTestResult>(body + sizeof(SelfTestPacket), body_hdr.num_sensors);
+    return true;
+  }
+};
+
+/**
+ * @brief View of a Sensor Config body. Mirrors SensorConfigData.
+ */
+struct SensorConfigView {
+  PackedArrayView<uint8_t> sensor_ids;
+  uint8_t reference_voltage;
+  bool necessary_for_abort;
+  uint32_t controller_ip; // 0 if necessary_for_abort is false
+  uint8_t enable_serial_printing;
+
+  SensorConfigView()
+      : reference_voltage(0), necessary_for_abort(false), controller_ip(0), enable_serial_printing(0) {}
+
+  /**
+   * @brief Point this view at a Sensor Config body (the bytes after PacketHeader).
+   * @return true if body_size holds the whole variable-length body.
+   */
+  bool reset(const uint8_t *body, size_t body_size) {
+    // Minimum body: num_sensors(1) + ref_voltage(1) + necessary_for_abort(1) + enable_serial(1)
+    if (!body || body_size < 4u) return false;
+
+    const uint8_t num_sensors = body[0];
+    const size_t ids_end = 1u + num_sensors;
+    if (body_size < ids_end + 3u) return false;
+
+    const uint8_t abort_flag = body[ids_end + 1u];
+    const size_t tail = abort_flag ? sizeof(uint32_t) : 0u;
+    if (body_size < ids_end + 3u + tail) return false;
+
+    sensor_ids = PackedArrayView<uint8_t>(body + 1, num_sensors);
+    reference_voltage = body[ids_end];
+    necessary_for_abort = (abort_flag != 0);
+    controller_ip = 0;
+    if (necessary_for_abort) {
+      memcpy(&controller_ip, body + ids_end + 2u, sizeof(uint32_t));
+    }
+    enable_serial_printing = body[ids_end + 2u + tail];
+    return true;
+  }
+};
+
+/**
+ * @brief View of an Actuator Config body (abort actuators and abort PTs).
+ */
+struct ActuatorConfigView {
+  uint8_t is_abort_controller;
+  PackedArrayView<AbortActuatorLocation> abort_actuators;
+  PackedArrayView<AbortPTLocation> abort_pts;
+  uint8_t enable_serial_printing;
+
+  ActuatorConfigView() : is_abort_controller(0), enable_serial_printing(0) {}
+
+  /**
+   * @brief Point this view at an Actuator Config body (the bytes after PacketHeader).
+   * @return true if body_size holds every announced actuator and PT entry.
+   */
+  bool reset(const uint8_t *body, size_t body_size) {
+    const size_t config_header_size = sizeof(ActuatorConfigPacket);
+    const size_t pt_count_size = sizeof(AbortPTSectionHeader);
+    const size_t trailer_size = 1u; // enable_serial_printing
+    if (!body || body_size < config_header_size + pt_count_size + trailer_size) return false;
+
+    ActuatorConfigPacket config;
+    memcpy(&config, body, config_header_size);
+    const size_t actuator_bytes = static_cast<size_t>(config.num_abort_actuators) * sizeof(AbortActuatorLocation);
+    if (body_size < config_header_size + actuator_bytes + pt_count_size + trailer_size) return false;
+
+    const uint8_t *ptr = body + config_header_size + actuator_bytes;
+    AbortPTSectionHeader pt_header;
+    memcpy(&pt_header, ptr, pt_count_size);
+    ptr += pt_count_size;
+
+    const size_t pt_entries_bytes = static_cast<size_t>(pt_header.num_abort_pts) * sizeof(AbortPTLocation);
+    if (body_size < config_header_size + actuator_bytes + pt_count_size + pt_entries_bytes + trailer_size) return false;
+
+    is_abort_controller = config.is_abort_controller;
+    abort_actuators = PackedArrayView<AbortActuatorLocation>(body + config_header_size, config.num_abort_actuators);
+    abort_pts = PackedArrayView<AbortPTLocation>(ptr, pt_header.num_abort_pts);
+    enable_serial_printing = ptr[pt_entries_bytes];
+    return true;
+  }
+};
+
+} // namespace Diablo
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "DiabloConfig.h"
 #include "DiabloEnums.h"
+#include <stddef.h>
 #include <stdint.h>
 #include <vector>
 
@@ -38,8 +40,22 @@ struct __attribute__((packed)) BoardHeartbeatPacket {
  */
 struct __attribute__((packed)) ServerHeartbeatPacket {
   EngineState engine_state;
+  uint8_t load_hint; // Ground station ingest load: 0 = idle, 255 = saturated (0 if not sent)
 };
 
+//==============================================================================
+// Abort Packets
+//
+// ABORT, ABORT_DONE, CLEAR_ABORT and NO_CONNECTION_ABORT carry no body; the
+// PacketHeader is the whole packet. These empty tags name them for
+// PacketSchema and are never copied to or from the wire.
+//==============================================================================
+
+struct AbortPacket {};
+struct AbortDonePacket {};
+struct ClearAbortPacket {};
+struct NoConnectionAbortPacket {};
+
 //==============================================================================
 // Sensor Data
 //
@@ -145,6 +161,125 @@ struct SensorDataChunkCollection {
   void clear() { datapoints.clear(); }
 };
 
+/**
+ * @brief Fixed-capacity version of SensorDataChunkCollection.
+ *
+ * Same API as SensorDataChunkCollection, but the datapoints live in an inline
+ * array of MAX_SENSORS_PER_BOARD entries, so filling a chunk never touches the
+ * heap. num_sensors is clamped to MAX_SENSORS_PER_BOARD.
+ *
+ * @note This is NOT a packed struct. Use the packed SensorDataChunk for
+ *       network packets.
+ */
+struct FixedSensorDataChunkCollection {
+  uint32_t timestamp; // Timestamp for this data chunk
+  SensorDatapoint datapoints[MAX_SENSORS_PER_BOARD];
+  uint8_t num_sensors;
+  uint8_t count; // Number of datapoints added so far
+
+  FixedSensorDataChunkCollection() : timestamp(0), num_sensors(0), count(0) {}
+
+  /**
+   * @brief Constructor with timestamp
+   * @param ts The timestamp for this data chunk
+   * @param num_sensors The number of sensor datapoints for this chunk
+   */
+  FixedSensorDataChunkCollection(uint32_t ts, uint8_t num_sensors) { reset(ts, num_sensors); }
+
+  /**
+   * @brief Reuse this chunk for a new timestamp, dropping all datapoints
+   * @param ts The timestamp for this data chunk
+   * @param n The number of sensor datapoints for this chunk
+   */
+  void reset(uint32_t ts, uint8_t n) {
+    timestamp = ts;
+    num_sensors = n > MAX_SENSORS_PER_BOARD ? MAX_SENSORS_PER_BOARD : n;
+    count = 0;
+  }
+
+  /**
+   * @brief Add a sensor datapoint to this chunk
+   * @param sensor_id The ID of the sensor
+   * @param data The sensor reading value
+   * @return True if successfully added, false if array is full
+   */
+  bool add_datapoint(uint8_t sensor_id, uint32_t data) {
+    if (count >= num_sensors) {
+      return false; // Array is full
+    }
+    datapoints[count].sensor_id = sensor_id;
+    datapoints[count].data = data;
+    ++count;
+    return true;
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count >= num_sensors; }
+  void clear() { count = 0; }
+};
+
+/**
+ * @brief Fixed-capacity list of up to MAX_CHUNKS_PER_PACKET chunks.
+ *
+ * Holds everything needed for one Sensor Data packet without any heap use.
+ */
+struct FixedSensorDataChunkList {
+  FixedSensorDataChunkCollection chunks[MAX_CHUNKS_PER_PACKET];
+  uint8_t count; // Number of chunks in use
+
+  FixedSensorDataChunkList() : count(0) {}
+
+  /**
+   * @brief Start a new chunk at the end of the list
+   * @param ts The timestamp for the new chunk
+   * @param num_sensors The number of sensor datapoints for the new chunk
+   * @return Pointer to the new chunk, or nullptr if the list is full
+   */
+  FixedSensorDataChunkCollection *add_chunk(uint32_t ts, uint8_t num_sensors) {
+    if (count >= MAX_CHUNKS_PER_PACKET) {
+      return nullptr;
+    }
+    FixedSensorDataChunkCollection *chunk = &chunks[count++];
+    chunk->reset(ts, num_sensors);
+    return chunk;
+  }
+
+  FixedSensorDataChunkCollection &operator[](size_t index) { return chunks[index]; }
+  const FixedSensorDataChunkCollection &operator[](size_t index) const { return chunks[index]; }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count >= MAX_CHUNKS_PER_PACKET; }
+  void clear() { count = 0; }
+};
+
+//==============================================================================
+// Compressed Sensor Data
+//==============================================================================
+
+/**
+ * @brief Fixed-size header of a Compressed Sensor Data packet.
+ *
+ * Carries the same chunks as a Sensor Data packet, delta-encoded against the
+ * previous chunk and packed as zigzag varints (1-5 bytes each).
+ *
+ * Full packet layout (after standard PacketHeader):
+ * - This struct (2 bytes): num_chunks (C), num_sensors (N)
+ * - N x uint8_t sensor_id (every chunk carries the sensors in this order)
+ * - C x chunk, each:
+ *   - varint zigzag(timestamp - previous timestamp); the first chunk is
+ *     relative to PacketHeader.timestamp
+ *   - N x varint zigzag(data - previous data for that sensor); the first
+ *     chunk is relative to 0
+ * Differences are taken modulo 2^32, so any uint32_t values round-trip.
+ */
+struct __attribute__((packed)) CompressedSensorDataPacket {
+  uint8_t num_chunks;
+  uint8_t num_sensors;
+  // Followed by N sensor ids and C varint-encoded chunks
+};
+
 //==============================================================================
 // Sensor Config
 //==============================================================================
@@ -0,0 +1,171 @@
+#include "DiabloSequence.h"
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy
+#include <cstddef> // For size_t
+
+namespace Diablo {
+
+size_t append_sequence_trailer(uint8_t *buffer, size_t packet_size, size_t buffer_size,
+                               uint16_t sequence) {
+  if (!buffer || packet_size < sizeof(PacketHeader)) return 0;
+  if (buffer_size < packet_size + DIABLO_SEQUENCE_SIZE) return 0;
+
+  uint8_t &version = buffer[offsetof(PacketHeader, version)];
+  if (version & (DIABLO_VERSION_FLAG_SEQUENCE | DIABLO_VERSION_FLAG_CRC32C)) return 0;
+
+  version = static_cast<uint8_t>(version | DIABLO_VERSION_FLAG_SEQUENCE);
+  buffer[packet_size] = static_cast<uint8_t>(sequence);
+  buffer[packet_size + 1] = static_cast<uint8_t>(sequence >> 8);
+  return packet_size + DIABLO_SEQUENCE_SIZE;
+}
+
+bool read_sequence_trailer(const uint8_t *buffer, size_t packet_size, uint16_t &sequence_out) {
+  if (!buffer || packet_size < sizeof(PacketHeader) + DIABLO_SEQUENCE_SIZE) return false;
+  if (!(buffer[offsetof(PacketHeader, version)] & DIABLO_VERSION_FLAG_SEQUENCE)) return false;
+
+  const uint8_t *trailer = buffer + packet_size - DIABLO_SEQUENCE_SIZE;
+  sequence_out = static_cast<uint16_t>(trailer[0] | (trailer[1] << 8));
+  return true;
+}
+
+//==============================================================================
+// PacketSequencer
+//==============================================================================
+
+size_t PacketSequencer::stamp(uint8_t *buffer, size_t packet_size, size_t buffer_size) {
+  if (!buffer || packet_size < sizeof(PacketHeader)) return 0;
+  uint16_t &next = next_[buffer[offsetof(PacketHeader, packet_type)] & kTypeMask];
+
+  const size_t stamped = append_sequence_trailer(buffer, packet_size, buffer_size, next);
+  if (stamped) ++next;
+  return stamped;
+}
+
+void PacketSequencer::reset() {
+  memset(next_, 0, sizeof(next_));
+}
+
+//==============================================================================
+// SequenceWindow
+//==============================================================================
+
+SequenceResult SequenceWindow::classify(uint16_t sequence, const uint32_t *timestamp) const {
+  if (!started_) return SequenceResult::IN_ORDER;
+
+  // Serial-number distance from the newest packet, in [-32768, 32767]
+  const int16_t delta = static_cast<int16_t>(static_cast<uint16_t>(sequence - newest_));
+  if (delta > 0) return SequenceResult::IN_ORDER;
+
+  const uint32_t age = static_cast<uint32_t>(-static_cast<int32_t>(delta));
+  if (age < DIABLO_SEQUENCE_WINDOW && !(seen_ & (static_cast<uint64_t>(1) << age))) {
+    return SequenceResult::REORDERED;
+  }
+  if (age > DIABLO_SEQUENCE_RESYNC_DISTANCE) return SequenceResult::RESYNC;
+
+  // Would be rejected: unless the sender has restarted its counter
+  if (timestamp && has_timestamp_) {
+    const int32_t drift = static_cast<int32_t>(*timestamp - newest_timestamp_);
+    if (drift > DIABLO_SEQUENCE_RESYNC_TIME_MS) return SequenceResult::RESYNC;
+    if (drift < -DIABLO_SEQUENCE_RESYNC_TIME_MS && sequence < DIABLO_SEQUENCE_WINDOW) return SequenceResult::RESYNC;
+  }
+  if (consecutive_rejects_ + 1 >= DIABLO_SEQUENCE_RESYNC_REJECTS) return SequenceResult::RESYNC;
+
+  return age < DIABLO_SEQUENCE_WINDOW ? SequenceResult::DUPLICATE : SequenceResult::STALE;
+}
+
+SequenceResult SequenceWindow::record(uint16_t sequence, const uint32_t *timestamp) {
+  const SequenceResult result = classify(sequence, timestamp);
+  switch (result) {
+    case SequenceResult::IN_ORDER:
+      if (!started_) {
+        started_ = true;
+        seen_ = 1;
+      } else {
+        // Everything between newest_ and sequence is missing for now
+        const int16_t delta = static_cast<int16_t>(static_cast<uint16_t>(sequence - newest_));
+        lost += static_cast<uint32_t>(delta - 1);
+        seen_ = (delta < DIABLO_SEQUENCE_WINDOW) ? ((seen_ << delta) | 1u) : 1u;
+      }
+      break;
+    case SequenceResult::REORDERED:
+      seen_ |= static_cast<uint64_t>(1) << static_cast<uint16_t>(newest_ - sequence);
+      if (lost) --lost; // It was counted as lost when the gap opened
+      ++reordered;
+      break;
+    case SequenceResult::RESYNC:
+      seen_ = 1;
+      ++resyncs;
+      break;
+    case SequenceResult::DUPLICATE:
+    case SequenceResult::STALE:
+      if (result == SequenceResult::DUPLICATE) {
+        ++duplicates;
+      } else {
+        ++stale;
+      }
+      ++consecutive_rejects_;
+      return result;
+    default:
+      return result;
+  }
+
+  ++received;
+  consecutive_rejects_ = 0;
+  if (result != SequenceResult::REORDERED) {
+    newest_ = sequence;
+    has_timestamp_ = timestamp != nullptr;
+    newest_timestamp_ = timestamp ? *timestamp : 0;
+  }
+  return result;
+}
+
+SequenceResult SequenceWindow::check(uint16_t sequence, uint32_t timestamp) {
+  return record(sequence, &timestamp);
+}
+
+SequenceResult SequenceWindow::check(uint16_t sequence) {
+  return record(sequence, nullptr);
+}
+
+void SequenceWindow::reset() {
+  received = 0;
+  lost = 0;
+  reordered = 0;
+  duplicates = 0;
+  stale = 0;
+  resyncs = 0;
+  seen_ = 0;
+  newest_timestamp_ = 0;
+  newest_ = 0;
+  consecutive_rejects_ = 0;
+  has_timestamp_ = false;
+  started_ = false;
+}
+
+//==============================================================================
+// BoardSequenceTracker
+//==============================================================================
+
+SequenceResult BoardSequenceTracker::check(const uint8_t *buffer, size_t packet_size) {
+  uint16_t sequence;
+  if (!read_sequence_trailer(buffer, packet_size, sequence)) return SequenceResult::UNSEQUENCED;
+  uint32_t timestamp;
+  memcpy(&timestamp, buffer + offsetof(PacketHeader, timestamp), sizeof(timestamp));
+  return windows_[buffer[offsetof(PacketHeader, packet_type)] & kTypeMask].check(sequence, timestamp);
+}
+
+SequenceResult BoardSequenceTracker::peek(const uint8_t *buffer, size_t packet_size) const {
+  uint16_t sequence;
+  if (!read_sequence_trailer(buffer, packet_size, sequence)) return SequenceResult::UNSEQUENCED;
+  uint32_t timestamp;
+  memcpy(&timestamp, buffer + offsetof(PacketHeader, timestamp), sizeof(timestamp));
+  return windows_[buffer[offsetof(PacketHeader, packet_type)] & kTypeMask].peek(sequence, timestamp);
+}
+
+void BoardSequenceTracker::reset() {
+  for (uint8_t i = 0; i < kNumStreams; ++i) {
+    windows_[i].reset();
+  }
+}
+
+} // namespace Diablo
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "DiabloConfig.h"  // For DIABLO_VERSION_FLAG_SEQUENCE, DIABLO_VERSION_FLAGS_MASK
+#include "DiabloCrc32c.h"  // For strip_crc_trailer
+#include "DiabloEnums.h"   // For PacketType
+#include "DiabloPackets.h" // For PacketHeader
+#include <stddef.h>        // For size_t, offsetof
+#include <stdint.h>        // For standard integer types
+#include <string.h>        // For memcpy
+
+namespace Diablo {
+
+//==============================================================================
+// SEQUENCE NUMBERS
+//
+// Any packet may carry an optional 2-byte little-endian sequence number,
+// signalled by DIABLO_VERSION_FLAG_SEQUENCE in PacketHeader.version. Each
+// board numbers each PacketType as its own stream, so a gap in SENSOR_DATA
+// means lost sensor data regardless of how often heartbeats are sent.
+//
+// Trailer layout: [header][body][sequence (2)][CRC-32C (4), optional]
+//
+// Senders stamp packets with PacketSequencer (before append_crc_trailer()).
+// Receivers keep one BoardSequenceTracker per board and pass it to
+// dispatch_packet(), which drops duplicates before the body is decoded and
+// marks a sequence number as seen only once its body has decoded. Abort-lane
+// packets are never dropped this way; their sequence numbers are only counted.
+//
+// A sender that reboots (or resets its PacketSequencer) starts every stream
+// at 0 again. A packet that would otherwise be DUPLICATE or STALE is taken as
+// such a restart, and the window resynchronized to it (RESYNC), when:
+// - its header timestamp is more than DIABLO_SEQUENCE_RESYNC_TIME_MS after
+//   that of the newest packet (a real duplicate is never newer), or
+// - its header timestamp is more than DIABLO_SEQUENCE_RESYNC_TIME_MS before
+//   that of the newest packet and its sequence number is below
+//   DIABLO_SEQUENCE_WINDOW (uptime and counter both restarted), or
+// - it is the DIABLO_SEQUENCE_RESYNC_REJECTS-th such packet in a row, or
+// - it is more than DIABLO_SEQUENCE_RESYNC_DISTANCE behind the newest.
+//==============================================================================
+
+/** Number of past sequence numbers remembered by a SequenceWindow. */
+#define DIABLO_SEQUENCE_WINDOW 64
+
+/**
+ * @brief A backwards jump larger than this is treated as the sender restarting
+ * rather than a very late packet.
+ */
+#define DIABLO_SEQUENCE_RESYNC_DISTANCE 1024
+
+/**
+ * @brief Header timestamps further than this from the newest packet's mark a
+ * would-be duplicate as coming from a restarted sender.
+ */
+#define DIABLO_SEQUENCE_RESYNC_TIME_MS 1000
+
+/**
+ * @brief This many DUPLICATE or STALE results in a row resynchronize the
+ * window on the last one.
+ */
+#define DIABLO_SEQUENCE_RESYNC_REJECTS 4
+
+/**
+ * @brief Appends a sequence number trailer and sets its flag.
+ *
+ * Must be called before append_crc_trailer() so the sequence number is
+ * covered by the CRC.
+ *
+ * @return The new packet size, or 0 on error (buffer too small, or the packet
+ * already has a sequence or CRC trailer).
+ */
+size_t append_sequence_trailer(uint8_t *buffer, size_t packet_size, size_t buffer_size,
+                               uint16_t sequence);
+
+/**
+ * @brief Reads the sequence number of a packet whose CRC trailer, if any, has
+ * already been stripped.
+ * @return false if the packet has no sequence trailer.
+ */
+bool read_sequence_trailer(const uint8_t *buffer, size_t packet_size, uint16_t &sequence_out);
+
+/**
+ * @brief Strips the sequence trailer, if the packet has one.
+ * @param packet_size In: bytes excluding any CRC trailer. Out: body end.
+ * @return false if the packet is flagged but too short to hold the trailer.
+ */
+inline bool strip_sequence_trailer(const uint8_t *buffer, size_t &packet_size) {
+  if (!buffer || packet_size < sizeof(PacketHeader)) return true;
+  if (!(buffer[offsetof(PacketHeader, version)] & DIABLO_VERSION_FLAG_SEQUENCE)) return true;
+  if (packet_size < sizeof(PacketHeader) + DIABLO_SEQUENCE_SIZE) return false;
+  packet_size -= DIABLO_SEQUENCE_SIZE;
+  return true;
+}
+
+/**
+ * @brief Verifies and strips every optional trailer (CRC, then sequence).
+ * @param require_crc Reject packets without a CRC trailer.
+ * @return false if a trailer is present but invalid, or the CRC is missing
+ * and required.
+ */
+inline bool strip_packet_trailers(const uint8_t *buffer, size_t &packet_size,
+                                  bool require_crc = DIABLO_COMMS_REQUIRE_CRC32C) {
+  return strip_crc_trailer(buffer, packet_size, require_crc) && strip_sequence_trailer(buffer, packet_size);
+}
+
+/**
+ * @brief Copies the PacketHeader of a received packet with the trailer flags
+ * cleared from version, so callers see only the protocol version.
+ */
+inline void read_packet_header(const uint8_t *buffer, PacketHeader &header_out) {
+  memcpy(&header_out, buffer, sizeof(PacketHeader));
+  header_out.version = static_cast<uint8_t>(header_out.version & ~DIABLO_VERSION_FLAGS_MASK);
+}
+
+/**
+ * @brief Sender-side sequence counters, one per PacketType.
+ *
+ * Typical use:
+ * @code
+ *   size_t n = create_sensor_data_packet(...);
+ *   n = sequencer.stamp(buffer, n, sizeof(buffer));
+ *   n = append_crc_trailer(buffer, n, sizeof(buffer));
+ * @endcode
+ */
+class PacketSequencer {
+ public:
+  PacketSequencer() { reset(); }
+
+  /**
+   * @brief Appends the next sequence number for the packet's type.
+   * @return The new packet size, or 0 on error (see append_sequence_trailer).
+   * The counter only advances on success.
+   */
+  size_t stamp(uint8_t *buffer, size_t packet_size, size_t buffer_size);
+
+  /**
+   * @brief The sequence number the next packet of this type will carry.
+   */
+  uint16_t peek(PacketType type) const { return next_[static_cast<uint8_t>(type) & kTypeMask]; }
+
+  /**
+   * @brief Restart every stream at zero.
+   */
+  void reset();
+
+ private:
+  static const uint8_t kNumStreams = 16;
+  static const uint8_t kTypeMask = kNumStreams - 1;
+
+  uint16_t next_[kNumStreams];
+};
+
+/**
+ * @brief Result of checking one received sequence number.
+ */
+enum class SequenceResult : uint8_t {
+  IN_ORDER = 0,    // Newest packet so far (possibly after a gap)
+  REORDERED = 1,   // Older than the newest, not seen before; fills a gap
+  DUPLICATE = 2,   // Already received; should be discarded
+  STALE = 3,       // Too old to tell whether it was seen; should be discarded
+  RESYNC = 4,      // Sender restarted its counter; window reset (see SEQUENCE NUMBERS)
+  UNSEQUENCED = 5  // Packet has no sequence trailer
+};
+
+/**
+ * @brief Receive-side sliding window for one stream.
+ *
+ * Remembers the last DIABLO_SEQUENCE_WINDOW sequence numbers as a bitmap
+ * relative to the newest one seen. Every check is O(1). Sequence numbers use
+ * 16-bit serial arithmetic, so wrap-around is handled.
+ *
+ * Counters:
+ * - lost: gaps skipped over by newer packets, minus gaps later filled by
+ *   reordered packets. Packets that never arrive stay counted as lost.
+ * - reordered, duplicates, stale, resyncs: one per matching SequenceResult.
+ */
+class SequenceWindow {
+ public:
+  SequenceWindow() { reset(); }
+
+  /**
+   * @brief Records a received sequence number.
+   * @param timestamp The packet's header timestamp, for the timestamp
+   * resync rules. Without it only the other rules apply.
+   * @return How the packet relates to the stream so far.
+   */
+  SequenceResult check(uint16_t sequence, uint32_t timestamp);
+  SequenceResult check(uint16_t sequence);
+
+  /**
+   * @brief What check() would return, without recording anything.
+   */
+  SequenceResult peek(uint16_t sequence, uint32_t timestamp) const { return classify(sequence, &timestamp); }
+  SequenceResult peek(uint16_t sequence) const { return classify(sequence, nullptr); }
+
+  /**
+   * @brief Forget the stream and zero all counters.
+   */
+  void reset();
+
+  bool started() const { return started_; }
+  uint16_t newest() const { return newest_; }
+
+  uint32_t received;   // Packets accepted (IN_ORDER, REORDERED or RESYNC)
+  uint32_t lost;
+  uint32_t reordered;
+  uint32_t duplicates;
+  uint32_t stale;
+  uint32_t resyncs;
+
+ private:
+  SequenceResult classify(uint16_t sequence, const uint32_t *timestamp) const;
+  SequenceResult record(uint16_t sequence, const uint32_t *timestamp);
+
+  uint64_t seen_;    // Bit i set: newest_ - i has been received
+  uint32_t newest_timestamp_;
+  uint16_t newest_;
+  uint8_t consecutive_rejects_;
+  bool has_timestamp_; // newest_timestamp_ is valid
+  bool started_;
+};
+
+/**
+ * @brief One SequenceWindow per PacketType for a single board.
+ */
+class BoardSequenceTracker {
+ public:
+  /**
+   * @brief Checks the sequence number of a received packet.
+   *
+   * The packet's CRC trailer, if any, must already have been verified and
+   * stripped (dispatch_packet() does this). The header timestamp feeds the
+   * resync rules.
+   *
+   * @return SequenceResult::UNSEQUENCED if the packet has no sequence trailer.
+   */
+  SequenceResult check(const uint8_t *buffer, size_t packet_size);
+
+  /**
+   * @brief What check() would return, without recording anything. Used to
+   * reject duplicates before decoding and record the packet only after.
+   */
+  SequenceResult peek(const uint8_t *buffer, size_t packet_size) const;
+
+  /**
+   * @brief Window for one stream.
+   */
+  SequenceWindow &stream(PacketType type) { return windows_[static_cast<uint8_t>(type) & kTypeMask]; }
+  const SequenceWindow &stream(PacketType type) const { return windows_[static_cast<uint8_t>(type) & kTypeMask]; }
+
+  /**
+   * @brief Reset every stream (e.g. when the board reports SETUP again).
+   */
+  void reset();
+
+ private:
+  static const uint8_t kNumStreams = 16;
+  static const uint8_t kTypeMask = kNumStreams - 1;
+
+  SequenceWindow windows_[kNumStreams];
+};
+
+} // namespace Diablo
@@ -0,0 +1,211 @@
+#pragma once
+
+#include "DiabloConfig.h"      // For MAX_SENSORS_PER_BOARD
+#include "DiabloPackets.h"     // For FixedSensorDataChunkCollection
+#include "DiabloPacketViews.h" // For SensorDataView
+#include <atomic>              // For std::atomic
+#include <stddef.h>            // For size_t
+#include <stdint.h>            // For standard integer types
+
+namespace Diablo {
+
+//==============================================================================
+// SPSC RING
+//
+// Lock-free single-producer/single-consumer ring for handing decoded data
+// between threads (e.g. network thread -> logger). The producer fills slots
+// in place and publishes them in batches; the consumer reads slots in place
+// and releases them in batches. No locks, no allocation after construction.
+//==============================================================================
+
+/** Assumed cache line size for padding shared indices. */
+#define DIABLO_CACHE_LINE_SIZE 64
+
+/**
+ * @brief Bounded lock-free single-producer/single-consumer ring.
+ *
+ * Exactly one thread may call the producer methods (write_available,
+ * can_write, write_slot, reserve, commit, try_push) and exactly one thread the consumer
+ * methods (read_available, read_slot, front, release, try_pop). Slots stay
+ * owned by one side between reserve/commit and read/release, so both sides can
+ * work on slots in place.
+ *
+ * The head and tail indices live on separate cache lines, and each side keeps
+ * a cached copy of the other side's index so the shared line is only re-read
+ * when the ring looks full (producer) or empty (consumer). Feeding several
+ * consumer threads takes one ring per consumer.
+ *
+ * Typical use:
+ * @code
+ *   // Network thread
+ *   decode_sensor_data_into_ring(view, ring);
+ *
+ *   // Logger thread
+ *   const size_t n = ring.read_available();
+ *   for (size_t i = 0; i < n; ++i) log(ring.read_slot(i));
+ *   ring.release(n);
+ * @endcode
+ *
+ * @tparam T Slot type.
+ * @tparam Capacity Number of slots; must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+ public:
+  SpscRing() : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {}
+
+  static size_t capacity() { return Capacity; }
+
+  //------------------------------------------------------------------------------
+  // Producer
+  //------------------------------------------------------------------------------
+
+  /**
+   * @brief Number of slots the producer can fill before the next commit().
+   */
+  size_t write_available() {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    return Capacity - (head_.load(std::memory_order_relaxed) - cached_tail_);
+  }
+
+  /**
+   * @brief Whether count slots are free, re-reading the consumer's index only
+   * if the cached copy says they are not.
+   */
+  bool can_write(size_t count) {
+    if (Capacity - (head_.load(std::memory_order_relaxed) - cached_tail_) >= count) return true;
+    return write_available() >= count;
+  }
+
+  /**
+   * @brief The index-th unpublished slot (index < write_available(), or a
+   * count just confirmed by can_write()).
+   */
+  T &write_slot(size_t index) {
+    return slots_[(head_.load(std::memory_order_relaxed) + index) & kMask];
+  }
+
+  /**
+   * @brief Next free slot, or nullptr if the ring is full.
+   *
+   * Calling reserve() again before commit() returns the same slot.
+   */
+  T *reserve() { return can_write(1) ? &write_slot(0) : nullptr; }
+
+  /**
+   * @brief Publish the next count filled slots to the consumer.
+   */
+  void commit(size_t count = 1) {
+    head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy item into the ring.
+   * @return false if the ring is full.
+   */
+  bool try_push(const T &item) {
+    T *slot = reserve();
+    if (!slot) return false;
+    *slot = item;
+    commit();
+    return true;
+  }
+
+  //------------------------------------------------------------------------------
+  // Consumer
+  //------------------------------------------------------------------------------
+
+  /**
+   * @brief Number of published slots the consumer can read.
+   *
+   * Re-reads the producer's index only once the slots already known about
+   * have been released, so the result may lag behind the producer.
+   */
+  size_t read_available() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (cached_head_ != tail) return cached_head_ - tail;
+    cached_head_ = head_.load(std::memory_order_acquire);
+    return cached_head_ - tail;
+  }
+
+  /**
+   * @brief The index-th published slot (index < read_available()).
+   */
+  const T &read_slot(size_t index) const {
+    return slots_[(tail_.load(std::memory_order_relaxed) + index) & kMask];
+  }
+
+  /**
+   * @brief Oldest published slot, or nullptr if the ring is empty.
+   */
+  const T *front() { return read_available() ? &read_slot(0) : nullptr; }
+
+  /**
+   * @brief Return the count oldest slots to the producer.
+   */
+  void release(size_t count = 1) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy out and release the oldest slot.
+   * @return false if the ring is empty.
+   */
+  bool try_pop(T &item_out) {
+    const T *slot = front();
+    if (!slot) return false;
+    item_out = *slot;
+    release();
+    return true;
+  }
+
+ private:
+  static const size_t kMask = Capacity - 1;
+
+  // Producer-owned line: write index plus its view of the read index
+  alignas(DIABLO_CACHE_LINE_SIZE) std::atomic<size_t> head_;
+  size_t cached_tail_;
+
+  // Consumer-owned line: read index plus its view of the write index
+  alignas(DIABLO_CACHE_LINE_SIZE) std::atomic<size_t> tail_;
+  size_t cached_head_;
+
+  alignas(DIABLO_CACHE_LINE_SIZE) T slots_[Capacity];
+};
+
+/**
+ * @brief Decodes every chunk of a Sensor Data packet straight into ring slots.
+ *
+ * All chunks are published with a single commit(), so the consumer never sees
+ * part of a packet. Packets with more than MAX_SENSORS_PER_BOARD sensors are
+ * rejected.
+ *
+ * @return The number of chunks written, or 0 if the packet does not fit in the
+ * free slots (nothing is written in that case).
+ */
+template <size_t Capacity>
+size_t decode_sensor_data_into_ring(const SensorDataView &view,
+                                    SpscRing<FixedSensorDataChunkCollection, Capacity> &ring) {
+  const uint8_t num_chunks = view.num_chunks();
+  const uint8_t num_sensors = view.num_sensors();
+  if (num_sensors > MAX_SENSORS_PER_BOARD) return 0;
+  if (num_chunks == 0 || !ring.can_write(num_chunks)) return 0;
+
+  for (uint8_t c = 0; c < num_chunks; ++c) {
+    const SensorDataChunkView chunk = view.chunk(c);
+    FixedSensorDataChunkCollection &slot = ring.write_slot(c);
+    slot.reset(chunk.timestamp(), num_sensors);
+    // Per-element copies of a known size beat one variable-length memcpy at
+    // this size (the compiler lowers the latter to rep movs)
+    for (uint8_t s = 0; s < num_sensors; ++s) {
+      slot.datapoints[s] = chunk[s];
+    }
+    slot.count = num_sensors;
+  }
+  ring.commit(num_chunks);
+  return num_chunks;
+}
+
+} // namespace Diablo
@@ -0,0 +1,606 @@
+#include "DiabloUring.h"
+
+#if defined(__linux__) && defined(DIABLO_COMMS_ENABLE_IO_URING)
+
+#include "DAQv2-Comms.h"
+#include <cstring> // For memcpy, memset
+#include <cstddef> // For size_t
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Diablo {
+
+namespace {
+
+const uint16_t kBufferGroup = 0;
+const uint64_t kReceiveTag = ~0ull;       // user_data of the multishot receive; sends carry their slot index
+const uint64_t kAbortPollTag = ~0ull - 1; // user_data of the multishot poll on the abort lane socket
+const unsigned kAbortLaneInterval = 64;   // Completions between checks of the abort lane socket
+const size_t kMaxBuffers = 32768;         // Buffer IDs are 16 bits and the ring size a power of two
+
+int sys_io_uring_setup(unsigned entries, struct io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg,
+                       size_t arg_size) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+int sys_io_uring_register(int fd, unsigned opcode, const void *arg, unsigned nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+unsigned next_power_of_two(size_t value) {
+  unsigned result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+void *map_anonymous(size_t size) {
+  void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+  return map == MAP_FAILED ? nullptr : map;
+}
+
+} // namespace
+
+struct UringTransport::SendSlot {
+  uint64_t index;
+  std::vector<uint8_t> data;
+  struct msghdr msg;
+  struct iovec iov;
+  struct sockaddr_in dest;
+};
+
+UringTransport::UringTransport()
+    : socket_fd_(-1),
+      abort_fd_(-1),
+      ring_fd_(-1),
+      port_(0),
+      sq_map_(nullptr),
+      sq_map_size_(0),
+      cq_map_(nullptr),
+      cq_map_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_array_(nullptr),
+      sq_mask_(0),
+      sq_entries_(0),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cqes_(nullptr),
+      cq_mask_(0),
+      sq_local_tail_(0),
+      buf_ring_(nullptr),
+      buf_ring_size_(0),
+      buffers_(nullptr),
+      buffers_size_(0),
+      buffer_stride_(0),
+      buf_tail_(0),
+      receive_armed_(false),
+      abort_poll_armed_(false) {
+  memset(&recv_msg_, 0, sizeof(recv_msg_));
+  memset(&stats_, 0, sizeof(stats_));
+}
+
+UringTransport::~UringTransport() { close(); }
+
+bool UringTransport::open(const UringOptions &options) {
+  close();
+  if (options.buffer_size < sizeof(PacketHeader) || options.num_buffers == 0 ||
+      options.num_buffers > kMaxBuffers || (options.num_buffers & (options.num_buffers - 1)) != 0 ||
+      options.send_slots == 0) {
+    errno = EINVAL;
+    return false;
+  }
+  options_ = options;
+  memset(&stats_, 0, sizeof(stats_));
+
+  bool ok = true;
+
+  // Socket
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(options.port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (options.bind_address && inet_pton(AF_INET, options.bind_address, &addr.sin_addr) != 1) {
+    errno = EINVAL;
+    return false;
+  }
+  // The abort lane needs a reuseport group of its own: with reuse_port the
+  // group is shared with other transports and the program would steer their
+  // traffic too
+  const bool abort_lane = options.abort_callback && !options.reuse_port;
+  socket_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  ok = socket_fd_ >= 0;
+  if (ok && (options.reuse_port || abort_lane)) {
+    const int one = 1;
+    ok = setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == 0;
+  }
+  if (ok && options.receive_buffer_bytes > 0) {
+    setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF, &options.receive_buffer_bytes,
+               sizeof(options.receive_buffer_bytes));
+  }
+  ok = ok && bind(socket_fd_, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) == 0;
+  if (ok) {
+    socklen_t length = sizeof(addr);
+    ok = getsockname(socket_fd_, reinterpret_cast<struct sockaddr *>(&addr), &length) == 0;
+    port_ = ntohs(addr.sin_port);
+  }
+  if (ok && abort_lane) open_abort_lane(addr.sin_addr.s_addr, port_);
+
+  // Ring: every send slot may need an SQE at once, plus the receive; the CQ
+  // must hold a completion for every buffer and slot or multishot stops
+  struct io_uring_params params;
+  if (ok) {
+    const unsigned sq_entries = next_power_of_two(options.send_slots + 2);
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = next_power_of_two(2 * (options.num_buffers + options.send_slots));
+    ring_fd_ = sys_io_uring_setup(sq_entries, &params);
+    if (ring_fd_ < 0 && errno == EINVAL) {
+      // Kernels before 6.1 lack the single-issuer flags
+      memset(&params, 0, sizeof(params));
+      params.flags = IORING_SETUP_CQSIZE;
+      params.cq_entries = next_power_of_two(2 * (options.num_buffers + options.send_slots));
+      ring_fd_ = sys_io_uring_setup(sq_entries, &params);
+    }
+    ok = ring_fd_ >= 0;
+  }
+
+  if (ok) {
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap && cq_map_size_ > sq_map_size_) sq_map_size_ = cq_map_size_;
+
+    void *map = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                     IORING_OFF_SQ_RING);
+    sq_map_ = map == MAP_FAILED ? nullptr : map;
+    if (sq_map_ && !single_mmap) {
+      map = mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                 IORING_OFF_CQ_RING);
+      cq_map_ = map == MAP_FAILED ? nullptr : map;
+    } else if (sq_map_) {
+      cq_map_ = sq_map_;
+      cq_map_size_ = 0; // Unmapped with the SQ ring
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    map = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    sqes_ = map == MAP_FAILED ? nullptr : static_cast<struct io_uring_sqe *>(map);
+    ok = sq_map_ && cq_map_ && sqes_;
+  }
+
+  if (ok) {
+    uint8_t *sq = static_cast<uint8_t *>(sq_map_);
+    uint8_t *cq = static_cast<uint8_t *>(cq_map_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_entries_ = params.sq_entries;
+    sq_local_tail_ = *sq_tail_;
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  }
+
+  // Provided receive buffers. Each holds the io_uring_recvmsg_out header, the
+  // source address and the payload, rounded up to a cache line
+  if (ok) {
+    buffer_stride_ = sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in) + options.buffer_size;
+    buffer_stride_ = (buffer_stride_ + DIABLO_CACHE_LINE_SIZE - 1) & ~static_cast<size_t>(DIABLO_CACHE_LINE_SIZE - 1);
+    buffers_size_ = buffer_stride_ * options.num_buffers;
+    buf_ring_size_ = sizeof(struct io_uring_buf) * options.num_buffers;
+    buffers_ = static_cast<uint8_t *>(map_anonymous(buffers_size_));
+    buf_ring_ = map_anonymous(buf_ring_size_);
+    ok = buffers_ && buf_ring_;
+  }
+  if (ok) {
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = static_cast<uint32_t>(options.num_buffers);
+    reg.bgid = kBufferGroup;
+    ok = sys_io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+  }
+  if (ok) {
+    buf_tail_ = 0;
+    for (size_t i = 0; i < options.num_buffers; ++i) recycle_buffer(static_cast<uint16_t>(i));
+    publish_buffers();
+
+    recv_msg_.msg_namelen = sizeof(struct sockaddr_in);
+    ok = arm_receive() && (abort_fd_ < 0 || arm_abort_poll()) && submit();
+  }
+
+  if (ok) {
+    for (size_t i = 0; i < options.send_slots; ++i) {
+      SendSlot *slot = new SendSlot();
+      slot->index = i;
+      slot->data.resize(options.buffer_size);
+      memset(&slot->msg, 0, sizeof(slot->msg));
+      memset(&slot->dest, 0, sizeof(slot->dest));
+      slot->dest.sin_family = AF_INET;
+      slot->iov.iov_base = slot->data.data();
+      slot->msg.msg_name = &slot->dest;
+      slot->msg.msg_namelen = sizeof(slot->dest);
+      slot->msg.msg_iov = &slot->iov;
+      slot->msg.msg_iovlen = 1;
+      send_slots_.push_back(slot);
+    }
+    // Hand out low slots first
+    for (size_t i = send_slots_.size(); i > 0; --i) free_slots_.push_back(send_slots_[i - 1]);
+  }
+
+  if (!ok) {
+    const int saved = errno;
+    close();
+    errno = saved;
+  }
+  return ok;
+}
+
+void UringTransport::close() {
+  // Closing the ring cancels the receive and any sends still in flight
+  if (ring_fd_ >= 0) ::close(ring_fd_);
+  if (socket_fd_ >= 0) ::close(socket_fd_);
+  if (abort_fd_ >= 0) ::close(abort_fd_);
+  if (sqes_) munmap(sqes_, sqes_size_);
+  if (cq_map_ && cq_map_ != sq_map_) munmap(cq_map_, cq_map_size_);
+  if (sq_map_) munmap(sq_map_, sq_map_size_);
+  if (buf_ring_) munmap(buf_ring_, buf_ring_size_);
+  if (buffers_) munmap(buffers_, buffers_size_);
+  for (size_t i = 0; i < send_slots_.size(); ++i) delete send_slots_[i];
+
+  ring_fd_ = -1;
+  socket_fd_ = -1;
+  abort_fd_ = -1;
+  sqes_ = nullptr;
+  cq_map_ = nullptr;
+  sq_map_ = nullptr;
+  buf_ring_ = nullptr;
+  buffers_ = nullptr;
+  send_slots_.clear();
+  free_slots_.clear();
+  boards_.clear();
+  receive_armed_ = false;
+  abort_poll_armed_ = false;
+}
+
+// Joins the main socket's reuseport group as socket 1 and steers abort-lane
+// packets to it. Without the program the lane would only take a share of
+// the bulk traffic, so it is closed again.
+void UringTransport::open_abort_lane(uint32_t address, uint16_t port) {
+  const int one = 1;
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = address;
+  addr.sin_port = htons(port);
+  abort_fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (abort_fd_ < 0) return;
+  if (setsockopt(abort_fd_, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0 ||
+      bind(abort_fd_, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      !attach_shard_program(socket_fd_, 1, true)) {
+    ::close(abort_fd_);
+    abort_fd_ = -1;
+  }
+}
+
+struct io_uring_sqe *UringTransport::next_sqe() {
+  if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    // Full: let the kernel consume what is queued
+    enter(0, 0, 0);
+    if (sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) return nullptr;
+  }
+  const unsigned index = sq_local_tail_ & sq_mask_;
+  struct io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  ++sq_local_tail_;
+  return sqe;
+}
+
+bool UringTransport::arm_receive() {
+  struct io_uring_sqe *sqe = next_sqe();
+  if (!sqe) return false;
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = socket_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(&recv_msg_);
+  sqe->len = 1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = kBufferGroup;
+  sqe->user_data = kReceiveTag;
+  receive_armed_ = true;
+  return true;
+}
+
+// Completes whenever the abort lane socket becomes readable, so a blocked
+// poll() wakes for an abort even with no other traffic
+bool UringTransport::arm_abort_poll() {
+  struct io_uring_sqe *sqe = next_sqe();
+  if (!sqe) return false;
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = abort_fd_;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = kAbortPollTag;
+  abort_poll_armed_ = true;
+  return true;
+}
+
+// The ring is addressed as a plain io_uring_buf array: in C++ the flexible
+// array in struct io_uring_buf_ring lands 8 bytes too far in. Its tail
+// overlays the resv field of the first entry.
+void UringTransport::recycle_buffer(uint16_t id) {
+  struct io_uring_buf &buf = static_cast<struct io_uring_buf *>(buf_ring_)[buf_tail_ & (options_.num_buffers - 1)];
+  buf.addr = reinterpret_cast<uint64_t>(buffers_ + static_cast<size_t>(id) * buffer_stride_);
+  buf.len = static_cast<uint32_t>(buffer_stride_);
+  buf.bid = id;
+  ++buf_tail_;
+}
+
+void UringTransport::publish_buffers() {
+  __atomic_store_n(&static_cast<struct io_uring_buf *>(buf_ring_)->resv, buf_tail_, __ATOMIC_RELEASE);
+}
+
+int UringTransport::enter(unsigned min_complete, unsigned flags, int timeout_ms) {
+  __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+  const unsigned to_submit = sq_local_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg arg;
+  const void *arg_ptr = nullptr;
+  size_t arg_size = 0;
+  if (min_complete && timeout_ms > 0) {
+    ts.tv_sec = timeout_ms / 1000;
+    ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    arg_ptr = &arg;
+    arg_size = sizeof(arg);
+    flags |= IORING_ENTER_EXT_ARG;
+  }
+
+  // GETEVENTS is always set: with DEFER_TASKRUN completions are only
+  // posted while the issuer is inside io_uring_enter()
+  const int rc = sys_io_uring_enter(ring_fd_, to_submit, min_complete, flags | IORING_ENTER_GETEVENTS, arg_ptr,
+                                    arg_size);
+  if (rc < 0 && (errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY)) return 0;
+  return rc;
+}
+
+bool UringTransport::submit() {
+  if (ring_fd_ < 0) return false;
+  return enter(0, 0, 0) >= 0;
+}
+
+UringTransport::SendSlot *UringTransport::acquire_slot() {
+  if (ring_fd_ < 0 || free_slots_.empty()) return nullptr;
+  SendSlot *slot = free_slots_.back();
+  free_slots_.pop_back();
+  return slot;
+}
+
+bool UringTransport::queue_slot(SendSlot *slot, size_t size, uint32_t dest_ip, uint16_t dest_port) {
+  struct io_uring_sqe *sqe = size ? next_sqe() : nullptr;
+  if (!sqe) {
+    free_slots_.push_back(slot);
+    return false;
+  }
+  slot->iov.iov_len = size;
+  slot->dest.sin_addr.s_addr = dest_ip;
+  slot->dest.sin_port = htons(dest_port);
+
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = socket_fd_;
+  sqe->addr = reinterpret_cast<uint64_t>(&slot->msg);
+  sqe->len = 1;
+  sqe->user_data = slot->index;
+  return true;
+}
+
+bool UringTransport::queue_send(const uint8_t *packet, size_t size, uint32_t dest_ip, uint16_t dest_port) {
+  if (!packet || size > options_.buffer_size) return false;
+  SendSlot *slot = acquire_slot();
+  if (!slot) return false;
+  memcpy(slot->data.data(), packet, size);
+  return queue_slot(slot, size, dest_ip, dest_port);
+}
+
+bool UringTransport::queue_actuator_command(const std::vector<ActuatorCommand> &commands, uint32_t timestamp_ms,
+                                            uint32_t dest_ip, uint16_t dest_port) {
+  SendSlot *slot = acquire_slot();
+  if (!slot) return false;
+  const size_t size = create_actuator_command_packet(commands, timestamp_ms, slot->data.data(), slot->data.size());
+  return queue_slot(slot, size, dest_ip, dest_port);
+}
+
+bool UringTransport::queue_pwm_actuator_command(const std::vector<PWMActuatorCommand> &commands,
+                                                uint32_t timestamp_ms, uint32_t dest_ip, uint16_t dest_port) {
+  SendSlot *slot = acquire_slot();
+  if (!slot) return false;
+  const size_t size = create_pwm_actuator_packet(commands, timestamp_ms, slot->data.data(), slot->data.size());
+  return queue_slot(slot, size, dest_ip, dest_port);
+}
+
+bool UringTransport::send_abort(PacketType type, uint32_t timestamp_ms, uint32_t dest_ip, uint16_t dest_port) {
+  uint8_t packet[sizeof(PacketHeader)];
+  const size_t size = create_abort_lane_packet(type, timestamp_ms, packet, sizeof(packet));
+  if (socket_fd_ < 0 || size == 0) return false;
+
+  // The lane socket's send queue never holds bulk traffic
+  const int fd = abort_fd_ >= 0 ? abort_fd_ : socket_fd_;
+  struct sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = dest_ip;
+  dest.sin_port = htons(dest_port);
+  if (sendto(fd, packet, size, 0, reinterpret_cast<const struct sockaddr *>(&dest), sizeof(dest)) !=
+      static_cast<ssize_t>(size)) {
+    return false;
+  }
+  ++stats_.abort_sends;
+  return true;
+}
+
+const uint8_t *UringTransport::received_payload(const struct io_uring_cqe &cqe, size_t &size, uint32_t &source_ip,
+                                                bool &truncated) const {
+  if (cqe.user_data != kReceiveTag || cqe.res < 0 || !(cqe.flags & IORING_CQE_F_BUFFER)) return nullptr;
+
+  const uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+  const uint8_t *buffer = buffers_ + static_cast<size_t>(id) * buffer_stride_;
+  struct io_uring_recvmsg_out out;
+  memcpy(&out, buffer, sizeof(out));
+  struct sockaddr_in source;
+  memcpy(&source, buffer + sizeof(out), sizeof(source));
+  size = out.payloadlen < options_.buffer_size ? out.payloadlen : options_.buffer_size;
+  source_ip = source.sin_addr.s_addr;
+  // The kernel only sets MSG_TRUNC past the end of the provided buffer, which
+  // is rounded up to a cache line: anything over buffer_size counts
+  truncated = (out.flags & MSG_TRUNC) != 0 || out.payloadlen > options_.buffer_size;
+  return buffer + sizeof(out) + recv_msg_.msg_namelen + recv_msg_.msg_controllen;
+}
+
+// Abort-lane packets that came in on the main socket (no lane socket)
+bool UringTransport::in_abort_lane(const uint8_t *payload, size_t size, bool truncated) const {
+  return options_.abort_callback && abort_fd_ < 0 && !truncated && is_abort_lane_packet(payload, size);
+}
+
+size_t UringTransport::drain_abort_lane() {
+  uint8_t packet[MAX_PACKET_SIZE];
+  size_t received = 0;
+  for (;;) {
+    struct sockaddr_in source;
+    socklen_t length = sizeof(source);
+    // MSG_TRUNC returns the full datagram length, so truncation shows
+    const ssize_t rc = recvfrom(abort_fd_, packet, sizeof(packet), MSG_DONTWAIT | MSG_TRUNC,
+                                reinterpret_cast<struct sockaddr *>(&source), &length);
+    if (rc < 0) break; // Empty (EAGAIN)
+    const size_t size = static_cast<size_t>(rc) < sizeof(packet) ? static_cast<size_t>(rc) : sizeof(packet);
+    const uint32_t source_ip = source.sin_addr.s_addr;
+    ++received;
+    stats_.bytes += size;
+    const DispatchResult result =
+        static_cast<size_t>(rc) > sizeof(packet)
+            ? DispatchResult::MALFORMED
+            : dispatch_abort_packet(packet, size, source_ip, options_.abort_callback, options_.abort_context,
+                                    options_.track_sequences ? &boards_[source_ip] : nullptr, options_.require_crc);
+    if (result == DispatchResult::OK) {
+      ++stats_.aborts;
+    } else {
+      ++stats_.rejected;
+    }
+  }
+  return received;
+}
+
+size_t UringTransport::poll(IngestHandler &handler, int timeout_ms) {
+  if (ring_fd_ < 0) return 0;
+  if (!receive_armed_) arm_receive();
+  if (abort_fd_ >= 0 && !abort_poll_armed_) arm_abort_poll();
+
+  const bool have_completions = *cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  enter(timeout_ms != 0 && !have_completions ? 1 : 0, 0, timeout_ms);
+
+  const unsigned first = *cq_head_;
+  const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  size_t size;
+  uint32_t source_ip;
+  bool truncated;
+
+  // Abort lane first: its socket is drained before any bulk completion is
+  // looked at. Without it, a cheap first-byte scan picks abort-lane packets
+  // out of everything reaped.
+  size_t datagrams = abort_fd_ >= 0 ? drain_abort_lane() : 0;
+  if (options_.abort_callback && abort_fd_ < 0) {
+    for (unsigned head = first; head != tail; ++head) {
+      const uint8_t *payload = received_payload(cqes_[head & cq_mask_], size, source_ip, truncated);
+      if (!payload || !in_abort_lane(payload, size, truncated)) continue;
+      const DispatchResult result =
+          dispatch_abort_packet(payload, size, source_ip, options_.abort_callback, options_.abort_context,
+                                options_.track_sequences ? &boards_[source_ip] : nullptr, options_.require_crc);
+      if (result == DispatchResult::OK) {
+        ++stats_.aborts;
+      } else {
+        ++stats_.rejected;
+      }
+    }
+  }
+
+  unsigned head = first;
+  for (; head != tail; ++head) {
+    const struct io_uring_cqe &cqe = cqes_[head & cq_mask_];
+
+    // A large batch takes a while to dispatch; aborts that arrive meanwhile
+    // must not wait for the next poll()
+    if (abort_fd_ >= 0 && head != first && (head - first) % kAbortLaneInterval == 0) datagrams += drain_abort_lane();
+    if (cqe.user_data == kAbortPollTag) { // Only wakes the ring; drained above
+      if (!(cqe.flags & IORING_CQE_F_MORE)) abort_poll_armed_ = false;
+      continue;
+    }
+    if (cqe.user_data != kReceiveTag) {
+      SendSlot *slot = send_slots_[cqe.user_data];
+      free_slots_.push_back(slot);
+      if (cqe.res < 0) {
+        ++stats_.send_errors;
+      } else {
+        ++stats_.sends;
+      }
+      continue;
+    }
+
+    if (!(cqe.flags & IORING_CQE_F_MORE)) receive_armed_ = false;
+    if (cqe.res < 0) {
+      if (cqe.res == -ENOBUFS) ++stats_.overruns;
+      continue;
+    }
+    const uint8_t *payload = received_payload(cqe, size, source_ip, truncated);
+    if (!payload) continue;
+
+    ++datagrams;
+    stats_.bytes += size;
+    if (!in_abort_lane(payload, size, truncated)) { // Those were delivered above
+      handler.on_datagram(source_ip, size);
+      if (truncated) {
+        handler.on_reject(DispatchResult::MALFORMED, payload, size);
+        ++stats_.rejected;
+      } else {
+        const DispatchResult result =
+            dispatch_packet(payload, size, handler, options_.track_sequences ? &boards_[source_ip] : nullptr,
+                            options_.require_crc);
+        if (result != DispatchResult::OK) ++stats_.rejected;
+      }
+    }
+    recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  publish_buffers();
+  stats_.datagrams += datagrams;
+
+  // Multishot stops when buffers run out or the CQ overflows; buffers are
+  // back in the ring now, so re-arm right away
+  if (!receive_armed_ && arm_receive()) {
+    ++stats_.rearms;
+    submit();
+  }
+  if (abort_fd_ >= 0 && !abort_poll_armed_ && arm_abort_poll()) submit();
+  if (datagrams) handler.on_batch_end();
+  return datagrams;
+}
+
+} // namespace Diablo
+
+#endif // __linux__ && DIABLO_COMMS_ENABLE_IO_URING
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "DiabloAbortLane.h" // For AbortCallback
+#include "DiabloConfig.h"    // For MAX_PACKET_SIZE
+#include "DiabloIngest.h"    // For IngestHandler
+#include "DiabloPackets.h"   // For ActuatorCommand, PWMActuatorCommand
+#include <stddef.h>          // For size_t
+#include <stdint.h>          // For standard integer types
+
+//==============================================================================
+// IO_URING UDP TRANSPORT (Linux hosts only, opt-in)
+//
+// Alternative to the recvmmsg() loop of IngestServer for ground stations
+// where per-datagram syscall cost dominates. Build with
+// -DDIABLO_COMMS_ENABLE_IO_URING (needs Linux 6.0+ headers and kernel for
+// multishot IORING_OP_RECVMSG); the ring is driven with raw syscalls, no
+// liburing.
+//
+// Receive: one multishot IORING_OP_RECVMSG stays armed on the socket and the
+// kernel picks buffers from a provided-buffer ring, so a steady stream of
+// datagrams needs no SQEs at all. poll() reaps completions, hands each
+// datagram to dispatch_packet() and returns its buffer to the ring.
+//
+// Send: command packets are serialized straight into preallocated send slots
+// (create_actuator_command_packet() / create_pwm_actuator_packet()) and
+// queued as IORING_OP_SENDMSG; queued sends go to the kernel with the next
+// submit() or poll(), together with any other pending work.
+//
+// Abort lane (see DiabloAbortLane.h): with an abort callback, a second socket
+// joins the port with SO_REUSEPORT and IngestServer's BPF program steers
+// every abort-lane packet to it, so aborts never queue behind Sensor Data in
+// the main socket or the buffer ring. A multishot poll on that socket wakes
+// the ring, and poll() drains it before touching any other completion.
+// send_abort() writes straight to that socket instead of waiting for a slot.
+// With reuse_port (the group is shared with other transports) or without the
+// BPF program, abort-lane packets stay on the main socket and are only picked
+// out of each completion batch ahead of the rest of it.
+//
+// Not thread-safe: one transport per thread, and it must be opened on the
+// thread that polls it (the ring is set up single-issuer). Several
+// transports can share a port with reuse_port, as IngestServer shards do.
+//==============================================================================
+
+#if defined(__linux__) && defined(DIABLO_COMMS_ENABLE_IO_URING)
+
+#include <unordered_map> // For std::unordered_map
+#include <vector>        // For std::vector
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+namespace Diablo {
+
+struct UringOptions {
+  const char *bind_address;     // Dotted IPv4 address (nullptr = any)
+  uint16_t port;                // 0 = pick a free port (see UringTransport::port())
+  bool reuse_port;              // Set SO_REUSEPORT before binding
+  size_t buffer_size;           // Payload bytes per receive buffer and send slot
+  size_t num_buffers;           // Receive buffers (power of two, at most 32768)
+  size_t send_slots;            // Sends that may be in flight at once
+  int receive_buffer_bytes;     // SO_RCVBUF (0 = system default)
+  bool track_sequences;         // Drop duplicate packets per board (never abort-lane packets)
+  bool require_crc;             // Reject packets without a CRC-32C trailer
+  AbortCallback abort_callback; // Gets abort-lane packets instead of the handler (nullptr = none)
+  void *abort_context;          // Passed to abort_callback
+
+  // A full Sensor Data packet with both trailers (554 bytes) is larger than
+  // MAX_PACKET_SIZE, so buffers default to twice that
+  UringOptions()
+      : bind_address(nullptr),
+        port(0),
+        reuse_port(false),
+        buffer_size(2 * MAX_PACKET_SIZE),
+        num_buffers(1024),
+        send_slots(256),
+        receive_buffer_bytes(4 << 20),
+        track_sequences(true),
+        require_crc(DIABLO_COMMS_REQUIRE_CRC32C),
+        abort_callback(nullptr),
+        abort_context(nullptr) {}
+};
+
+struct UringStats {
+  uint64_t datagrams;   // Datagrams received
+  uint64_t bytes;       // Bytes received
+  uint64_t rejected;    // Datagrams dispatch_packet() rejected (or truncated)
+  uint64_t overruns;    // Times the kernel ran out of receive buffers
+  uint64_t rearms;      // Multishot receives re-armed
+  uint64_t sends;       // Sends completed
+  uint64_t send_errors; // Sends that failed
+  uint64_t aborts;      // Abort-lane packets delivered to the abort callback
+  uint64_t abort_sends; // Abort-lane packets sent with send_abort()
+};
+
+/**
+ * @brief UDP socket driven through io_uring.
+ *
+ * Typical use:
+ * @code
+ *   UringTransport transport;
+ *   UringOptions options;
+ *   options.port = ground_port;
+ *   transport.open(options);
+ *   while (running) {
+ *     transport.poll(handler, 10);
+ *     if (valve_change) transport.queue_actuator_command(commands, now_ms, board_ip, board_port);
+ *   }
+ * @endcode
+ */
+class UringTransport {
+ public:
+  UringTransport();
+  ~UringTransport();
+
+  /**
+   * @brief Bind the socket, set up the ring and arm the multishot receive.
+   * @return false on bad options or if the kernel lacks io_uring support
+   * (errno is left set).
+   */
+  bool open(const UringOptions &options);
+  void close();
+
+  /**
+   * @brief Submit queued work, then dispatch every received datagram.
+   * @param handler Receives the datagrams (on_datagram(), then the typed
+   * callback); on_batch_end() follows if any arrived.
+   * @param timeout_ms How long to wait for the first completion (-1 =
+   * forever, 0 = do not wait).
+   * @return The number of datagrams dispatched.
+   */
+  size_t poll(IngestHandler &handler, int timeout_ms);
+
+  /**
+   * @brief Queue an already serialized packet for sending.
+   * @param dest_ip IPv4 destination as in sockaddr_in.sin_addr.s_addr.
+   * @param dest_port Destination port (host byte order).
+   * @return false if it does not fit a send slot or every slot is in flight.
+   */
+  bool queue_send(const uint8_t *packet, size_t size, uint32_t dest_ip, uint16_t dest_port);
+
+  /**
+   * @brief Serialize an Actuator Command packet into a send slot and queue it.
+   */
+  bool queue_actuator_command(const std::vector<ActuatorCommand> &commands, uint32_t timestamp_ms,
+                              uint32_t dest_ip, uint16_t dest_port);
+
+  /**
+   * @brief Serialize a PWM Actuator Command packet into a send slot and queue it.
+   */
+  bool queue_pwm_actuator_command(const std::vector<PWMActuatorCommand> &commands, uint32_t timestamp_ms,
+                                  uint32_t dest_ip, uint16_t dest_port);
+
+  /**
+   * @brief Send a header-only abort-lane packet right away.
+   *
+   * Bypasses the send slots and the submission queue (a plain sendto()), so
+   * it never waits behind queued commands and works with every slot in
+   * flight.
+   *
+   * @param type ABORT, ABORT_DONE, CLEAR_ABORT or NO_CONNECTION_ABORT.
+   * @return false if type is not an abort-lane type or the send failed.
+   */
+  bool send_abort(PacketType type, uint32_t timestamp_ms, uint32_t dest_ip, uint16_t dest_port);
+
+  /**
+   * @brief Hand queued sends to the kernel without reaping completions.
+   * @return false on a submission error.
+   */
+  bool submit();
+
+  bool is_open() const { return ring_fd_ >= 0; }
+  int socket_fd() const { return socket_fd_; }
+
+  /**
+   * @brief Whether abort-lane packets arrive on their own socket (needs an
+   * abort callback, no reuse_port and the BPF program).
+   */
+  bool has_abort_lane() const { return abort_fd_ >= 0; }
+
+  uint16_t port() const { return port_; }
+  size_t sends_in_flight() const { return send_slots_.size() - free_slots_.size(); }
+  const UringStats &stats() const { return stats_; }
+
+ private:
+  UringTransport(const UringTransport &);
+  UringTransport &operator=(const UringTransport &);
+
+  struct SendSlot;
+
+  SendSlot *acquire_slot();
+  bool queue_slot(SendSlot *slot, size_t size, uint32_t dest_ip, uint16_t dest_port);
+  struct io_uring_sqe *next_sqe();
+  const uint8_t *received_payload(const struct io_uring_cqe &cqe, size_t &size, uint32_t &source_ip,
+                                  bool &truncated) const;
+  bool in_abort_lane(const uint8_t *payload, size_t size, bool truncated) const;
+  void open_abort_lane(uint32_t address, uint16_t port);
+  size_t drain_abort_lane();
+  bool arm_receive();
+  bool arm_abort_poll();
+  void recycle_buffer(uint16_t id);
+  void publish_buffers();
+  int enter(unsigned min_complete, unsigned flags, int timeout_ms);
+
+  UringOptions options_;
+  int socket_fd_;
+  int abort_fd_; // Abort lane socket, or -1
+  int ring_fd_;
+  uint16_t port_;
+
+  // Ring mappings
+  void *sq_map_;
+  size_t sq_map_size_;
+  void *cq_map_;
+  size_t cq_map_size_;
+  struct io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_array_;
+  unsigned sq_mask_;
+  unsigned sq_entries_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  struct io_uring_cqe *cqes_;
+  unsigned cq_mask_;
+  unsigned sq_local_tail_; // SQEs up to here are written; the kernel sees them at the next enter()
+
+  // Provided receive buffers
+  void *buf_ring_;
+  size_t buf_ring_size_;
+  uint8_t *buffers_;
+  size_t buffers_size_;
+  size_t buffer_stride_; // recvmsg header + source address + payload
+  uint16_t buf_tail_;
+  struct msghdr recv_msg_; // Template for the multishot receive
+  bool receive_armed_;
+  bool abort_poll_armed_;
+
+  std::vector<SendSlot *> send_slots_;
+  std::vector<SendSlot *> free_slots_;
+
+  std::unordered_map<uint32_t, BoardSequenceTracker> boards_;
+  UringStats stats_;
+};
+
+} // namespace Diablo
+
+#endif // __linux__ && DIABLO_COMMS_ENABLE_IO_URING